@@ -0,0 +1,499 @@
+#include "ai_driver.h"
+#include <algorithm>
+#include <cmath>
+
+static std::uint32_t mixHash(std::uint32_t seed, std::uint64_t a, std::uint64_t b) {
+    std::uint64_t h = seed * 0x9E3779B97F4A7C15ull ^ a * 0xBF58476D1CE4E5B9ull ^ b * 0x94D049BB133111EBull;
+    h ^= h >> 31;
+    h *= 0xD6E8FEB86659FD93ull;
+    h ^= h >> 32;
+    return static_cast<std::uint32_t>(h);
+}
+
+static void clearPlan(AiDriver& driver) {
+    driver.route.reset();
+    driver.waypointX.clear();
+    driver.waypointY.clear();
+    driver.waypointLane.clear();
+    driver.nextWaypoint = 0;
+    driver.station = -1;
+}
+
+// Where a car is on the road graph: the edge it is on, the nearest point of that edge and
+// the node it is driving toward
+struct RoadPosition {
+    std::uint32_t edge = 0;
+    std::uint32_t point = 0;                  // Index within the edge
+    std::uint32_t ahead = NO_ROAD_NODE;
+};
+
+static RoadPosition locateOnRoad(const RoadGraph& graph, const Fleet& fleet, size_t vehicle, NeighbourQuery& query) {
+    RoadPosition position;
+    if (!nearestEdgePoint(graph, fleet.positionX[vehicle], fleet.positionY[vehicle], query, position.edge, position.point))
+        return position;
+
+    // The end of the edge the car is facing
+    const RoadEdge& edge = graph.edges[position.edge];
+    std::uint32_t ahead = edge.firstPoint + std::min(position.point + 1, edge.pointCount - 1);
+    std::uint32_t behind = edge.firstPoint + (position.point > 0 ? position.point - 1 : 0);
+    float angleRadians = fleet.angle[vehicle] * 3.14159f / 180.f;
+    float along = (graph.pointX[ahead] - graph.pointX[behind]) * std::cos(angleRadians)
+        + (graph.pointY[ahead] - graph.pointY[behind]) * std::sin(angleRadians);
+    position.ahead = along >= 0.f ? edge.to : edge.from;
+    return position;
+}
+
+// True if the car body can drive the straight line between two points keeping `margin` from the edge
+static bool segmentFits(const DistanceField& field, float fromX, float fromY, float toX, float toY, float margin) {
+    float dx = toX - fromX, dy = toY - fromY;
+    float length = std::sqrt(dx * dx + dy * dy);
+    if (length <= 0.f)
+        return bodyClearance(field, fromX, fromY, 1.f, 0.f) >= margin;
+    int steps = static_cast<int>(length / AI_LANE_STEP) + 1;
+    for (int i = 0; i <= steps; ++i) {
+        float t = static_cast<float>(i) / steps;
+        if (bodyClearance(field, fromX + dx * t, fromY + dy * t, dx / length, dy / length) < margin)
+            return false;
+    }
+    return true;
+}
+
+// An edge driven in one direction
+static std::uint32_t roadLane(std::uint32_t edge, bool forward) {
+    return edge * 2 + (forward ? 0 : 1);
+}
+
+// Waypoints for the rest of the current edge followed by the route from the node ahead
+static void followRoute(const AiTraffic& traffic, const RoadPosition& position, AiDriver& driver) {
+    const RoadGraph& graph = *traffic.graph;
+    driver.waypointX.clear();
+    driver.waypointY.clear();
+    driver.waypointLane.clear();
+    driver.nextWaypoint = 0;
+
+    std::vector<std::uint32_t> points;
+    const RoadEdge& current = graph.edges[position.edge];
+    if (position.ahead == current.to) {
+        for (std::uint32_t i = position.point + 1; i < current.pointCount; ++i)
+            points.push_back(current.firstPoint + i);
+    }
+    else {
+        for (std::uint32_t i = position.point; i-- > 0;)
+            points.push_back(current.firstPoint + i);
+    }
+    driver.waypointLane.assign(points.size(), roadLane(position.edge, position.ahead == current.to));
+
+    std::uint32_t node = driver.route->from;
+    for (std::uint32_t e : driver.route->edges) {
+        const RoadEdge& edge = graph.edges[e];
+        bool forward = edge.from == node;
+        // Skip each edge's first point; it is the node the previous edge ended on
+        for (std::uint32_t i = 1; i < edge.pointCount; ++i)
+            points.push_back(edge.firstPoint + (forward ? i : edge.pointCount - 1 - i));
+        driver.waypointLane.resize(points.size(), roadLane(e, forward));
+        node = otherRoadNode(edge, node);
+    }
+
+    // Keep right of the middle of the road so cars coming the other way pass instead of
+    // meeting head-on. Where the road is too narrow the point moves across until the car fits.
+    // Through bends cars take the outside line instead: turning from the inside is tighter
+    // than a car can steer.
+    const size_t span = static_cast<size_t>(AI_BEND_SPAN / (ROAD_GRAPH_CELL * ROAD_GRAPH_POINT_STEP)) + 1;
+    auto direction = [&](size_t from, size_t to) {
+        float dx = graph.pointX[points[to]] - graph.pointX[points[from]];
+        float dy = graph.pointY[points[to]] - graph.pointY[points[from]];
+        float length = std::sqrt(dx * dx + dy * dy);
+        return length > 0.f ? sf::Vector2f(dx / length, dy / length) : sf::Vector2f();
+    };
+    for (size_t i = 0; i < points.size(); ++i) {
+        float x = graph.pointX[points[i]], y = graph.pointY[points[i]];
+        sf::Vector2f before = direction(i > span ? i - span : 0, i);
+        sf::Vector2f after = direction(i, std::min(i + span, points.size() - 1));
+        sf::Vector2f along = direction(i > 0 ? i - 1 : 0, std::min(i + 1, points.size() - 1));
+        bool bend = (before.x != 0.f || before.y != 0.f) && (after.x != 0.f || after.y != 0.f)
+            && before.x * after.x + before.y * after.y < AI_BEND_COSINE;
+        float lane = bend ? 0.f : AI_LANE_OFFSET;
+
+        // The straight run from the previous waypoint has to fit too, or the car scrapes
+        // the corner between them
+        if (along.x != 0.f || along.y != 0.f) {
+            for (float offset = lane; offset >= -AI_LANE_OFFSET; offset -= AI_LANE_STEP) {
+                float laneX = x - along.y * offset, laneY = y + along.x * offset;
+                if (i == 0 || segmentFits(traffic.roads->distance, driver.waypointX.back(), driver.waypointY.back(), laneX, laneY, AI_LANE_MARGIN)) {
+                    x = laneX;
+                    y = laneY;
+                    break;
+                }
+            }
+        }
+        driver.waypointX.push_back(x);
+        driver.waypointY.push_back(y);
+    }
+
+    if (driver.station >= 0) {
+        driver.waypointX.push_back(graph.stations[driver.station].x);
+        driver.waypointY.push_back(graph.stations[driver.station].y);
+        driver.waypointLane.push_back(driver.waypointLane.empty() ? NO_ROAD_LANE : driver.waypointLane.back());
+    }
+}
+
+static void planTrip(AiTraffic& traffic, const Fleet& fleet, AiDriver& driver, std::uint64_t tick) {
+    const RoadGraph& graph = *traffic.graph;
+    clearPlan(driver);
+    RoadPosition position = locateOnRoad(graph, fleet, driver.vehicle, traffic.nearby);
+    if (position.ahead == NO_ROAD_NODE)
+        return;
+
+    float x = fleet.positionX[driver.vehicle];
+    float y = fleet.positionY[driver.vehicle];
+    std::uint32_t destination[AI_DESTINATION_TRIES];
+    std::uint32_t tries = AI_DESTINATION_TRIES;
+    if (fleet.fuel[driver.vehicle] < AI_LOW_FUEL && !graph.stations.empty()) {
+        // The station in the nearest fuel zone, or the nearest station as the crow flies if
+        // that zone is too tight to hold one
+        std::uint32_t zone = nearestFuelZone(traffic.roads->zones, x, y);
+        if (zone != NO_SURFACE_ZONE)
+            driver.station = traffic.zoneStation[zone];
+        if (driver.station < 0) {
+            float best = 0.f;
+            for (size_t i = 0; i < graph.stations.size(); ++i) {
+                float dx = graph.stations[i].x - x, dy = graph.stations[i].y - y;
+                if (driver.station < 0 || dx * dx + dy * dy < best) {
+                    driver.station = static_cast<int>(i);
+                    best = dx * dx + dy * dy;
+                }
+            }
+        }
+        destination[0] = graph.stations[driver.station].node;
+        tries = 1;
+    }
+    else {
+        for (std::uint32_t attempt = 0; attempt < tries; ++attempt)
+            destination[attempt] = mixHash(traffic.seed + attempt, driver.vehicle, tick) % graph.nodes.size();
+    }
+
+    // Roads are too narrow to turn around on, so the car carries on to the node it is facing.
+    // Prefer a route that doesn't lead straight back down the same road.
+    std::shared_ptr<const Route> fallback;
+    bool turnsBack = false;
+    for (std::uint32_t attempt = 0; attempt < tries; ++attempt) {
+        std::shared_ptr<const Route> route = planRoute(traffic.planner, position.ahead, destination[attempt]);
+        if (!route->found)
+            continue;
+        turnsBack = !route->edges.empty() && route->edges.front() == position.edge;
+        if (!turnsBack || !fallback)
+            fallback = route;
+        if (!turnsBack)
+            break;
+    }
+
+    // Every candidate turns back: take another road out of the node for now and plan the
+    // real trip from its far end. Only a dead end makes the car turn around.
+    const RoadNode& node = graph.nodes[position.ahead];
+    if (turnsBack && node.linkCount > 1) {
+        std::uint32_t pick = mixHash(traffic.seed, driver.vehicle, tick) % (node.linkCount - 1);
+        for (std::uint32_t i = 0; i < node.linkCount; ++i) {
+            std::uint32_t edge = graph.links[node.firstLink + i];
+            if (edge == position.edge || pick-- > 0)
+                continue;
+            std::shared_ptr<const Route> route = planRoute(traffic.planner, position.ahead, otherRoadNode(graph.edges[edge], position.ahead));
+            if (route->found && !route->edges.empty() && route->edges.front() != position.edge) {
+                fallback = route;
+                driver.station = -1;
+            }
+            break;
+        }
+    }
+    if (!fallback) {
+        driver.station = -1;
+        return;
+    }
+
+    driver.route = fallback;
+    followRoute(traffic, position, driver);
+}
+
+static float wrapDegrees(float degrees) {
+    degrees = std::fmod(degrees + 180.f, 360.f);
+    if (degrees < 0.f)
+        degrees += 360.f;
+    return degrees - 180.f;
+}
+
+// Distance to the nearest car in the way. A car in the lane ahead always counts. Where two
+// cars meet at a junction the lower vehicle index goes first, so the other one also gives
+// way to any such car close in front of it whatever lane it is in. `yielding` is set when
+// the nearest car in the way has the right of way.
+static float trafficGap(AiTraffic& traffic, const Fleet& fleet, size_t vehicle, bool& yielding) {
+    float gap = AI_FOLLOW_DISTANCE;
+    yielding = false;
+    if (fleet.neighbours.bucketStart.empty())
+        return gap;
+
+    float x = fleet.positionX[vehicle], y = fleet.positionY[vehicle];
+    float angleRadians = fleet.angle[vehicle] * 3.14159f / 180.f;
+    float axisX = std::cos(angleRadians), axisY = std::sin(angleRadians);
+    queryNeighbours(fleet.neighbours, x, y, AI_FOLLOW_DISTANCE, traffic.nearby);
+    for (std::uint32_t other : traffic.nearby.found) {
+        if (other == vehicle || other >= fleetSize(fleet))
+            continue;
+        float dx = fleet.positionX[other] - x, dy = fleet.positionY[other] - y;
+        float along = dx * axisX + dy * axisY;
+        float across = dx * axisY - dy * axisX;
+        bool inLane = std::abs(across) < CAR_WIDTH;
+        bool giveWay = other < vehicle && dx * dx + dy * dy < AI_GIVE_WAY_DISTANCE * AI_GIVE_WAY_DISTANCE;
+        if (along > 0.f && (inLane || giveWay) && along < gap) {
+            gap = along;
+            yielding = other < vehicle;
+        }
+    }
+    return gap;
+}
+
+// The next road the driver turns onto within AI_FOLLOW_DISTANCE, and how far away it starts
+static std::uint32_t upcomingLane(const AiDriver& driver, float x, float y, float& distance) {
+    size_t count = driver.waypointLane.size();
+    if (driver.nextWaypoint >= count)
+        return NO_ROAD_LANE;
+    std::uint32_t lane = driver.waypointLane[driver.nextWaypoint];
+    for (size_t i = driver.nextWaypoint + 1; i < count; ++i) {
+        float dx = driver.waypointX[i] - x, dy = driver.waypointY[i] - y;
+        distance = std::sqrt(dx * dx + dy * dy);
+        if (distance > AI_FOLLOW_DISTANCE)
+            break;
+        if (driver.waypointLane[i] != lane && driver.waypointLane[i] != NO_ROAD_LANE)
+            return driver.waypointLane[i];
+    }
+    return NO_ROAD_LANE;
+}
+
+static std::uint8_t steer(AiTraffic& traffic, Fleet& fleet, AiDriver& driver, std::uint64_t tick) {
+    const size_t vehicle = driver.vehicle;
+    const float x = fleet.positionX[vehicle];
+    const float y = fleet.positionY[vehicle];
+    const float speed = fleet.speed[vehicle];
+
+    if (driver.refueling) {
+        // Coast to a stop on the pumps and hold F until the tank is nearly full. A car that
+        // came to rest beside the green area gives up and plans again.
+        bool offPumps = std::abs(speed) < 1.f && vehicle < fleet.surface.size() && fleet.surface[vehicle] != SURFACE_FUEL;
+        if (fleet.fuel[vehicle] < 0.95f * MAX_FUEL && !offPumps)
+            return CONTROL_REFUEL;
+        driver.refueling = false;
+        clearPlan(driver);
+    }
+
+    if (!driver.route)
+        planTrip(traffic, fleet, driver, tick);
+    if (!driver.route)
+        return 0;
+
+    size_t count = driver.waypointX.size();
+    while (driver.nextWaypoint < count) {
+        float dx = driver.waypointX[driver.nextWaypoint] - x, dy = driver.waypointY[driver.nextWaypoint] - y;
+        if (dx * dx + dy * dy > AI_WAYPOINT_RADIUS * AI_WAYPOINT_RADIUS)
+            break;
+        ++driver.nextWaypoint;
+    }
+    if (driver.nextWaypoint >= count) {
+        driver.refueling = driver.station >= 0;
+        clearPlan(driver);
+        return 0;
+    }
+
+    float targetX = driver.waypointX[driver.nextWaypoint];
+    float targetY = driver.waypointY[driver.nextWaypoint];
+    float heading = std::atan2(targetY - y, targetX - x) * 180.f / 3.14159f;
+    float error = wrapDegrees(heading - fleet.angle[vehicle]);
+
+    // Hold back behind a car ahead; one that has to wait is not wedged, so it waits longer
+    // before backing up. The car giving way backs up first, which breaks up two cars nose to
+    // nose at a junction.
+    bool yielding = false;
+    float followSpeed = (trafficGap(traffic, fleet, vehicle, yielding) - CAR_LENGTH) * AI_FOLLOW_GAIN;
+
+    // Most roads are too narrow for two cars to pass, so a car about to turn onto one waits
+    // short of the junction while anything is driving along it the other way, or about to
+    // turn onto it from the far end with the right of way
+    float entry = 0.f;
+    std::uint32_t next = upcomingLane(driver, x, y, entry);
+    if (next != NO_ROAD_LANE && (traffic.laneTraffic[next ^ 1] > 0 || traffic.laneClaim[next ^ 1] < vehicle)) {
+        float waitSpeed = (entry - CAR_LENGTH) * AI_FOLLOW_GAIN;
+        if (waitSpeed < followSpeed) {
+            followSpeed = waitSpeed;
+            yielding = true;
+        }
+    }
+    const CarTuning& tuning = vehicleTuning(fleet, vehicle);
+    bool held = followSpeed < tuning.minTurnSpeed;
+
+    // A car too slow to steer that keeps trying is wedged against the edge, and one facing
+    // away from its route cannot turn around in the width of a road. Both back up with the
+    // wheels turned the other way, which swings the nose toward the target.
+    if (driver.reverseTicks == 0) {
+        if (std::abs(speed) >= tuning.minTurnSpeed)
+            driver.stuckTicks = 0;
+        else if (std::abs(error) > AI_REVERSE_ANGLE && !held)
+            driver.reverseTicks = AI_REVERSE_TICKS, driver.turningAround = true;
+        else if (++driver.stuckTicks > (held ? (yielding ? AI_HELD_TICKS : 2 * AI_HELD_TICKS) : AI_STUCK_TICKS))
+            driver.reverseTicks = AI_REVERSE_TICKS, driver.turningAround = false;
+    }
+    if (driver.reverseTicks > 0) {
+        driver.stuckTicks = 0;
+        // Backed into the edge itself: this way round is hopeless, so plan a fresh trip
+        // from where the car now stands instead
+        if (driver.reverseTicks < AI_REVERSE_TICKS - AI_REVERSE_BLOCKED_TICKS && std::abs(speed) < 1.f) {
+            driver.reverseTicks = 0;
+            clearPlan(driver);
+            return 0;
+        }
+        // Turning around is done once the nose points down the route; backing away from
+        // an edge takes the full time, to leave room to steer past it
+        if (--driver.reverseTicks > 0 && !(driver.turningAround && std::abs(error) < AI_REVERSE_DONE_ANGLE))
+            return CONTROL_BRAKE | (error > 0.f ? CONTROL_TURN_LEFT : CONTROL_TURN_RIGHT);
+        driver.reverseTicks = 0;
+    }
+    // Too far off to make the turn going forward: stop first, then the above backs up
+    if (std::abs(error) > AI_REVERSE_ANGLE)
+        return speed > 0.f ? CONTROL_BRAKE : 0;
+
+    std::uint8_t controls = 0;
+    if (error > 4.f)
+        controls |= CONTROL_TURN_RIGHT;
+    else if (error < -4.f)
+        controls |= CONTROL_TURN_LEFT;
+
+    // Slow down for sharp turns and for the end of the route, but keep enough speed to steer
+    float cornering = std::max(0.35f, std::cos(error * 3.14159f / 180.f));
+    float targetSpeed = tuning.maxSpeed * cornering;
+    if (driver.nextWaypoint + 1 == count) {
+        float dx = targetX - x, dy = targetY - y;
+        targetSpeed = std::min(targetSpeed, std::sqrt(dx * dx + dy * dy) * 0.8f + tuning.minTurnSpeed + 10.f);
+    }
+    targetSpeed = std::min(targetSpeed, std::max(0.f, followSpeed));
+    if (speed < targetSpeed)
+        controls |= CONTROL_ACCELERATE;
+    else if (speed > targetSpeed + 15.f)
+        controls |= CONTROL_BRAKE;
+    return controls;
+}
+
+void attachAiTraffic(AiTraffic& traffic, const RoadGraph& graph, const RoadMap& roads, size_t firstVehicle, size_t count,
+    std::uint32_t seed) {
+    traffic.graph = &graph;
+    traffic.roads = &roads;
+    traffic.seed = seed;
+    initRoutePlanner(traffic.planner, graph);
+    traffic.zoneStation.assign(roads.zones.zones.size(), -1);
+    for (size_t i = 0; i < graph.stations.size(); ++i) {
+        if (graph.stations[i].zone < traffic.zoneStation.size())
+            traffic.zoneStation[graph.stations[i].zone] = static_cast<int>(i);
+    }
+    traffic.drivers.assign(count, AiDriver());
+    for (size_t i = 0; i < count; ++i)
+        traffic.drivers[i].vehicle = firstVehicle + i;
+}
+
+// True if a car placed at (x, y) would touch one of the fleet's cars indexed in `existing`
+static bool spawnPointTaken(const Fleet& fleet, const SpatialHash& existing, NeighbourQuery& query, float x, float y) {
+    queryNeighbours(existing, x, y, CAR_LENGTH, query);
+    for (std::uint32_t other : query.found) {
+        float dx = fleet.positionX[other] - x, dy = fleet.positionY[other] - y;
+        if (dx * dx + dy * dy < CAR_LENGTH * CAR_LENGTH)
+            return true;
+    }
+    return false;
+}
+
+void spawnAiTraffic(AiTraffic& traffic, Fleet& fleet, const RoadGraph& graph, const RoadMap& roads, size_t count,
+    std::uint32_t seed) {
+    if (graph.edges.empty())
+        count = 0;
+
+    // Cars already in the fleet are looked up in a spatial hash. Cars spawned here only ever
+    // stand on road points, so each marks the points too close to it instead.
+    size_t first = fleetSize(fleet);
+    SpatialHash existing;
+    buildSpatialHash(existing, fleet.positionX.data(), fleet.positionY.data(), first);
+    std::vector<bool> pointTaken(graph.pointX.size(), false);
+    NeighbourQuery query;
+    for (size_t i = 0; i < count; ++i) {
+        // A point somewhere along a road, facing along it; a few tries to find one clear of other cars
+        float x = 0.f, y = 0.f, angle = 0.f;
+        for (std::uint32_t attempt = 0; attempt < AI_SPAWN_TRIES; ++attempt) {
+            std::uint32_t hash = mixHash(seed + attempt, first + i, 0);
+            const RoadEdge& edge = graph.edges[hash % graph.edges.size()];
+            std::uint32_t index = mixHash(seed + attempt, first + i, 1) % edge.pointCount;
+            std::uint32_t ahead = std::min(index + 1, edge.pointCount - 1);
+            std::uint32_t behind = ahead - 1;
+            if (hash & 0x80000000u)
+                std::swap(ahead, behind);
+
+            x = graph.pointX[edge.firstPoint + index];
+            y = graph.pointY[edge.firstPoint + index];
+            angle = std::atan2(graph.pointY[edge.firstPoint + ahead] - graph.pointY[edge.firstPoint + behind],
+                graph.pointX[edge.firstPoint + ahead] - graph.pointX[edge.firstPoint + behind]) * 180.f / 3.14159f;
+            if (!pointTaken[edge.firstPoint + index] && !spawnPointTaken(fleet, existing, query, x, y))
+                break;
+        }
+        queryNeighbours(graph.pointIndex, x, y, CAR_LENGTH, query);
+        for (std::uint32_t entry : query.found) {
+            std::uint32_t point = graph.indexedPoint[entry];
+            float dx = graph.pointX[point] - x, dy = graph.pointY[point] - y;
+            if (dx * dx + dy * dy < CAR_LENGTH * CAR_LENGTH)
+                pointTaken[point] = true;
+        }
+        // Every profile gets an equal block of consecutive cars, which keeps the physics runs long
+        std::uint8_t profile = static_cast<std::uint8_t>(i * fleet.profiles.size() / count);
+        addVehicle(fleet, sf::Vector2f(x, y), angle, MAX_FUEL, profile);
+    }
+    attachAiTraffic(traffic, graph, roads, first, count, seed);
+}
+
+void resetAiTraffic(AiTraffic& traffic) {
+    for (AiDriver& driver : traffic.drivers) {
+        size_t vehicle = driver.vehicle;
+        driver = AiDriver();
+        driver.vehicle = vehicle;
+    }
+}
+
+void driveAiTraffic(AiTraffic& traffic, Fleet& fleet, std::uint64_t tick) {
+    if (!traffic.graph)
+        return;
+
+    // Which way every car is going along the road it is on, and which road it turns onto next,
+    // for the oncoming check. Only the lanes set last tick are cleared; with far fewer cars
+    // than roads most lanes stay empty from one tick to the next.
+    size_t lanes = traffic.graph->edges.size() * 2;
+    if (traffic.laneTraffic.size() != lanes) {
+        traffic.laneTraffic.assign(lanes, 0);
+        traffic.laneClaim.assign(lanes, NO_VEHICLE);
+        traffic.touchedLanes.clear();
+    }
+    for (std::uint32_t lane : traffic.touchedLanes) {
+        traffic.laneTraffic[lane] = 0;
+        traffic.laneClaim[lane] = NO_VEHICLE;
+    }
+    traffic.touchedLanes.clear();
+    for (const AiDriver& driver : traffic.drivers) {
+        if (driver.vehicle >= fleetSize(fleet) || driver.nextWaypoint >= driver.waypointLane.size())
+            continue;
+        std::uint32_t lane = driver.waypointLane[driver.nextWaypoint];
+        if (lane != NO_ROAD_LANE) {
+            ++traffic.laneTraffic[lane];
+            traffic.touchedLanes.push_back(lane);
+        }
+        float entry = 0.f;
+        std::uint32_t next = upcomingLane(driver, fleet.positionX[driver.vehicle], fleet.positionY[driver.vehicle], entry);
+        if (next != NO_ROAD_LANE) {
+            traffic.laneClaim[next] = std::min(traffic.laneClaim[next], driver.vehicle);
+            traffic.touchedLanes.push_back(next);
+        }
+    }
+
+    for (AiDriver& driver : traffic.drivers) {
+        if (driver.vehicle < fleetSize(fleet))
+            fleet.controls[driver.vehicle] = steer(traffic, fleet, driver, tick);
+    }
+}
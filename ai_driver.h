@@ -0,0 +1,74 @@
+#pragma once
+#include "fleet.h"
+#include "route_planner.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+const std::uint32_t NO_ROAD_LANE = 0xFFFFFFFFu;
+const size_t NO_VEHICLE = static_cast<size_t>(-1);
+const float AI_WAYPOINT_RADIUS = 48.f;        // A waypoint counts as passed this close to the car
+const std::uint32_t AI_DESTINATION_TRIES = 8; // Random destinations considered per trip
+const std::uint32_t AI_SPAWN_TRIES = 8;       // Random road points considered per spawned car
+const float AI_LANE_OFFSET = 0.6f * CAR_WIDTH; // Cars keep this far right of the middle of the road
+const float AI_LANE_STEP = 4.f;               // ...moving left in these steps where that doesn't fit
+const float AI_LANE_MARGIN = 4.f;             // Room kept between the car's side and the road edge
+const float AI_BEND_SPAN = 1.5f * CAR_LENGTH;  // Road this far either side of a point decides if it is on a bend
+const float AI_BEND_COSINE = 0.87f;           // Turning more than ~30 degrees over that is a bend
+const float AI_FOLLOW_DISTANCE = 3.f * CAR_LENGTH; // Cars closer than this ahead slow a driver down
+const float AI_FOLLOW_GAIN = 1.5f;            // Speed allowed per pixel of gap beyond one car length
+const float AI_GIVE_WAY_DISTANCE = 1.5f * CAR_LENGTH; // Cars with the right of way this close in front hold a driver back
+const float AI_LOW_FUEL = 0.35f * MAX_FUEL;   // Below this a driver heads for the nearest fuel station
+const int AI_STUCK_TICKS = 120;               // Ticks too slow to steer before a driver backs up
+const int AI_HELD_TICKS = 600;                // The same while giving way to another car, twice that with the right of way
+const int AI_REVERSE_TICKS = 150;             // Longest a driver backs up for
+const int AI_REVERSE_BLOCKED_TICKS = 30;      // Backing up this long without moving means the car hit the edge
+const float AI_REVERSE_ANGLE = 110.f;         // A stopped car this far off its heading backs up to turn
+const float AI_REVERSE_DONE_ANGLE = 30.f;     // ...until it is within this of the heading
+
+// State of one computer-driven car. Everything here can be rebuilt from the fleet: after a
+// snapshot is restored, the plans are dropped and made again from where the cars are.
+struct AiDriver {
+    size_t vehicle = 0;
+    std::shared_ptr<const Route> route;
+    std::vector<float> waypointX;             // The route's road centre points, in driving order
+    std::vector<float> waypointY;
+    std::vector<std::uint32_t> waypointLane;  // Edge * 2 + direction each waypoint lies on
+    size_t nextWaypoint = 0;
+    int station = -1;                         // Fuel station the route ends at, if any
+    bool refueling = false;
+    int stuckTicks = 0;
+    int reverseTicks = 0;
+    bool turningAround = false;               // Backing up to point the other way rather than to get unstuck
+};
+
+// Computer-driven cars. They plan on the road graph and steer by setting the same control
+// bits a player's keys would, so the fleet physics treat them like any other car.
+// Destinations are picked by hashing (seed, vehicle, tick), so a run is repeatable.
+struct AiTraffic {
+    const RoadGraph* graph = nullptr;
+    const RoadMap* roads = nullptr;
+    RoutePlanner planner;
+    std::vector<AiDriver> drivers;
+    std::uint32_t seed = 0;
+    std::vector<int> zoneStation;              // Fuel station of each surface zone, -1 for none
+    NeighbourQuery nearby;                     // Reused by every neighbour query
+    std::vector<std::uint32_t> laneTraffic;    // Cars on each edge and direction this tick
+    std::vector<size_t> laneClaim;             // Lowest vehicle about to turn onto each edge and direction
+    std::vector<std::uint32_t> touchedLanes;   // Lanes set in the two above, cleared next tick
+};
+
+// Add `count` cars at points along the roads chosen from `seed` and drive them. The cars are
+// shared out over fleet.profiles in order, in blocks.
+void spawnAiTraffic(AiTraffic& traffic, Fleet& fleet, const RoadGraph& graph, const RoadMap& roads, size_t count,
+    std::uint32_t seed);
+
+// Drive cars [firstVehicle, firstVehicle + count) that are already in the fleet
+void attachAiTraffic(AiTraffic& traffic, const RoadGraph& graph, const RoadMap& roads, size_t firstVehicle, size_t count,
+    std::uint32_t seed);
+
+// Forget every plan; call after the fleet was restored from a snapshot
+void resetAiTraffic(AiTraffic& traffic);
+
+// Set every AI car's controls for the tick about to be simulated
+void driveAiTraffic(AiTraffic& traffic, Fleet& fleet, std::uint64_t tick);
@@ -0,0 +1,399 @@
+#include "assets.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char ASSET_BUNDLE_MAGIC[4] = { 'R', 'B', 'N', 'D' };
+const std::uint32_t ASSET_BUNDLE_VERSION = 1;
+
+std::uint64_t hashBytes(const void* data, size_t size, std::uint64_t hash = 14695981039346656037ull) {
+    // 64-bit FNV-1a, the same hash the distance field cache is keyed with
+    const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool readFile(const std::string& path, std::vector<char>& bytes) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+
+    bytes.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(bytes.data(), bytes.size());
+    return static_cast<bool>(file);
+}
+
+// Run body(0) .. body(count - 1) spread over all cores
+template <typename Body>
+void parallelFor(size_t count, Body body) {
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++)
+            body(i);
+    };
+
+    size_t threads = std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads; ++i)
+        workers.emplace_back(worker);
+    worker();
+    for (std::thread& thread : workers)
+        thread.join();
+}
+
+template <typename T>
+bool isReady(const T& future) {
+    return !future.valid() || future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+template <typename T>
+void writeValue(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool readValue(const std::uint8_t*& cursor, const std::uint8_t* end, T& value) {
+    if (end - cursor < static_cast<std::ptrdiff_t>(sizeof(value)))
+        return false;
+    std::memcpy(&value, cursor, sizeof(value));
+    cursor += sizeof(value);
+    return true;
+}
+
+} // namespace
+
+bool mapFile(MappedFile& mapped, const std::string& path) {
+    unmapFile(mapped);
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    HANDLE mapping = nullptr;
+    const void* view = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping)
+        view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    mapped.file = file;
+    mapped.mapping = mapping;
+    mapped.data = static_cast<const std::uint8_t*>(view);
+    mapped.size = static_cast<size_t>(size.QuadPart);
+#else
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return false;
+
+    struct stat info;
+    void* view = MAP_FAILED;
+    if (fstat(descriptor, &info) == 0 && info.st_size > 0)
+        view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (view == MAP_FAILED) {
+        close(descriptor);
+        return false;
+    }
+
+    mapped.descriptor = descriptor;
+    mapped.data = static_cast<const std::uint8_t*>(view);
+    mapped.size = static_cast<size_t>(info.st_size);
+#endif
+    return true;
+}
+
+void unmapFile(MappedFile& mapped) {
+    if (!mapped.data)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(mapped.data);
+    CloseHandle(mapped.mapping);
+    CloseHandle(mapped.file);
+    mapped.file = nullptr;
+    mapped.mapping = nullptr;
+#else
+    munmap(const_cast<std::uint8_t*>(mapped.data), mapped.size);
+    close(mapped.descriptor);
+    mapped.descriptor = -1;
+#endif
+    mapped.data = nullptr;
+    mapped.size = 0;
+}
+
+bool openAssetBundle(AssetBundle& bundle, const std::string& path) {
+    closeAssetBundle(bundle);
+    if (!mapFile(bundle.file, path))
+        return false;
+
+    const std::uint8_t* cursor = bundle.file.data;
+    const std::uint8_t* end = cursor + bundle.file.size;
+    char magic[4];
+    std::uint32_t version = 0, count = 0;
+    bool valid = readValue(cursor, end, magic) && std::equal(magic, magic + 4, ASSET_BUNDLE_MAGIC) &&
+        readValue(cursor, end, version) && version == ASSET_BUNDLE_VERSION && readValue(cursor, end, count);
+
+    for (std::uint32_t i = 0; valid && i < count; ++i) {
+        std::uint32_t nameLength = 0, kind = 0;
+        AssetBundle::Entry entry;
+        valid = readValue(cursor, end, nameLength) && end - cursor >= static_cast<std::ptrdiff_t>(nameLength);
+        if (!valid)
+            break;
+        std::string name(reinterpret_cast<const char*>(cursor), nameLength);
+        cursor += nameLength;
+
+        valid = readValue(cursor, end, kind) && readValue(cursor, end, entry.width) && readValue(cursor, end, entry.height) &&
+            readValue(cursor, end, entry.key) && readValue(cursor, end, entry.offset) && readValue(cursor, end, entry.size) &&
+            entry.offset <= bundle.file.size && entry.size <= bundle.file.size - entry.offset;
+        entry.kind = static_cast<AssetKind>(kind);
+        bundle.entries[name] = entry;
+    }
+
+    if (!valid) {
+        std::cerr << "Ignoring damaged asset bundle " << path << std::endl;
+        closeAssetBundle(bundle);
+    }
+    return valid;
+}
+
+void closeAssetBundle(AssetBundle& bundle) {
+    unmapFile(bundle.file);
+    bundle.entries.clear();
+}
+
+const std::uint8_t* findBundleEntry(const AssetBundle& bundle, const std::string& name, AssetKind kind,
+    std::uint64_t key, unsigned int& width, unsigned int& height) {
+    auto found = bundle.entries.find(name);
+    if (found == bundle.entries.end() || found->second.kind != kind || found->second.key != key)
+        return nullptr;
+
+    width = found->second.width;
+    height = found->second.height;
+    return bundle.file.data + found->second.offset;
+}
+
+void startAssetLoader(AssetLoader& loader, const std::string& bundlePath) {
+    loader.bundlePath = bundlePath;
+    openAssetBundle(loader.bundle, bundlePath);
+}
+
+std::shared_future<std::shared_ptr<ImageAsset>> requestImage(AssetLoader& loader, const std::string& file) {
+    auto found = loader.images.find(file);
+    if (found != loader.images.end())
+        return found->second;
+
+    const AssetBundle* bundle = &loader.bundle;
+    std::shared_future<std::shared_ptr<ImageAsset>> future = std::async(std::launch::async, [bundle, file]() {
+        auto asset = std::make_shared<ImageAsset>();
+        std::vector<char> bytes;
+        if (!readFile(file, bytes)) {
+            std::cerr << "Error loading " << file << std::endl;
+            return asset;
+        }
+
+        // Reading and hashing the compressed file is far cheaper than decoding it
+        asset->key = hashBytes(bytes.data(), bytes.size());
+        unsigned int width = 0, height = 0;
+        const std::uint8_t* pixels = findBundleEntry(*bundle, file, ASSET_IMAGE, asset->key, width, height);
+        if (pixels) {
+            asset->image.create(width, height, pixels);
+            asset->loaded = true;
+            asset->fromBundle = true;
+            return asset;
+        }
+
+        asset->loaded = asset->image.loadFromMemory(bytes.data(), bytes.size());
+        if (!asset->loaded)
+            std::cerr << "Error loading " << file << std::endl;
+        return asset;
+    }).share();
+
+    loader.images[file] = future;
+    return future;
+}
+
+void requestRoadMap(AssetLoader& loader, RoadMap& roads, const WorldTiles& world) {
+    loader.roads = &roads;
+    loader.roadsName = world.prefix + ".tiles:mask";
+    AssetLoader* owner = &loader;
+    loader.roadsResult = std::async(std::launch::async, [owner, world]() {
+        size_t tilesX = tilesAcross(world);
+        size_t count = tilesX * tilesDown(world);
+
+        // Key the classified grid by the world size and every mask tile's bytes
+        std::vector<std::vector<char>> files(count);
+        std::uint64_t key = hashBytes(&world.width, sizeof(world.width));
+        key = hashBytes(&world.height, sizeof(world.height), key);
+        for (size_t i = 0; i < count; ++i) {
+            if (!readFile(tileFile(world, "mask", i % tilesX, i / tilesX), files[i])) {
+                std::cerr << "Error loading road mask tile " << i % tilesX << ", " << i / tilesX << std::endl;
+                return false;
+            }
+            key = hashBytes(files[i].data(), files[i].size(), key);
+        }
+        owner->roadsKey = key;
+
+        RoadMap& map = *owner->roads;
+        unsigned int width = 0, height = 0;
+        const std::uint8_t* cells = findBundleEntry(owner->bundle, owner->roadsName, ASSET_SURFACE_GRID, key, width, height);
+        initSurfaceGrid(map.surface, world.width, world.height);
+        if (cells && width == world.width && height == world.height) {
+            std::memcpy(map.surface.cells.data(), cells, map.surface.cells.size());
+            owner->roadsFromBundle = true;
+        }
+        else {
+            // Decode the tiles in parallel; classification is cheap and writes shared bytes, so it stays serial
+            std::vector<sf::Image> tiles(count);
+            std::atomic<bool> decoded(true);
+            parallelFor(count, [&](size_t i) {
+                if (!tiles[i].loadFromMemory(files[i].data(), files[i].size()))
+                    decoded = false;
+                std::vector<char>().swap(files[i]);
+            });
+            if (!decoded) {
+                std::cerr << "Error decoding road mask tiles" << std::endl;
+                return false;
+            }
+
+            for (size_t i = 0; i < count; ++i) {
+                sf::IntRect rect = tileRect(world, static_cast<unsigned int>(i % tilesX), static_cast<unsigned int>(i / tilesX));
+                classifyMaskTile(map.surface, tiles[i], rect.left, rect.top);
+                tiles[i] = sf::Image();
+            }
+        }
+
+        loadRoadMapDistance(map, world.prefix + ".sdf");
+        return true;
+    });
+}
+
+bool isAssetLoaderDone(const AssetLoader& loader) {
+    for (const auto& image : loader.images) {
+        if (!isReady(image.second))
+            return false;
+    }
+    return isReady(loader.roadsResult);
+}
+
+static bool saveAssetBundle(const AssetLoader& loader, std::vector<std::shared_ptr<ImageAsset>>& images) {
+    struct Pending {
+        std::string name;
+        AssetBundle::Entry entry;
+        const void* data;
+    };
+    std::vector<Pending> pending;
+
+    size_t index = 0;
+    for (const auto& image : loader.images) {
+        const ImageAsset& asset = *images[index++];
+        if (!asset.loaded)
+            continue;
+        Pending item{ image.first, AssetBundle::Entry(), asset.image.getPixelsPtr() };
+        item.entry.kind = ASSET_IMAGE;
+        item.entry.width = asset.image.getSize().x;
+        item.entry.height = asset.image.getSize().y;
+        item.entry.key = asset.key;
+        item.entry.size = static_cast<std::uint64_t>(item.entry.width) * item.entry.height * 4;
+        pending.push_back(item);
+    }
+    if (loader.roads && loader.roadsKey != 0) {
+        Pending item{ loader.roadsName, AssetBundle::Entry(), loader.roads->surface.cells.data() };
+        item.entry.kind = ASSET_SURFACE_GRID;
+        item.entry.width = loader.roads->surface.width;
+        item.entry.height = loader.roads->surface.height;
+        item.entry.key = loader.roadsKey;
+        item.entry.size = loader.roads->surface.cells.size();
+        pending.push_back(item);
+    }
+
+    // Header and index first, then every payload back to back
+    std::uint64_t offset = sizeof(ASSET_BUNDLE_MAGIC) + 2 * sizeof(std::uint32_t);
+    for (const Pending& item : pending)
+        offset += 4 * sizeof(std::uint32_t) + item.name.size() + 3 * sizeof(std::uint64_t);
+    for (Pending& item : pending) {
+        item.entry.offset = offset;
+        offset += item.entry.size;
+    }
+
+    std::ofstream file(loader.bundlePath, std::ios::binary);
+    if (!file)
+        return false;
+
+    file.write(ASSET_BUNDLE_MAGIC, sizeof(ASSET_BUNDLE_MAGIC));
+    writeValue(file, ASSET_BUNDLE_VERSION);
+    writeValue(file, static_cast<std::uint32_t>(pending.size()));
+    for (const Pending& item : pending) {
+        writeValue(file, static_cast<std::uint32_t>(item.name.size()));
+        file.write(item.name.data(), item.name.size());
+        writeValue(file, static_cast<std::uint32_t>(item.entry.kind));
+        writeValue(file, item.entry.width);
+        writeValue(file, item.entry.height);
+        writeValue(file, item.entry.key);
+        writeValue(file, item.entry.offset);
+        writeValue(file, item.entry.size);
+    }
+    for (const Pending& item : pending)
+        file.write(static_cast<const char*>(item.data), item.entry.size);
+    return static_cast<bool>(file);
+}
+
+bool finishAssetLoader(AssetLoader& loader) {
+    bool stale = false;
+    std::vector<std::shared_ptr<ImageAsset>> images;
+    for (const auto& image : loader.images) {
+        images.push_back(image.second.get());
+        stale = stale || (images.back()->loaded && !images.back()->fromBundle);
+    }
+
+    bool roadsLoaded = true;
+    if (loader.roadsResult.valid()) {
+        roadsLoaded = loader.roadsResult.get();
+        stale = stale || (roadsLoaded && !loader.roadsFromBundle);
+    }
+
+    // The bundle must be unmapped before it can be overwritten
+    closeAssetBundle(loader.bundle);
+    if (stale && !saveAssetBundle(loader, images))
+        std::cerr << "Could not write asset bundle " << loader.bundlePath << std::endl;
+    return roadsLoaded;
+}
+
+const sf::Image* loadedImage(AssetLoader& loader, const std::string& file) {
+    auto found = loader.images.find(file);
+    if (found == loader.images.end())
+        return nullptr;
+
+    const ImageAsset& asset = *found->second.get();
+    return asset.loaded ? &asset.image : nullptr;
+}
+
+void releaseAssetLoader(AssetLoader& loader) {
+    loader.images.clear();
+    loader.roads = nullptr;
+}
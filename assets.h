@@ -0,0 +1,97 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include "road_map.h"
+#include "world_tiles.h"
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A read-only file mapped into memory (mmap / MapViewOfFile)
+struct MappedFile {
+    const std::uint8_t* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#else
+    int descriptor = -1;
+#endif
+};
+
+bool mapFile(MappedFile& mapped, const std::string& path);
+void unmapFile(MappedFile& mapped);
+
+enum AssetKind : std::uint32_t {
+    ASSET_IMAGE = 0,          // Raw RGBA pixels
+    ASSET_SURFACE_GRID = 1    // Packed SurfaceGrid cells
+};
+
+// Preprocessed assets in one file: raw pixels for every image and the classified road grid.
+// Each entry is keyed by a hash of the source files it came from, so a stale entry is simply
+// ignored and re-decoded. The bundle is memory mapped, so a warm start copies pixels straight
+// out of the page cache instead of decoding PNG/JPEG.
+struct AssetBundle {
+    struct Entry {
+        AssetKind kind = ASSET_IMAGE;
+        unsigned int width = 0;
+        unsigned int height = 0;
+        std::uint64_t key = 0;
+        std::uint64_t offset = 0;
+        std::uint64_t size = 0;
+    };
+    MappedFile file;
+    std::map<std::string, Entry> entries;
+};
+
+bool openAssetBundle(AssetBundle& bundle, const std::string& path);
+void closeAssetBundle(AssetBundle& bundle);
+
+// Bundle payload for `name` if the bundle has it with a matching key and kind, else nullptr
+const std::uint8_t* findBundleEntry(const AssetBundle& bundle, const std::string& name, AssetKind kind,
+    std::uint64_t key, unsigned int& width, unsigned int& height);
+
+// A decoded image together with the key of the source file it was decoded from
+struct ImageAsset {
+    sf::Image image;
+    std::uint64_t key = 0;
+    bool loaded = false;
+    bool fromBundle = false;
+};
+
+// Loads assets on worker threads while the window keeps drawing frames. Every file is
+// requested at most once, no matter how many callers ask for it, and all decoding runs
+// in parallel. GPU uploads stay on the render thread once isAssetLoaderDone() is true.
+struct AssetLoader {
+    AssetBundle bundle;
+    std::string bundlePath;
+    std::map<std::string, std::shared_future<std::shared_ptr<ImageAsset>>> images;
+
+    RoadMap* roads = nullptr;
+    std::string roadsName;
+    std::uint64_t roadsKey = 0;
+    bool roadsFromBundle = false;
+    std::future<bool> roadsResult;
+};
+
+void startAssetLoader(AssetLoader& loader, const std::string& bundlePath);
+
+// Decode an image file in the background (or copy it from the bundle)
+std::shared_future<std::shared_ptr<ImageAsset>> requestImage(AssetLoader& loader, const std::string& file);
+
+// Build the road map from the tiled mask in the background, decoding the tiles in parallel
+void requestRoadMap(AssetLoader& loader, RoadMap& roads, const WorldTiles& world);
+
+bool isAssetLoaderDone(const AssetLoader& loader);
+
+// Wait for everything, then rewrite the bundle if anything had to be decoded from source.
+// Returns false if the road map failed to load.
+bool finishAssetLoader(AssetLoader& loader);
+
+// The image for `file` once the loader is done, or nullptr if it failed to load
+const sf::Image* loadedImage(AssetLoader& loader, const std::string& file);
+
+// Drop the decoded images once they have been uploaded as textures
+void releaseAssetLoader(AssetLoader& loader);
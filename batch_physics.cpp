@@ -0,0 +1,495 @@
+#include "batch_physics.h"
+#include "simulation.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BATCH_PHYSICS_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BATCH_PHYSICS_SSE2
+#endif
+
+namespace {
+
+// Each Lanes type exposes the same small set of operations so the kernels below are written
+// once and instantiated per instruction set. Masks are full-width lane masks for SIMD types
+// and plain bools for the scalar fallback.
+struct ScalarLanes {
+    typedef float Value;
+    typedef bool Mask;
+    static const size_t width = 1;
+
+    static Value load(const float* p) { return *p; }
+    static void store(float* p, Value v) { *p = v; }
+    static Value set(float x) { return x; }
+    static Value add(Value a, Value b) { return a + b; }
+    static Value sub(Value a, Value b) { return a - b; }
+    static Value mul(Value a, Value b) { return a * b; }
+    static Value div(Value a, Value b) { return a / b; }
+    static Value min(Value a, Value b) { return a < b ? a : b; }
+    static Value max(Value a, Value b) { return a > b ? a : b; }
+    static Value abs(Value a) { return std::fabs(a); }
+    static Value copySign(Value magnitude, Value sign) { return std::copysign(magnitude, sign); }
+    static Value round(Value a) { return std::nearbyint(a); }
+    static Mask greater(Value a, Value b) { return a > b; }
+    static Mask less(Value a, Value b) { return a < b; }
+    static Mask lessEqual(Value a, Value b) { return a <= b; }
+    static Mask both(Mask a, Mask b) { return a && b; }
+    static Mask either(Mask a, Mask b) { return a || b; }
+    static Value select(Mask m, Value a, Value b) { return m ? a : b; }
+    static Mask hasBits(const std::uint8_t* p, std::uint8_t bits) { return (*p & bits) != 0; }
+    static Mask equals(const std::uint8_t* p, std::uint8_t value) { return *p == value; }
+};
+
+#if defined(BATCH_PHYSICS_AVX2)
+struct SimdLanes {
+    typedef __m256 Value;
+    typedef __m256 Mask;
+    static const size_t width = 8;
+
+    static Value load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, Value v) { _mm256_storeu_ps(p, v); }
+    static Value set(float x) { return _mm256_set1_ps(x); }
+    static Value add(Value a, Value b) { return _mm256_add_ps(a, b); }
+    static Value sub(Value a, Value b) { return _mm256_sub_ps(a, b); }
+    static Value mul(Value a, Value b) { return _mm256_mul_ps(a, b); }
+    static Value div(Value a, Value b) { return _mm256_div_ps(a, b); }
+    static Value min(Value a, Value b) { return _mm256_min_ps(a, b); }
+    static Value max(Value a, Value b) { return _mm256_max_ps(a, b); }
+    static Value abs(Value a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+    static Value copySign(Value magnitude, Value sign) {
+        __m256 signBit = _mm256_set1_ps(-0.f);
+        return _mm256_or_ps(_mm256_andnot_ps(signBit, magnitude), _mm256_and_ps(signBit, sign));
+    }
+    static Value round(Value a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static Mask greater(Value a, Value b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static Mask less(Value a, Value b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static Mask lessEqual(Value a, Value b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static Mask both(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+    static Mask either(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+    static Value select(Mask m, Value a, Value b) { return _mm256_blendv_ps(b, a, m); }
+    static __m256i widenBytes(const std::uint8_t* p) {
+        return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+    }
+    static Mask hasBits(const std::uint8_t* p, std::uint8_t bits) {
+        __m256i masked = _mm256_and_si256(widenBytes(p), _mm256_set1_epi32(bits));
+        __m256i none = _mm256_cmpeq_epi32(masked, _mm256_setzero_si256());
+        return _mm256_castsi256_ps(_mm256_xor_si256(none, _mm256_set1_epi32(-1)));
+    }
+    static Mask equals(const std::uint8_t* p, std::uint8_t value) {
+        return _mm256_castsi256_ps(_mm256_cmpeq_epi32(widenBytes(p), _mm256_set1_epi32(value)));
+    }
+};
+#elif defined(BATCH_PHYSICS_SSE2)
+struct SimdLanes {
+    typedef __m128 Value;
+    typedef __m128 Mask;
+    static const size_t width = 4;
+
+    static Value load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, Value v) { _mm_storeu_ps(p, v); }
+    static Value set(float x) { return _mm_set1_ps(x); }
+    static Value add(Value a, Value b) { return _mm_add_ps(a, b); }
+    static Value sub(Value a, Value b) { return _mm_sub_ps(a, b); }
+    static Value mul(Value a, Value b) { return _mm_mul_ps(a, b); }
+    static Value div(Value a, Value b) { return _mm_div_ps(a, b); }
+    static Value min(Value a, Value b) { return _mm_min_ps(a, b); }
+    static Value max(Value a, Value b) { return _mm_max_ps(a, b); }
+    static Value abs(Value a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+    static Value copySign(Value magnitude, Value sign) {
+        __m128 signBit = _mm_set1_ps(-0.f);
+        return _mm_or_ps(_mm_andnot_ps(signBit, magnitude), _mm_and_ps(signBit, sign));
+    }
+    // SSE2 has no round instruction; the conversion rounds to nearest, which is exact for
+    // the turn counts the kernels feed it
+    static Value round(Value a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+    static Mask greater(Value a, Value b) { return _mm_cmpgt_ps(a, b); }
+    static Mask less(Value a, Value b) { return _mm_cmplt_ps(a, b); }
+    static Mask lessEqual(Value a, Value b) { return _mm_cmple_ps(a, b); }
+    static Mask both(Mask a, Mask b) { return _mm_and_ps(a, b); }
+    static Mask either(Mask a, Mask b) { return _mm_or_ps(a, b); }
+    static Value select(Mask m, Value a, Value b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+    static __m128i widenBytes(const std::uint8_t* p) {
+        int packed;
+        std::memcpy(&packed, p, sizeof(packed));
+        __m128i zero = _mm_setzero_si128();
+        return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+    }
+    static Mask hasBits(const std::uint8_t* p, std::uint8_t bits) {
+        __m128i masked = _mm_and_si128(widenBytes(p), _mm_set1_epi32(bits));
+        __m128i none = _mm_cmpeq_epi32(masked, _mm_setzero_si128());
+        return _mm_castsi128_ps(_mm_xor_si128(none, _mm_set1_epi32(-1)));
+    }
+    static Mask equals(const std::uint8_t* p, std::uint8_t value) {
+        return _mm_castsi128_ps(_mm_cmpeq_epi32(widenBytes(p), _mm_set1_epi32(value)));
+    }
+};
+#else
+typedef ScalarLanes SimdLanes;
+#endif
+
+// sin(2*pi*t) for t in [-0.5, 0.5]: fold onto [-0.25, 0.25] and evaluate an odd Taylor
+// polynomial, accurate to about 1e-7 over that range
+template <typename L>
+typename L::Value sinTurns(typename L::Value t) {
+    typedef typename L::Value V;
+    V half = L::set(0.5f);
+    V quarter = L::set(0.25f);
+    t = L::select(L::greater(t, quarter), L::sub(half, t), t);
+    t = L::select(L::less(t, L::set(-0.25f)), L::sub(L::set(-0.5f), t), t);
+
+    V x = L::mul(t, L::set(6.28318531f));
+    V x2 = L::mul(x, x);
+    V p = L::set(-2.50521084e-8f);
+    p = L::add(L::mul(p, x2), L::set(2.75573192e-6f));
+    p = L::add(L::mul(p, x2), L::set(-1.98412698e-4f));
+    p = L::add(L::mul(p, x2), L::set(8.33333333e-3f));
+    p = L::add(L::mul(p, x2), L::set(-1.66666667e-1f));
+    p = L::add(L::mul(p, x2), L::set(1.f));
+    return L::mul(p, x);
+}
+
+// Branchless sin and cos of an angle given in degrees
+template <typename L>
+void sinCosDegrees(typename L::Value degrees, typename L::Value& sine, typename L::Value& cosine) {
+    typedef typename L::Value V;
+    V turns = L::mul(degrees, L::set(1.f / 360.f));
+    turns = L::sub(turns, L::round(turns));
+
+    V shifted = L::add(turns, L::set(0.25f));
+    shifted = L::select(L::greater(shifted, L::set(0.5f)), L::sub(shifted, L::set(1.f)), shifted);
+
+    sine = sinTurns<L>(turns);
+    cosine = sinTurns<L>(shifted);
+}
+
+// A profile's coefficients broadcast across the lanes, for the model formulas below
+template <typename L>
+struct TuningLanes {
+    typename L::Value one;
+    typename L::Value maxSpeed;
+    typename L::Value dragStep;    // drag * deltaTime
+    typename L::Value turnStep;    // turnRate * deltaTime
+    typename L::Value understeer;
+
+    TuningLanes(const CarTuning& tuning, float deltaTime)
+        : one(L::set(1.f)), maxSpeed(L::set(tuning.maxSpeed)), dragStep(L::set(tuning.drag * deltaTime)),
+          turnStep(L::set(tuning.turnRate * deltaTime)), understeer(L::set(tuning.understeer)) {}
+};
+
+// The VehicleModel formulas of handleInput, one type per model. integrateRange is instantiated
+// per model, so these inline into the loop and it never branches on the model.
+struct CarModel {
+    template <typename L>
+    static typename L::Value drag(typename L::Value speed, const TuningLanes<L>& k) {
+        return L::mul(speed, L::sub(k.one, k.dragStep));
+    }
+
+    template <typename L>
+    static typename L::Value turn(typename L::Value speed, const TuningLanes<L>& k) {
+        return L::mul(k.turnStep, L::div(speed, k.maxSpeed));
+    }
+};
+
+struct HeavyModel {
+    template <typename L>
+    static typename L::Value drag(typename L::Value speed, const TuningLanes<L>& k) {
+        return L::mul(speed, L::sub(k.one, L::div(L::mul(k.dragStep, L::abs(speed)), k.maxSpeed)));
+    }
+
+    template <typename L>
+    static typename L::Value turn(typename L::Value speed, const TuningLanes<L>& k) {
+        typename L::Value turn = L::mul(k.turnStep, L::div(speed, k.maxSpeed));
+        return L::mul(turn, L::sub(k.one, L::div(L::mul(k.understeer, L::abs(speed)), k.maxSpeed)));
+    }
+};
+
+// Mirrors handleInput plus the movement half of updateCar for vehicles [begin, end), which
+// all drive with `tuning` and model M
+template <typename L, typename Model>
+size_t integrateRange(Fleet& fleet, size_t begin, size_t end, float deltaTime, const CarTuning& tuning) {
+    typedef typename L::Value V;
+    typedef typename L::Mask M;
+
+    const TuningLanes<L> coefficients(tuning, deltaTime);
+    const V zero = L::set(0.f);
+    const V dt = L::set(deltaTime);
+    const V accelerationStep = L::set(tuning.acceleration * deltaTime);
+    const V brakeStep = L::set(tuning.acceleration * deltaTime * 0.5f);
+    const V accelerationFuel = L::set(5 * deltaTime);
+    const V brakeFuel = L::set(2 * deltaTime);
+    const V maxSpeed = L::set(tuning.maxSpeed);
+    const V maxReverse = L::set(-tuning.maxSpeed / 3);
+    const V frictionStep = L::set(tuning.friction * deltaTime);
+    const V minTurnSpeed = L::set(tuning.minTurnSpeed);
+
+    size_t i = begin;
+    for (; i + L::width <= end; i += L::width) {
+        V speed = L::load(&fleet.speed[i]);
+        V fuel = L::load(&fleet.fuel[i]);
+        V angle = L::load(&fleet.angle[i]);
+        const std::uint8_t* controls = &fleet.controls[i];
+
+        // Vehicles with an empty tank ignore their controls entirely
+        M running = L::greater(fuel, zero);
+
+        M accelerate = L::both(running, L::hasBits(controls, CONTROL_ACCELERATE));
+        speed = L::select(accelerate, L::min(L::add(speed, accelerationStep), maxSpeed), speed);
+        fuel = L::select(accelerate, L::sub(fuel, accelerationFuel), fuel);
+
+        M brake = L::both(running, L::hasBits(controls, CONTROL_BRAKE));
+        speed = L::select(brake, L::max(L::sub(speed, brakeStep), maxReverse), speed);
+        fuel = L::select(brake, L::sub(fuel, brakeFuel), fuel);
+
+        // Drag, then friction towards zero without crossing it
+        V slowed = Model::template drag<L>(speed, coefficients);
+        slowed = L::copySign(L::max(L::sub(L::abs(slowed), frictionStep), zero), slowed);
+        speed = L::select(running, slowed, speed);
+
+        M canTurn = L::both(running, L::greater(L::abs(speed), minTurnSpeed));
+        V turn = Model::template turn<L>(speed, coefficients);
+        angle = L::select(L::both(canTurn, L::hasBits(controls, CONTROL_TURN_LEFT)), L::sub(angle, turn), angle);
+        angle = L::select(L::both(canTurn, L::hasBits(controls, CONTROL_TURN_RIGHT)), L::add(angle, turn), angle);
+
+        V cooldown = L::load(&fleet.refuelCooldown[i]);
+        cooldown = L::select(L::greater(cooldown, zero), L::sub(cooldown, dt), cooldown);
+
+        V sine, cosine;
+        sinCosDegrees<L>(angle, sine, cosine);
+        L::store(&fleet.targetX[i], L::add(L::load(&fleet.positionX[i]), L::mul(L::mul(cosine, speed), dt)));
+        L::store(&fleet.targetY[i], L::add(L::load(&fleet.positionY[i]), L::mul(L::mul(sine, speed), dt)));
+
+        L::store(&fleet.speed[i], speed);
+        L::store(&fleet.fuel[i], fuel);
+        L::store(&fleet.angle[i], angle);
+        L::store(&fleet.refuelCooldown[i], cooldown);
+    }
+    return i;
+}
+
+// Mirrors the surface response half of updateCar for vehicles [begin, end)
+template <typename L>
+size_t resolveRange(Fleet& fleet, size_t begin, size_t end, float deltaTime) {
+    typedef typename L::Value V;
+    typedef typename L::Mask M;
+
+    const V zero = L::set(0.f);
+    const V dt = L::set(deltaTime);
+    const V boundarySlowdown = L::set(0.5f);
+    const V offRoadSlowdown = L::set(0.7f);
+    const V refuelCooldown = L::set(REFUEL_COOLDOWN);
+    const V refuelThreshold = L::set(1051.f);
+    const V refuelAmount = L::set(10.f);
+    const V maxFuel = L::set(MAX_FUEL);
+
+    size_t i = begin;
+    for (; i + L::width <= end; i += L::width) {
+        const std::uint8_t* surface = &fleet.surface[i];
+        M outOfBounds = L::equals(surface, SURFACE_OUT_OF_BOUNDS);
+        M offRoad = L::equals(surface, SURFACE_OFF_ROAD);
+        M blocked = L::either(outOfBounds, offRoad);
+
+        V speed = L::load(&fleet.speed[i]);
+        speed = L::select(outOfBounds, L::mul(speed, boundarySlowdown), speed);
+        speed = L::select(offRoad, L::mul(speed, offRoadSlowdown), speed);
+
+        V fuel = L::load(&fleet.fuel[i]);
+        V cooldown = L::load(&fleet.refuelCooldown[i]);
+        M refuel = L::both(L::equals(surface, SURFACE_FUEL),
+            L::both(L::hasBits(&fleet.controls[i], CONTROL_REFUEL), L::lessEqual(cooldown, zero)));
+        V refueled = L::select(L::less(fuel, refuelThreshold), L::add(fuel, refuelAmount), maxFuel);
+        fuel = L::select(refuel, refueled, fuel);
+        cooldown = L::select(refuel, refuelCooldown, cooldown);
+
+        L::store(&fleet.positionX[i], L::select(blocked, L::load(&fleet.positionX[i]), L::load(&fleet.targetX[i])));
+        L::store(&fleet.positionY[i], L::select(blocked, L::load(&fleet.positionY[i]), L::load(&fleet.targetY[i])));
+        L::store(&fleet.moved[i], L::select(blocked, zero, L::abs(L::mul(speed, dt))));
+        L::store(&fleet.speed[i], speed);
+        L::store(&fleet.fuel[i], fuel);
+        L::store(&fleet.refuelCooldown[i], cooldown);
+    }
+    return i;
+}
+
+}
+
+template <typename Model>
+static void integrateRun(Fleet& fleet, const FleetRun& run, float deltaTime, const CarTuning& tuning) {
+    size_t done = integrateRange<SimdLanes, Model>(fleet, run.begin, run.end, deltaTime, tuning);
+    integrateRange<ScalarLanes, Model>(fleet, done, run.end, deltaTime, tuning);
+}
+
+void integrateControls(Fleet& fleet, float deltaTime) {
+    // One dispatch per run of same-profile vehicles, none per vehicle
+    updateProfileRuns(fleet);
+    for (const FleetRun& run : fleet.profileRuns) {
+        const VehicleProfile& profile = fleet.profiles[run.profile];
+        switch (profile.model) {
+        case VEHICLE_MODEL_HEAVY:
+            integrateRun<HeavyModel>(fleet, run, deltaTime, profile.tuning);
+            break;
+        default:
+            integrateRun<CarModel>(fleet, run, deltaTime, profile.tuning);
+            break;
+        }
+    }
+}
+
+void resolveSurfaces(Fleet& fleet, float deltaTime) {
+    size_t count = fleetSize(fleet);
+    size_t done = resolveRange<SimdLanes>(fleet, 0, count, deltaTime);
+    resolveRange<ScalarLanes>(fleet, done, count, deltaTime);
+
+    // Mileage is kept in double precision, so it is accumulated separately
+    for (size_t i = 0; i < count; ++i)
+        fleet.mileage[i] += fleet.moved[i];
+}
+
+const char* batchInstructionSet() {
+#if defined(BATCH_PHYSICS_AVX2)
+    return "AVX2";
+#elif defined(BATCH_PHYSICS_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+// True if a move from (fromX, fromY) ends so close to a surface boundary that the tiny difference
+// between the batch and scalar targets can put them on different sides of it: the targets fall
+// on different mask pixels, either is within a pixel of a road edge, or the body sweep along the
+// move passes within a pixel of the clearance it stops at
+static bool nearSurfaceBoundary(const RoadMap& roads, float fromX, float fromY, float batchX, float batchY,
+    float scalarX, float scalarY) {
+    const float epsilon = 1.f;
+    if (std::floor(batchX) != std::floor(scalarX) || std::floor(batchY) != std::floor(scalarY))
+        return true;
+
+    for (int target = 0; target < 2; ++target) {
+        float x = target ? scalarX : batchX;
+        float y = target ? scalarY : batchY;
+        if (std::abs(distanceToEdge(roads.distance, x, y)) <= epsilon)
+            return true;
+
+        float dx = x - fromX, dy = y - fromY;
+        float length = std::sqrt(dx * dx + dy * dy);
+        if (length <= 0.f)
+            continue;
+        float axisX = dx / length, axisY = dy / length;
+        float allowed = std::min(0.f, bodyClearance(roads.distance, fromX, fromY, axisX, axisY));
+        if (std::abs(bodyClearance(roads.distance, x, y, axisX, axisY) - allowed) <= length + epsilon)
+            return true;
+    }
+    return false;
+}
+
+bool verifyBatchPhysics(std::ostream& report) {
+    // Road mask with off-road and fuel blocks so every surface branch is exercised
+    const unsigned int maskSize = 512;
+    sf::Image roadMask;
+    roadMask.create(maskSize, maskSize, sf::Color::White);
+    for (unsigned int y = 0; y < maskSize; ++y) {
+        for (unsigned int x = 0; x < maskSize; ++x) {
+            if ((x / 64 + y / 64) % 5 == 0)
+                roadMask.setPixel(x, y, sf::Color::Black);
+            else if ((x / 64) % 4 == 1 && (y / 64) % 3 == 2)
+                roadMask.setPixel(x, y, sf::Color::Green);
+        }
+    }
+    RoadMap roads;
+    buildRoadMap(roads, roadMask);
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> coordinate(-20.f, maskSize + 20.f);
+    std::uniform_real_distribution<float> speed(-MAX_SPEED / 3, MAX_SPEED);
+    std::uniform_real_distribution<float> angle(-720.f, 720.f);
+    std::uniform_real_distribution<float> fuel(-10.f, MAX_FUEL);
+    std::uniform_real_distribution<float> cooldown(0.f, REFUEL_COOLDOWN);
+    std::uniform_int_distribution<int> controls(0, 31);
+
+    // Runs of both models, none a multiple of the SIMD width, so every tail runs too
+    const size_t vehicles = 1003;
+    Fleet batch;
+    VehicleProfile heavy;
+    heavy.name = "heavy";
+    heavy.model = VEHICLE_MODEL_HEAVY;
+    heavy.tuning.drag = 0.3f;
+    heavy.tuning.turnRate = 80.f;
+    heavy.tuning.understeer = 0.5f;
+    batch.profiles.push_back(heavy);
+    for (size_t i = 0; i < vehicles; ++i) {
+        std::uint8_t profile = static_cast<std::uint8_t>((i / 333) % 2);
+        addVehicle(batch, sf::Vector2f(coordinate(random), coordinate(random)), angle(random), fuel(random), profile);
+        batch.speed[i] = speed(random);
+        batch.refuelCooldown[i] = cooldown(random);
+    }
+    Fleet scalar = batch;
+    scalar.surface.resize(vehicles);
+    std::vector<float> startX(vehicles), startY(vehicles), scalarTargetX(vehicles), scalarTargetY(vehicles);
+
+    // One tick from identical random states, repeated with fresh controls
+    const int ticks = 200;
+    const size_t maxEdgeCases = vehicles * ticks / 1000;  // Boundary straddles are rare; many mean a bug
+    float maxPosition = 0.f, maxSpeed = 0.f, maxAngle = 0.f, maxFuel = 0.f;
+    double maxMileage = 0.0;
+    size_t edgeCases = 0, surfaceMismatches = 0;
+    const float deltaTime = 1.f / SIMULATION_TICK_RATE;
+    for (int tick = 0; tick < ticks; ++tick) {
+        for (size_t i = 0; i < vehicles; ++i)
+            batch.controls[i] = scalar.controls[i] = static_cast<std::uint8_t>(controls(random));
+
+        stepFleet(batch, deltaTime, roads);
+
+        // Scalar reference, one vehicle at a time. The target updateCar will move to is
+        // recomputed here so its surface can be compared with the one the batch path used.
+        for (size_t i = 0; i < vehicles; ++i) {
+            handleInput(scalar, i, deltaTime, scalar.profiles[scalar.profile[i]]);
+            float angleRadians = scalar.angle[i] * 3.14159f / 180.f;
+            startX[i] = scalar.positionX[i];
+            startY[i] = scalar.positionY[i];
+            scalarTargetX[i] = scalar.positionX[i] + std::cos(angleRadians) * scalar.speed[i] * deltaTime;
+            scalarTargetY[i] = scalar.positionY[i] + std::sin(angleRadians) * scalar.speed[i] * deltaTime;
+            scalar.surface[i] = surfaceForMove(roads, startX[i], startY[i], scalarTargetX[i], scalarTargetY[i]);
+            updateCar(scalar, i, deltaTime, roads);
+        }
+
+        for (size_t i = 0; i < vehicles; ++i) {
+            // Targets within a hair of a boundary may legitimately land on different surfaces
+            // because of the sin/cos approximation; those are only counted. Any other
+            // disagreement is a classification bug.
+            if (scalar.surface[i] != batch.surface[i]) {
+                if (nearSurfaceBoundary(roads, startX[i], startY[i], batch.targetX[i], batch.targetY[i],
+                        scalarTargetX[i], scalarTargetY[i]))
+                    ++edgeCases;
+                else
+                    ++surfaceMismatches;
+            }
+            else {
+                maxPosition = std::max(maxPosition, std::abs(batch.positionX[i] - scalar.positionX[i]));
+                maxPosition = std::max(maxPosition, std::abs(batch.positionY[i] - scalar.positionY[i]));
+                maxSpeed = std::max(maxSpeed, std::abs(batch.speed[i] - scalar.speed[i]));
+                maxAngle = std::max(maxAngle, std::abs(batch.angle[i] - scalar.angle[i]));
+                maxFuel = std::max(maxFuel, std::abs(batch.fuel[i] - scalar.fuel[i]));
+                maxMileage = std::max(maxMileage, std::abs(batch.mileage[i] - scalar.mileage[i]));
+            }
+        }
+        scalar = batch;
+    }
+
+    bool ok = maxPosition < 1e-3f && maxSpeed < 1e-4f && maxAngle < 1e-4f && maxFuel < 1e-4f &&
+        maxMileage < 1e-4 && surfaceMismatches == 0 && edgeCases <= maxEdgeCases;
+    report << "Batch physics (" << batchInstructionSet() << ") vs scalar reference:\n";
+    report << "  max |position| diff: " << maxPosition << "\n";
+    report << "  max |speed| diff:    " << maxSpeed << "\n";
+    report << "  max |angle| diff:    " << maxAngle << "\n";
+    report << "  max |fuel| diff:     " << maxFuel << "\n";
+    report << "  max |mileage| diff:  " << maxMileage << "\n";
+    report << "  skipped edge-straddling moves: " << edgeCases << " (at most " << maxEdgeCases << ")\n";
+    report << "  surface mismatches away from an edge: " << surfaceMismatches << "\n";
+    report << (ok ? "PASS" : "FAIL") << std::endl;
+    return ok;
+}
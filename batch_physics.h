@@ -0,0 +1,23 @@
+#pragma once
+#include "fleet.h"
+#include <ostream>
+
+// Vectorized versions of handleInput/updateCar that advance many vehicles per instruction.
+// The widest instruction set enabled at compile time is used (AVX2, then SSE2) with a scalar
+// fallback for the remainder and for other targets. Branches are replaced by masks and
+// selects, and cos/sin come from a polynomial approximation instead of the C library.
+
+// Apply each vehicle's controls (acceleration, drag, friction, turning) and compute the
+// position it wants to move to in fleet.targetX/targetY. Each run in fleet.profileRuns goes
+// through a kernel compiled for its profile's model.
+void integrateControls(Fleet& fleet, float deltaTime);
+
+// Move, slow down or refuel each vehicle according to fleet.surface, and add to mileage
+void resolveSurfaces(Fleet& fleet, float deltaTime);
+
+// Name of the instruction set the kernels were compiled for
+const char* batchInstructionSet();
+
+// Run random fleets through both the batch kernels and the scalar reference formulas and
+// report the largest differences. Returns true when they agree within tolerance.
+bool verifyBatchPhysics(std::ostream& report);
@@ -0,0 +1,398 @@
+#include "bench.h"
+#include "ai_driver.h"
+#include "batch_physics.h"
+#include "fleet.h"
+#include "road_graph.h"
+#include "simulation.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <set>
+#include <utility>
+
+const int BENCH_REPEATS = 5;
+const size_t BENCH_LOOKUPS = 1 << 20;        // Points per road lookup benchmark
+const size_t BENCH_FLEET_CAR_TICKS = 1000000; // Car ticks per fleet repeat, whatever the fleet size
+const unsigned int BENCH_RENDER_WIDTH = 1280;
+const unsigned int BENCH_RENDER_HEIGHT = 768;
+const int BENCH_RENDER_FRAMES = 60;
+
+// Results are summed into here so the optimizer can't drop the work being timed
+static volatile double benchSink = 0.0;
+
+struct BenchSuite {
+    std::string filter;
+    std::vector<BenchResult> results;
+};
+
+static bool wanted(const BenchSuite& suite, const std::string& name) {
+    return suite.filter.empty() || name.find(suite.filter) != std::string::npos;
+}
+
+// `setup` runs untimed before every repeat (and the warm-up), `body` is timed
+static void measure(BenchSuite& suite, const std::string& name, const std::string& group, size_t items,
+    const std::function<void()>& setup, const std::function<void()>& body) {
+    BenchResult result;
+    result.name = name;
+    result.group = group;
+    result.items = items;
+    result.repeats = BENCH_REPEATS;
+
+    std::vector<double> nsPerItem;
+    for (int repeat = 0; repeat <= BENCH_REPEATS; ++repeat) {
+        if (setup)
+            setup();
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto end = std::chrono::steady_clock::now();
+        if (repeat > 0)
+            nsPerItem.push_back(std::chrono::duration<double, std::nano>(end - start).count() / std::max<size_t>(items, 1));
+    }
+
+    std::sort(nsPerItem.begin(), nsPerItem.end());
+    result.bestNsPerItem = nsPerItem.front();
+    result.medianNsPerItem = nsPerItem[nsPerItem.size() / 2];
+    std::cout << name << ": " << result.medianNsPerItem << " ns per item (best " << result.bestNsPerItem << ")" << std::endl;
+    suite.results.push_back(result);
+}
+
+static void skip(BenchSuite& suite, const std::string& name, const std::string& group) {
+    BenchResult result;
+    result.name = name;
+    result.group = group;
+    result.skipped = true;
+    std::cout << name << ": skipped" << std::endl;
+    suite.results.push_back(result);
+}
+
+// `count` cars at random road points with room around them, each holding a fixed mix of controls
+static void spawnBenchFleet(Fleet& fleet, const RoadMap& roads, size_t count, std::mt19937& random) {
+    fleet = Fleet();
+    std::uniform_real_distribution<float> x(0.f, static_cast<float>(roads.surface.width));
+    std::uniform_real_distribution<float> y(0.f, static_cast<float>(roads.surface.height));
+    std::uniform_real_distribution<float> angle(0.f, 360.f);
+    for (size_t i = 0; i < count; ++i) {
+        sf::Vector2f position(x(random), y(random));
+        for (int attempt = 0; attempt < 1000; ++attempt) {
+            if (surfaceAt(roads.surface, position.x, position.y) == SURFACE_ROAD
+                && distanceToEdge(roads.distance, position.x, position.y) > CAR_WIDTH)
+                break;
+            position = sf::Vector2f(x(random), y(random));
+        }
+        size_t vehicle = addVehicle(fleet, position, angle(random), MAX_FUEL);
+        const std::uint8_t mixes[] = { CONTROL_ACCELERATE, CONTROL_ACCELERATE | CONTROL_TURN_LEFT,
+            CONTROL_ACCELERATE | CONTROL_TURN_RIGHT, CONTROL_BRAKE };
+        fleet.controls[vehicle] = mixes[vehicle % 4];
+    }
+}
+
+static void benchPhysics(BenchSuite& suite, const RoadMap& roads) {
+    // The per-car reference functions the batch kernels are checked against
+    const size_t cars = 1024;
+    const int ticks = 1000;
+    const float deltaTime = 1.f / SIMULATION_TICK_RATE;
+    std::mt19937 random(1);
+    Fleet start;
+    spawnBenchFleet(start, roads, cars, random);
+    Fleet fleet;
+
+    if (wanted(suite, "handle_input"))
+        measure(suite, "handle_input", "physics", cars * ticks, [&] { fleet = start; }, [&] {
+            for (int tick = 0; tick < ticks; ++tick)
+                for (size_t i = 0; i < cars; ++i)
+                    handleInput(fleet, i, deltaTime, fleet.profiles[fleet.profile[i]]);
+            benchSink = benchSink + fleet.speed[0];
+        });
+    if (wanted(suite, "handle_input_update_car"))
+        measure(suite, "handle_input_update_car", "physics", cars * ticks, [&] { fleet = start; }, [&] {
+            for (int tick = 0; tick < ticks; ++tick) {
+                for (size_t i = 0; i < cars; ++i) {
+                    handleInput(fleet, i, deltaTime, fleet.profiles[fleet.profile[i]]);
+                    updateCar(fleet, i, deltaTime, roads);
+                }
+            }
+            benchSink = benchSink + fleet.positionX[0];
+        });
+
+    // The batch integrator alone: all cars, all trucks, and a car/truck/bus fleet in three runs.
+    // The mixed fleet should cost the average of its models per car, with nothing on top.
+    VehicleProfile truck;
+    truck.name = "truck";
+    truck.model = VEHICLE_MODEL_HEAVY;
+    truck.tuning.drag = 0.25f;
+    truck.tuning.understeer = 0.4f;
+    VehicleProfile bus = truck;
+    bus.name = "bus";
+    bus.tuning.maxSpeed = 80.f;
+    Fleet heavy = start;
+    Fleet mixed = start;
+    heavy.profiles.assign(1, truck);
+    mixed.profiles.push_back(truck);
+    mixed.profiles.push_back(bus);
+    for (size_t i = 0; i < cars; ++i)
+        setVehicleProfile(mixed, i, static_cast<std::uint8_t>(i * 3 / cars));
+    const std::pair<const char*, const Fleet*> integrators[] = {
+        { "integrate_car", &start }, { "integrate_heavy", &heavy }, { "integrate_mixed", &mixed }
+    };
+    for (const auto& integrator : integrators) {
+        if (!wanted(suite, integrator.first))
+            continue;
+        measure(suite, integrator.first, "physics", cars * ticks, [&] {
+            fleet = *integrator.second;
+            fleet.targetX.resize(cars);
+            fleet.targetY.resize(cars);
+        }, [&] {
+            for (int tick = 0; tick < ticks; ++tick)
+                integrateControls(fleet, deltaTime);
+            benchSink = benchSink + fleet.targetX[0];
+        });
+    }
+}
+
+static void benchRoadLookups(BenchSuite& suite, const RoadMap& roads) {
+    // Random points anywhere on the map, and one-tick moves from random road points
+    std::mt19937 random(2);
+    std::uniform_real_distribution<float> x(0.f, static_cast<float>(roads.surface.width));
+    std::uniform_real_distribution<float> y(0.f, static_cast<float>(roads.surface.height));
+    std::uniform_real_distribution<float> angle(0.f, 6.2831853f);
+    std::vector<float> pointX(BENCH_LOOKUPS), pointY(BENCH_LOOKUPS), moveX(BENCH_LOOKUPS), moveY(BENCH_LOOKUPS);
+    const float step = MAX_SPEED / SIMULATION_TICK_RATE;
+    for (size_t i = 0; i < BENCH_LOOKUPS; ++i) {
+        pointX[i] = x(random);
+        pointY[i] = y(random);
+        float heading = angle(random);
+        moveX[i] = pointX[i] + std::cos(heading) * step;
+        moveY[i] = pointY[i] + std::sin(heading) * step;
+    }
+
+    if (wanted(suite, "surface_at"))
+        measure(suite, "surface_at", "road", BENCH_LOOKUPS, nullptr, [&] {
+            unsigned int sum = 0;
+            for (size_t i = 0; i < BENCH_LOOKUPS; ++i)
+                sum += surfaceAt(roads.surface, pointX[i], pointY[i]);
+            benchSink = benchSink + sum;
+        });
+    if (wanted(suite, "distance_to_edge"))
+        measure(suite, "distance_to_edge", "road", BENCH_LOOKUPS, nullptr, [&] {
+            float sum = 0.f;
+            for (size_t i = 0; i < BENCH_LOOKUPS; ++i)
+                sum += distanceToEdge(roads.distance, pointX[i], pointY[i]);
+            benchSink = benchSink + sum;
+        });
+    if (wanted(suite, "surface_for_move"))
+        measure(suite, "surface_for_move", "road", BENCH_LOOKUPS, nullptr, [&] {
+            unsigned int sum = 0;
+            for (size_t i = 0; i < BENCH_LOOKUPS; ++i)
+                sum += surfaceForMove(roads, pointX[i], pointY[i], moveX[i], moveY[i]);
+            benchSink = benchSink + sum;
+        });
+}
+
+static void benchFleetTicks(BenchSuite& suite, const RoadMap& roads) {
+    // Whole ticks: batch kernels, road gather and the neighbour hash. 100k cars don't fit on the
+    // roads of the map, so collisions are only switched on for the smallest fleet.
+    const float deltaTime = 1.f / SIMULATION_TICK_RATE;
+    for (size_t cars : { size_t(1000), size_t(10000), size_t(100000) }) {
+        size_t ticks = std::max<size_t>(BENCH_FLEET_CAR_TICKS / cars, 5);
+        std::string name = "fleet_tick_" + std::to_string(cars / 1000) + "k";
+        std::string scalarName = "fleet_tick_scalar_" + std::to_string(cars / 1000) + "k";
+        std::string collisionName = "fleet_tick_collisions_" + std::to_string(cars / 1000) + "k";
+        bool collisions = cars == 1000 && wanted(suite, collisionName);
+        if (!wanted(suite, name) && !wanted(suite, scalarName) && !collisions)
+            continue;
+
+        std::mt19937 random(3);
+        Fleet start;
+        spawnBenchFleet(start, roads, cars, random);
+        Fleet fleet;
+        if (wanted(suite, name))
+            measure(suite, name, "fleet", cars * ticks, [&] { fleet = start; }, [&] {
+                for (size_t tick = 0; tick < ticks; ++tick)
+                    stepFleet(fleet, deltaTime, roads);
+                benchSink = benchSink + fleet.positionX[0];
+            });
+        if (wanted(suite, scalarName))
+            measure(suite, scalarName, "fleet", cars * ticks, [&] { fleet = start; }, [&] {
+                for (size_t tick = 0; tick < ticks; ++tick)
+                    stepFleetScalar(fleet, deltaTime, roads);
+                benchSink = benchSink + fleet.positionX[0];
+            });
+        if (collisions)
+            measure(suite, collisionName, "fleet", cars * ticks, [&] { fleet = start; fleet.collisions = true; }, [&] {
+                for (size_t tick = 0; tick < ticks; ++tick)
+                    stepFleet(fleet, deltaTime, roads);
+                benchSink = benchSink + fleet.positionX[0];
+            });
+    }
+}
+
+static void benchAi(BenchSuite& suite, const RoadMap& roads) {
+    if (!wanted(suite, "route_plan") && !wanted(suite, "ai_drive"))
+        return;
+
+    RoadGraph graph;
+    loadRoadGraph(graph, roads, ROAD_GRAPH_CACHE_FILE);
+    std::uint32_t nodes = static_cast<std::uint32_t>(graph.nodes.size());
+    if (nodes == 0) {
+        skip(suite, "route_plan_cold", "ai");
+        skip(suite, "route_plan_cached", "ai");
+        skip(suite, "ai_drive_1k", "ai");
+        return;
+    }
+
+    // A fixed set of distinct node pairs small enough for the route cache (every pair on a small
+    // graph), planned with an empty cache (a full A* each) and with every route cached
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> routes;
+    if (static_cast<size_t>(nodes) * nodes <= ROUTE_CACHE_LIMIT) {
+        for (std::uint32_t from = 0; from < nodes; ++from)
+            for (std::uint32_t to = 0; to < nodes; ++to)
+                routes.emplace_back(from, to);
+    }
+    else {
+        std::mt19937 random(3);
+        std::uniform_int_distribution<std::uint32_t> node(0, nodes - 1);
+        std::set<std::pair<std::uint32_t, std::uint32_t>> chosen;
+        while (chosen.size() < ROUTE_CACHE_LIMIT)
+            chosen.insert({ node(random), node(random) });
+        routes.assign(chosen.begin(), chosen.end());
+    }
+
+    RoutePlanner planner;
+    auto planAll = [&] {
+        size_t found = 0;
+        for (const std::pair<std::uint32_t, std::uint32_t>& route : routes)
+            found += planRoute(planner, route.first, route.second)->found;
+        benchSink = benchSink + found;
+    };
+    if (wanted(suite, "route_plan_cold"))
+        measure(suite, "route_plan_cold", "ai", routes.size(), [&] { initRoutePlanner(planner, graph); }, planAll);
+    if (wanted(suite, "route_plan_cached"))
+        measure(suite, "route_plan_cached", "ai", routes.size(), [&] { initRoutePlanner(planner, graph); planAll(); }, planAll);
+
+    // Steering alone (no physics) for a thousand AI cars; plans are made on the first tick
+    if (wanted(suite, "ai_drive_1k")) {
+        const size_t cars = 1000;
+        const int ticks = 100;
+        Fleet start;
+        AiTraffic startTraffic;
+        spawnAiTraffic(startTraffic, start, graph, roads, cars, 4);
+        Fleet fleet;
+        AiTraffic traffic;
+        measure(suite, "ai_drive_1k", "ai", cars * ticks, [&] {
+            fleet = start;
+            traffic = AiTraffic();
+            attachAiTraffic(traffic, graph, roads, 0, cars, 4);
+        }, [&] {
+            for (int tick = 1; tick <= ticks; ++tick)
+                driveAiTraffic(traffic, fleet, tick);
+            benchSink = benchSink + fleet.controls[0];
+        });
+    }
+}
+
+static void benchRendering(BenchSuite& suite, const RoadMap& roads) {
+    // Offscreen, so no window or display is needed; only skipped without any OpenGL context
+    const char* names[] = { "render_fleet_10k", "render_fleet_culled_100k" };
+    if (!wanted(suite, names[0]) && !wanted(suite, names[1]))
+        return;
+
+    sf::RenderTexture target;
+    if (!target.create(BENCH_RENDER_WIDTH, BENCH_RENDER_HEIGHT)) {
+        for (const char* name : names)
+            skip(suite, name, "render");
+        return;
+    }
+
+    FleetSprites sprites;
+    loadFleetSprites(sprites, { "car4.png", "car1.png" });
+    sf::View view(sf::FloatRect(0.f, 0.f, static_cast<float>(BENCH_RENDER_WIDTH), static_cast<float>(BENCH_RENDER_HEIGHT)));
+    view.setCenter(roads.surface.width / 2.f, roads.surface.height / 2.f);
+    target.setView(view);
+
+    // 10k cars all inside the view, then 100k spread over the whole map with only a few in view
+    std::mt19937 random(5);
+    for (int pass = 0; pass < 2; ++pass) {
+        if (!wanted(suite, names[pass]))
+            continue;
+
+        Fleet fleet;
+        size_t cars = pass == 0 ? 10000 : 100000;
+        sf::FloatRect area = pass == 0
+            ? sf::FloatRect(view.getCenter() - view.getSize() / 2.f, view.getSize())
+            : sf::FloatRect(0.f, 0.f, static_cast<float>(roads.surface.width), static_cast<float>(roads.surface.height));
+        std::uniform_real_distribution<float> x(area.left, area.left + area.width);
+        std::uniform_real_distribution<float> y(area.top, area.top + area.height);
+        std::uniform_real_distribution<float> angle(0.f, 360.f);
+        for (size_t i = 0; i < cars; ++i)
+            addVehicle(fleet, sf::Vector2f(x(random), y(random)), angle(random), MAX_FUEL);
+
+        measure(suite, names[pass], "render", cars * BENCH_RENDER_FRAMES, nullptr, [&] {
+            for (int frame = 0; frame < BENCH_RENDER_FRAMES; ++frame) {
+                target.clear();
+                drawFleet(target, sprites, fleet, 1.f, view);
+                target.display();
+            }
+        });
+    }
+}
+
+static void writeJsonString(std::ofstream& file, const std::string& text) {
+    file << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\')
+            file << '\\';
+        file << c;
+    }
+    file << '"';
+}
+
+static bool writeBenchReport(const BenchSuite& suite, const std::string& maskFile, const std::string& reportFile) {
+    std::ofstream file(reportFile, std::ios::trunc);
+    if (!file) {
+        std::cerr << "Error writing benchmark report: " << reportFile << std::endl;
+        return false;
+    }
+
+    file << "{\n  \"instructionSet\": ";
+    writeJsonString(file, batchInstructionSet());
+    file << ",\n  \"mask\": ";
+    writeJsonString(file, maskFile);
+    file << ",\n  \"benchmarks\": [";
+    for (size_t i = 0; i < suite.results.size(); ++i) {
+        const BenchResult& result = suite.results[i];
+        file << (i == 0 ? "\n" : ",\n") << "    { \"name\": ";
+        writeJsonString(file, result.name);
+        file << ", \"group\": ";
+        writeJsonString(file, result.group);
+        file << ", \"items\": " << result.items << ", \"repeats\": " << result.repeats
+            << ", \"bestNsPerItem\": " << result.bestNsPerItem << ", \"medianNsPerItem\": " << result.medianNsPerItem
+            << ", \"itemsPerSecond\": " << (result.medianNsPerItem > 0.0 ? 1e9 / result.medianNsPerItem : 0.0)
+            << ", \"skipped\": " << (result.skipped ? "true" : "false") << " }";
+    }
+    file << "\n  ]\n}\n";
+    return static_cast<bool>(file);
+}
+
+int runBenchmarks(const std::string& maskFile, const std::string& reportFile, const std::string& filter) {
+    RoadMap roads;
+    if (!loadRoadMap(roads, maskFile))
+        return -1;
+
+    BenchSuite suite;
+    suite.filter = filter;
+    std::cout << "Instruction set: " << batchInstructionSet() << std::endl;
+    benchPhysics(suite, roads);
+    benchRoadLookups(suite, roads);
+    benchFleetTicks(suite, roads);
+    benchAi(suite, roads);
+    benchRendering(suite, roads);
+
+    if (!writeBenchReport(suite, maskFile, reportFile))
+        return -1;
+    std::cout << "Wrote " << suite.results.size() << " results to " << reportFile << std::endl;
+    return 0;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// One measured code path. Each benchmark runs `repeats` times after a warm-up run;
+// the figures are per item (a car tick, a lookup, a drawn car) over one repeat.
+struct BenchResult {
+    std::string name;
+    std::string group;           // "physics", "road", "fleet", "ai" or "render"
+    size_t items = 0;            // Items processed per repeat
+    int repeats = 0;
+    double bestNsPerItem = 0.0;
+    double medianNsPerItem = 0.0;
+    bool skipped = false;        // E.g. no OpenGL context for the render benchmarks
+};
+
+// Run every benchmark on the given road mask and write the results as JSON to `reportFile`:
+//   { "instructionSet": "...", "mask": "...", "benchmarks": [ { "name", "group", "items",
+//     "repeats", "bestNsPerItem", "medianNsPerItem", "itemsPerSecond", "skipped" }, ... ] }
+// `filter` keeps only benchmarks whose name contains it. Returns 0 on success.
+int runBenchmarks(const std::string& maskFile, const std::string& reportFile, const std::string& filter = "");
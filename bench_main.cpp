@@ -0,0 +1,11 @@
+#include <string>
+#include "bench.h"
+
+// Time the physics, road lookups, fleet ticks, AI and offscreen rendering; results go to JSON.
+//   bench [report.json] [filter]
+int main(int argc, char* argv[])
+{
+    std::string report = argc >= 2 ? argv[1] : "bench_report.json";
+    std::string filter = argc >= 3 ? argv[2] : "";
+    return runBenchmarks("map_mask.jpeg", report, filter);
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+
+// Handling of the built-in car profile (see vehicle_profiles.h), and road behavior
+const float MAX_SPEED = 120.f;
+const float ACCELERATION = 100.f;
+const float TURN_RATE = 120.f;
+const float FRICTION = 26.f;
+const float DRAG = 0.02f;
+const float MIN_TURN_SPEED = 20.f;
+const float REFUEL_COOLDOWN = 0.33f;
+const float MAX_FUEL = 2000.f;
+
+// Handling values of one vehicle profile; scenarios may vary them too
+struct CarTuning {
+    float maxSpeed = MAX_SPEED;
+    float acceleration = ACCELERATION;
+    float friction = FRICTION;           // Rolling friction, speed lost per second
+    float drag = DRAG;                   // Air resistance, fraction of speed lost per second
+    float turnRate = TURN_RATE;          // Degrees per second at full speed
+    float minTurnSpeed = MIN_TURN_SPEED; // Slower than this the wheels don't steer
+    float understeer = 0.f;              // Heavy model only: fraction of the turn rate lost at full speed
+};
+
+// Size of the car body in world pixels
+const float CAR_LENGTH = 80.f;
+const float CAR_WIDTH = 40.f;
+
+// Driver inputs for a single tick, scripted by a scenario; the window reads them through InputState
+struct CarControls {
+    bool accelerate = false;  // W
+    bool brake = false;       // S
+    bool turnLeft = false;    // A
+    bool turnRight = false;   // D
+    bool refuel = false;      // F
+};
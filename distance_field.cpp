@@ -0,0 +1,254 @@
+#include "distance_field.h"
+#include "car.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+namespace {
+
+const char DISTANCE_FIELD_MAGIC[4] = { 'R', 'S', 'D', 'F' };
+
+// Off-road blots up to this many pixels inside a road are noise in the mask, not obstacles
+const size_t DISTANCE_FIELD_SPECK_PIXELS = 64;
+
+// Quantization of the stored field, so nearby lookups may disagree by this much
+const float COLLISION_TOLERANCE = 1.f / DISTANCE_FIELD_SCALE;
+
+// 1D squared Euclidean distance transform (Felzenszwalb & Huttenlocher) of f into d.
+// Infinite entries have no parabola of their own. v and z are scratch buffers of at
+// least n and n + 1 entries.
+void distanceTransform1D(const float* f, float* d, int n, int* v, float* z) {
+    const float infinity = std::numeric_limits<float>::infinity();
+    auto intersection = [f](int q, int p) {
+        return static_cast<float>(((f[q] + double(q) * q) - (f[p] + double(p) * p)) / (2.0 * q - 2.0 * p));
+    };
+
+    // Lower envelope of the parabolas rooted at every finite entry
+    int k = -1;
+    for (int q = 0; q < n; ++q) {
+        if (f[q] == infinity)
+            continue;
+        if (k < 0) {
+            k = 0;
+            v[0] = q;
+            z[0] = -infinity;
+            z[1] = infinity;
+            continue;
+        }
+
+        float s = intersection(q, v[k]);
+        while (s <= z[k]) {
+            --k;
+            s = intersection(q, v[k]);
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = infinity;
+    }
+
+    if (k < 0) {
+        std::fill(d, d + n, infinity);
+        return;
+    }
+
+    k = 0;
+    for (int q = 0; q < n; ++q) {
+        while (z[k + 1] < q)
+            ++k;
+        d[q] = static_cast<float>((q - v[k]) * (q - v[k])) + f[v[k]];
+    }
+}
+
+// Replace every cell with its squared distance to the nearest zero cell (all others must be infinite)
+void distanceTransform2D(std::vector<float>& grid, int width, int height) {
+    int longest = std::max(width, height);
+    std::vector<float> f(longest), d(longest), z(longest + 1);
+    std::vector<int> v(longest);
+
+    for (int x = 0; x < width; ++x) {
+        for (int y = 0; y < height; ++y)
+            f[y] = grid[static_cast<size_t>(y) * width + x];
+        distanceTransform1D(f.data(), d.data(), height, v.data(), z.data());
+        for (int y = 0; y < height; ++y)
+            grid[static_cast<size_t>(y) * width + x] = d[y];
+    }
+
+    for (int y = 0; y < height; ++y) {
+        float* row = &grid[static_cast<size_t>(y) * width];
+        std::copy(row, row + width, f.begin());
+        distanceTransform1D(f.data(), row, width, v.data(), z.data());
+    }
+}
+
+bool isDrivable(SurfaceType type) {
+    return type == SURFACE_ROAD || type == SURFACE_FUEL;
+}
+
+// Mark small enclosed off-road blots drivable. Left in, each would act as a wall a car's
+// width across in the middle of the road.
+void fillSpecks(std::vector<std::uint8_t>& drivable, int width, int height) {
+    std::vector<std::uint8_t> seen(drivable.size(), 0);
+    std::vector<size_t> stack, blot;
+    const int stepX[4] = { 1, -1, 0, 0 };
+    const int stepY[4] = { 0, 0, 1, -1 };
+    for (size_t i = 0; i < drivable.size(); ++i) {
+        if (drivable[i] || seen[i])
+            continue;
+
+        bool touchesBorder = false;
+        blot.clear();
+        stack.assign(1, i);
+        seen[i] = 1;
+        while (!stack.empty()) {
+            size_t pixel = stack.back();
+            stack.pop_back();
+            // Past the limit the blot is kept anyway, so only remember it as far as that
+            if (blot.size() <= DISTANCE_FIELD_SPECK_PIXELS)
+                blot.push_back(pixel);
+            int x = static_cast<int>(pixel % width), y = static_cast<int>(pixel / width);
+            for (int k = 0; k < 4; ++k) {
+                int nx = x + stepX[k], ny = y + stepY[k];
+                if (nx < 0 || ny < 0 || nx >= width || ny >= height) {
+                    touchesBorder = true;
+                    continue;
+                }
+                size_t next = static_cast<size_t>(ny) * width + nx;
+                if (!drivable[next] && !seen[next]) {
+                    seen[next] = 1;
+                    stack.push_back(next);
+                }
+            }
+        }
+
+        if (!touchesBorder && blot.size() <= DISTANCE_FIELD_SPECK_PIXELS) {
+            for (size_t pixel : blot)
+                drivable[pixel] = 1;
+        }
+    }
+}
+
+}
+
+void buildDistanceField(DistanceField& field, const SurfaceGrid& grid) {
+    field.width = grid.width;
+    field.height = grid.height;
+    field.cells.assign(static_cast<size_t>(grid.width) * grid.height, 0);
+    if (field.cells.empty())
+        return;
+
+    std::vector<std::uint8_t> drivable(field.cells.size());
+    for (unsigned int y = 0; y < grid.height; ++y) {
+        for (unsigned int x = 0; x < grid.width; ++x)
+            drivable[static_cast<size_t>(y) * grid.width + x] = isDrivable(surfaceAt(grid, static_cast<float>(x), static_cast<float>(y)));
+    }
+    fillSpecks(drivable, static_cast<int>(grid.width), static_cast<int>(grid.height));
+
+    // Pad by one cell of off-road so the map border acts as an edge
+    int paddedWidth = static_cast<int>(grid.width) + 2;
+    int paddedHeight = static_cast<int>(grid.height) + 2;
+    const float infinity = std::numeric_limits<float>::infinity();
+    std::vector<float> toOffRoad(static_cast<size_t>(paddedWidth) * paddedHeight);
+    std::vector<float> toRoad(toOffRoad.size());
+    for (int y = 0; y < paddedHeight; ++y) {
+        for (int x = 0; x < paddedWidth; ++x) {
+            bool inside = x > 0 && y > 0 && x <= static_cast<int>(grid.width) && y <= static_cast<int>(grid.height);
+            bool open = inside && drivable[static_cast<size_t>(y - 1) * grid.width + (x - 1)];
+            size_t index = static_cast<size_t>(y) * paddedWidth + x;
+            toOffRoad[index] = open ? infinity : 0.f;
+            toRoad[index] = open ? 0.f : infinity;
+        }
+    }
+    distanceTransform2D(toOffRoad, paddedWidth, paddedHeight);
+    distanceTransform2D(toRoad, paddedWidth, paddedHeight);
+
+    // Distances run between cell centers; the edge itself lies half a cell away
+    for (unsigned int y = 0; y < grid.height; ++y) {
+        for (unsigned int x = 0; x < grid.width; ++x) {
+            size_t padded = static_cast<size_t>(y + 1) * paddedWidth + (x + 1);
+            float distance = toRoad[padded] == 0.f ? std::sqrt(toOffRoad[padded]) - 0.5f
+                                                   : 0.5f - std::sqrt(toRoad[padded]);
+            float stored = std::round(std::max(-127.f, std::min(127.f, distance * DISTANCE_FIELD_SCALE)));
+            field.cells[static_cast<size_t>(y) * grid.width + x] = static_cast<std::int8_t>(stored);
+        }
+    }
+}
+
+bool saveDistanceField(const DistanceField& field, const std::string& path, std::uint64_t key) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    file.write(DISTANCE_FIELD_MAGIC, sizeof(DISTANCE_FIELD_MAGIC));
+    file.write(reinterpret_cast<const char*>(&DISTANCE_FIELD_VERSION), sizeof(DISTANCE_FIELD_VERSION));
+    file.write(reinterpret_cast<const char*>(&field.width), sizeof(field.width));
+    file.write(reinterpret_cast<const char*>(&field.height), sizeof(field.height));
+    file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+    file.write(reinterpret_cast<const char*>(field.cells.data()), field.cells.size());
+    return static_cast<bool>(file);
+}
+
+bool loadDistanceField(DistanceField& field, const std::string& path, std::uint64_t key) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    char magic[4];
+    std::uint32_t version = 0;
+    std::uint64_t storedKey = 0;
+    unsigned int width = 0, height = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&width), sizeof(width));
+    file.read(reinterpret_cast<char*>(&height), sizeof(height));
+    file.read(reinterpret_cast<char*>(&storedKey), sizeof(storedKey));
+    if (!file || !std::equal(magic, magic + 4, DISTANCE_FIELD_MAGIC) ||
+        version != DISTANCE_FIELD_VERSION || storedKey != key)
+        return false;
+
+    field.width = width;
+    field.height = height;
+    field.cells.resize(static_cast<size_t>(width) * height);
+    file.read(reinterpret_cast<char*>(field.cells.data()), field.cells.size());
+    return static_cast<bool>(file);
+}
+
+float bodyClearance(const DistanceField& field, float x, float y, float axisX, float axisY) {
+    // Three circles of radius CAR_WIDTH / 2 spaced along the axis span the whole body
+    const float radius = CAR_WIDTH / 2.f;
+    const float offset = CAR_LENGTH / 2.f - radius;
+
+    float center = distanceToEdge(field, x, y);
+    float front = distanceToEdge(field, x + axisX * offset, y + axisY * offset);
+    float back = distanceToEdge(field, x - axisX * offset, y - axisY * offset);
+    return std::min(center, std::min(front, back)) - radius;
+}
+
+bool sweepBodyHitsEdge(const DistanceField& field, float fromX, float fromY, float toX, float toY) {
+    float dx = toX - fromX;
+    float dy = toY - fromY;
+    float length = std::sqrt(dx * dx + dy * dy);
+    if (length <= 0.f)
+        return false;
+
+    // The body faces along the movement (or directly against it when reversing, which
+    // is the same capsule)
+    float axisX = dx / length;
+    float axisY = dy / length;
+
+    // A car that already overlaps the edge may still move as long as it doesn't dig in deeper
+    float allowed = std::min(0.f, bodyClearance(field, fromX, fromY, axisX, axisY)) - COLLISION_TOLERANCE;
+
+    float t = 0.f;
+    while (true) {
+        float clearance = bodyClearance(field, fromX + dx * t, fromY + dy * t, axisX, axisY) - allowed;
+        if (clearance < 0.f)
+            return true;
+        if (t >= 1.f)
+            return false;
+
+        // Nothing can be hit within `clearance` pixels, so skip ahead by that much
+        t = std::min(1.f, t + std::max(clearance, COLLISION_TOLERANCE) / length);
+    }
+}
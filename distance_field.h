@@ -0,0 +1,42 @@
+#pragma once
+#include "road_surface.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Signed distances are stored in half-pixel steps in one byte per cell
+const float DISTANCE_FIELD_SCALE = 2.f;                         // Stored units per pixel
+const float DISTANCE_FIELD_LIMIT = 127.f / DISTANCE_FIELD_SCALE;  // Largest distance kept, in pixels
+const std::uint32_t DISTANCE_FIELD_VERSION = 3;                 // Bumped whenever the field's values change; 3 fills off-road specks
+
+// Signed distance from every cell of the road mask to the nearest road edge: positive on
+// drivable cells (road and fuel zones), negative off-road. The map border counts as an edge.
+struct DistanceField {
+    unsigned int width = 0;
+    unsigned int height = 0;
+    std::vector<std::int8_t> cells;
+};
+
+void buildDistanceField(DistanceField& field, const SurfaceGrid& grid);
+
+// Cache on disk, keyed by a hash of the surface grid it was built from
+bool saveDistanceField(const DistanceField& field, const std::string& path, std::uint64_t key);
+bool loadDistanceField(DistanceField& field, const std::string& path, std::uint64_t key);
+
+// O(1) "how far until off-road" query in pixels; outside the map is fully off-road
+inline float distanceToEdge(const DistanceField& field, float x, float y) {
+    if (x < 0 || y < 0 || x >= field.width || y >= field.height)
+        return -DISTANCE_FIELD_LIMIT;
+
+    size_t index = static_cast<size_t>(y) * field.width + static_cast<size_t>(x);
+    return field.cells[index] / DISTANCE_FIELD_SCALE;
+}
+
+// Clearance of the car body (a capsule covering CAR_LENGTH x CAR_WIDTH) centered at x, y
+// and pointing along the unit vector axisX, axisY. Negative when the body overlaps off-road.
+float bodyClearance(const DistanceField& field, float x, float y, float axisX, float axisY);
+
+// True if moving the body from (fromX, fromY) to (toX, toY) runs into off-road anywhere along
+// the way. Steps by the clearance at each point, so it can't tunnel through thin strips and
+// needs only a handful of lookups per move.
+bool sweepBodyHitsEdge(const DistanceField& field, float fromX, float fromY, float toX, float toY);
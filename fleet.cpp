@@ -0,0 +1,393 @@
+#include "fleet.h"
+#include "batch_physics.h"
+#include <algorithm>
+#include <cmath>
+
+size_t fleetSize(const Fleet& fleet) {
+    return fleet.speed.size();
+}
+
+size_t addVehicle(Fleet& fleet, const sf::Vector2f& position, float angle, float fuel, std::uint8_t profile) {
+    fleet.positionX.push_back(0.f);
+    fleet.positionY.push_back(0.f);
+    fleet.speed.push_back(0.f);
+    fleet.angle.push_back(0.f);
+    fleet.fuel.push_back(0.f);
+    fleet.refuelCooldown.push_back(0.f);
+    fleet.mileage.push_back(0.0);
+    fleet.controls.push_back(0);
+    fleet.profile.push_back(profile);
+    fleet.previousX.push_back(0.f);
+    fleet.previousY.push_back(0.f);
+    fleet.previousAngle.push_back(0.f);
+
+    size_t vehicle = fleetSize(fleet) - 1;
+    resetVehicle(fleet, vehicle, position, angle, fuel);
+    fleet.profileRunsStale = true;
+    return vehicle;
+}
+
+void setVehicleProfile(Fleet& fleet, size_t vehicle, std::uint8_t profile) {
+    fleet.profile[vehicle] = profile;
+    fleet.profileRunsStale = true;
+}
+
+const CarTuning& vehicleTuning(const Fleet& fleet, size_t vehicle) {
+    return fleet.profiles[fleet.profile[vehicle]].tuning;
+}
+
+void updateProfileRuns(Fleet& fleet) {
+    if (!fleet.profileRunsStale)
+        return;
+
+    fleet.profileRuns.clear();
+    size_t count = fleetSize(fleet);
+    for (size_t i = 0; i < count; ++i) {
+        if (fleet.profileRuns.empty() || fleet.profileRuns.back().profile != fleet.profile[i]) {
+            FleetRun run;
+            run.begin = i;
+            run.profile = fleet.profile[i];
+            fleet.profileRuns.push_back(run);
+        }
+        fleet.profileRuns.back().end = i + 1;
+    }
+    fleet.profileRunsStale = false;
+}
+
+void resetVehicle(Fleet& fleet, size_t vehicle, const sf::Vector2f& position, float angle, float fuel) {
+    fleet.positionX[vehicle] = position.x;
+    fleet.positionY[vehicle] = position.y;
+    fleet.speed[vehicle] = 0.f;
+    fleet.angle[vehicle] = angle;
+    fleet.fuel[vehicle] = fuel;
+    fleet.refuelCooldown[vehicle] = 0.f;
+    fleet.mileage[vehicle] = 0.0;
+    fleet.controls[vehicle] = 0;
+
+    // Teleport without interpolating from the old location
+    fleet.previousX[vehicle] = position.x;
+    fleet.previousY[vehicle] = position.y;
+    fleet.previousAngle[vehicle] = angle;
+}
+
+std::uint8_t packControls(const CarControls& controls) {
+    std::uint8_t bits = 0;
+    if (controls.accelerate) bits |= CONTROL_ACCELERATE;
+    if (controls.brake) bits |= CONTROL_BRAKE;
+    if (controls.turnLeft) bits |= CONTROL_TURN_LEFT;
+    if (controls.turnRight) bits |= CONTROL_TURN_RIGHT;
+    if (controls.refuel) bits |= CONTROL_REFUEL;
+    return bits;
+}
+
+void handleInput(Fleet& fleet, size_t vehicle, float deltaTime, const VehicleProfile& profile) {
+    const CarTuning& tuning = profile.tuning;
+    bool heavy = profile.model == VEHICLE_MODEL_HEAVY;
+    float& speed = fleet.speed[vehicle];
+    float& fuel = fleet.fuel[vehicle];
+    std::uint8_t controls = fleet.controls[vehicle];
+
+    if (fuel <= 0)
+        return;
+
+    // Acceleration and braking
+    if (controls & CONTROL_ACCELERATE) {
+        speed += tuning.acceleration * deltaTime;
+        if (speed > tuning.maxSpeed)
+            speed = tuning.maxSpeed;
+        fuel -= 5 * deltaTime; // Consume more fuel for acceleration
+    }
+
+    if (controls & CONTROL_BRAKE) {
+        speed -= tuning.acceleration * deltaTime * 0.5f;
+        if (speed < -tuning.maxSpeed / 3)
+            speed = -tuning.maxSpeed / 3;
+        fuel -= 2 * deltaTime;
+    }
+
+    // Apply drag and friction
+    if (heavy)
+        speed *= (1 - tuning.drag * deltaTime * std::abs(speed) / tuning.maxSpeed);  // Grows with the square of speed
+    else
+        speed *= (1 - tuning.drag * deltaTime);  // Simulates air resistance
+    if (speed > 0) {
+        speed -= tuning.friction * deltaTime;
+        if (speed < 0) speed = 0;
+    }
+    else if (speed < 0) {
+        speed += tuning.friction * deltaTime;
+        if (speed > 0) speed = 0;
+    }
+
+    // Turning with dynamic handling based on speed; heavy vehicles lose some of it at speed
+    float turn = tuning.turnRate * deltaTime * (speed / tuning.maxSpeed);
+    if (heavy)
+        turn *= 1 - tuning.understeer * std::abs(speed) / tuning.maxSpeed;
+    if ((controls & CONTROL_TURN_LEFT) && std::abs(speed) > tuning.minTurnSpeed) {
+        fleet.angle[vehicle] -= turn;
+    }
+    if ((controls & CONTROL_TURN_RIGHT) && std::abs(speed) > tuning.minTurnSpeed) {
+        fleet.angle[vehicle] += turn;
+    }
+}
+
+void updateCar(Fleet& fleet, size_t vehicle, float deltaTime, const RoadMap& roads) {
+    float& speed = fleet.speed[vehicle];
+
+    if (fleet.refuelCooldown[vehicle] > 0)
+        fleet.refuelCooldown[vehicle] -= deltaTime;
+
+    float angleRadians = fleet.angle[vehicle] * 3.14159f / 180.f;
+    float newX = fleet.positionX[vehicle] + std::cos(angleRadians) * speed * deltaTime;
+    float newY = fleet.positionY[vehicle] + std::sin(angleRadians) * speed * deltaTime;
+
+    SurfaceType surface = surfaceForMove(roads, fleet.positionX[vehicle], fleet.positionY[vehicle], newX, newY);
+    if (surface == SURFACE_OUT_OF_BOUNDS) {
+        speed *= 0.5f; // Halve speed on collision with boundaries
+        return;
+    }
+
+    if (surface == SURFACE_OFF_ROAD) {
+        speed *= 0.7f; // Reduce speed more significantly on off-road
+        return;
+    }
+    else if (surface == SURFACE_FUEL) {
+        // The cooldown runs on simulated time so refueling behaves the same headless
+        if ((fleet.controls[vehicle] & CONTROL_REFUEL) && fleet.refuelCooldown[vehicle] <= 0) {
+            fleet.refuelCooldown[vehicle] = REFUEL_COOLDOWN;
+            if (fleet.fuel[vehicle] < 1051)
+                fleet.fuel[vehicle] += 10;
+            else
+                fleet.fuel[vehicle] = MAX_FUEL;
+        }
+    }
+
+    fleet.positionX[vehicle] = newX;
+    fleet.positionY[vehicle] = newY;
+
+    // Accumulate mileage (the length of the movement vector is simply |speed| * deltaTime)
+    fleet.mileage[vehicle] += std::abs(speed * deltaTime);
+}
+
+// Separating axis test between two car bodies. On overlap, (pushX, pushY) is the shortest
+// move that separates b from a.
+static bool carBodiesOverlap(const Fleet& fleet, size_t a, size_t b, float& pushX, float& pushY) {
+    const float halfLength = CAR_LENGTH / 2.f;
+    const float halfWidth = CAR_WIDTH / 2.f;
+    float angleA = fleet.angle[a] * 3.14159f / 180.f;
+    float angleB = fleet.angle[b] * 3.14159f / 180.f;
+    float axes[4][2] = {
+        { std::cos(angleA), std::sin(angleA) }, { -std::sin(angleA), std::cos(angleA) },
+        { std::cos(angleB), std::sin(angleB) }, { -std::sin(angleB), std::cos(angleB) }
+    };
+    float offsetX = fleet.positionX[b] - fleet.positionX[a];
+    float offsetY = fleet.positionY[b] - fleet.positionY[a];
+
+    float smallest = -1.f;
+    for (const float* axis : axes) {
+        float radiusA = halfLength * std::abs(axes[0][0] * axis[0] + axes[0][1] * axis[1])
+            + halfWidth * std::abs(axes[1][0] * axis[0] + axes[1][1] * axis[1]);
+        float radiusB = halfLength * std::abs(axes[2][0] * axis[0] + axes[2][1] * axis[1])
+            + halfWidth * std::abs(axes[3][0] * axis[0] + axes[3][1] * axis[1]);
+        float distance = offsetX * axis[0] + offsetY * axis[1];
+        float overlap = radiusA + radiusB - std::abs(distance);
+        if (overlap <= 0.f)
+            return false;
+
+        if (smallest < 0.f || overlap < smallest) {
+            // Cars on the same spot are split along a's heading, b forwards
+            float direction = distance < 0.f ? -1.f : 1.f;
+            smallest = overlap;
+            pushX = axis[0] * overlap * direction;
+            pushY = axis[1] * overlap * direction;
+        }
+    }
+    return true;
+}
+
+void collideVehicles(Fleet& fleet, const RoadMap& roads) {
+    // Farthest two bodies can be apart and still touch: both bounding circles
+    const float reach = std::sqrt(CAR_LENGTH * CAR_LENGTH + CAR_WIDTH * CAR_WIDTH);
+
+    forEachClosePair(fleet.neighbours, reach, [&fleet, &roads](std::uint32_t a, std::uint32_t b) {
+        float pushX = 0.f, pushY = 0.f;
+        if (!carBodiesOverlap(fleet, a, b, pushX, pushY))
+            return;
+
+        // Each car takes half the push, unless that would shove it off the road; then the
+        // other car takes all of it (or, pinned on both sides, neither moves)
+        auto canPush = [&fleet, &roads](std::uint32_t vehicle, float dx, float dy) {
+            float x = fleet.positionX[vehicle], y = fleet.positionY[vehicle];
+            return !sweepBodyHitsEdge(roads.distance, x, y, x + dx, y + dy);
+        };
+        bool pushA = canPush(a, -pushX / 2.f, -pushY / 2.f);
+        bool pushB = canPush(b, pushX / 2.f, pushY / 2.f);
+        float shareA = pushA ? (pushB ? 0.5f : 1.f) : 0.f;
+        float shareB = pushB ? (pushA ? 0.5f : 1.f) : 0.f;
+        if (shareA == 1.f && !canPush(a, -pushX, -pushY))
+            shareA = 0.f;
+        if (shareB == 1.f && !canPush(b, pushX, pushY))
+            shareB = 0.f;
+
+        fleet.positionX[a] -= pushX * shareA;
+        fleet.positionY[a] -= pushY * shareA;
+        fleet.positionX[b] += pushX * shareB;
+        fleet.positionY[b] += pushY * shareB;
+        fleet.speed[a] *= 0.5f; // Halve speed on collision with another car
+        fleet.speed[b] *= 0.5f;
+    });
+}
+
+static void updateNeighbours(Fleet& fleet, const RoadMap& roads) {
+    buildSpatialHash(fleet.neighbours, fleet.positionX.data(), fleet.positionY.data(), fleetSize(fleet));
+    if (fleet.collisions && fleetSize(fleet) > 1) {
+        collideVehicles(fleet, roads);
+        buildSpatialHash(fleet.neighbours, fleet.positionX.data(), fleet.positionY.data(), fleetSize(fleet));
+    }
+}
+
+void stepFleet(Fleet& fleet, float deltaTime, const RoadMap& roads) {
+    size_t count = fleetSize(fleet);
+    fleet.targetX.resize(count);
+    fleet.targetY.resize(count);
+    fleet.moved.resize(count);
+    fleet.surface.resize(count);
+
+    // Remember where this tick started so rendering can interpolate
+    fleet.previousX = fleet.positionX;
+    fleet.previousY = fleet.positionY;
+    fleet.previousAngle = fleet.angle;
+
+    // Vectorized controls and movement, a scalar gather from the road map, then vectorized resolve
+    integrateControls(fleet, deltaTime);
+    for (size_t i = 0; i < count; ++i)
+        fleet.surface[i] = surfaceForMove(roads, fleet.positionX[i], fleet.positionY[i], fleet.targetX[i], fleet.targetY[i]);
+    resolveSurfaces(fleet, deltaTime);
+    updateNeighbours(fleet, roads);
+}
+
+void stepFleetScalar(Fleet& fleet, float deltaTime, const RoadMap& roads) {
+    size_t count = fleetSize(fleet);
+
+    // Remember where this tick started so rendering can interpolate
+    fleet.previousX = fleet.positionX;
+    fleet.previousY = fleet.positionY;
+    fleet.previousAngle = fleet.angle;
+
+    for (size_t i = 0; i < count; ++i) {
+        handleInput(fleet, i, deltaTime, fleet.profiles[fleet.profile[i]]);
+        updateCar(fleet, i, deltaTime, roads);
+    }
+    updateNeighbours(fleet, roads);
+}
+
+sf::Vector2f vehiclePosition(const Fleet& fleet, size_t vehicle) {
+    return sf::Vector2f(fleet.positionX[vehicle], fleet.positionY[vehicle]);
+}
+
+sf::Vector2f vehicleRenderPosition(const Fleet& fleet, size_t vehicle, float alpha) {
+    // Blend the last two simulated transforms so motion stays smooth at any frame rate
+    return sf::Vector2f(fleet.previousX[vehicle] + (fleet.positionX[vehicle] - fleet.previousX[vehicle]) * alpha,
+        fleet.previousY[vehicle] + (fleet.positionY[vehicle] - fleet.previousY[vehicle]) * alpha);
+}
+
+float vehicleRenderAngle(const Fleet& fleet, size_t vehicle, float alpha) {
+    return fleet.previousAngle[vehicle] + (fleet.angle[vehicle] - fleet.previousAngle[vehicle]) * alpha;
+}
+
+bool loadFleetSprites(FleetSprites& sprites, const std::vector<std::string>& textureFiles) {
+    std::vector<sf::Image> images(textureFiles.size());
+    std::vector<const sf::Image*> loaded;
+    for (size_t i = 0; i < textureFiles.size(); ++i) {
+        if (images[i].loadFromFile(textureFiles[i]))
+            loaded.push_back(&images[i]);
+    }
+    return buildFleetSprites(sprites, loaded);
+}
+
+bool buildFleetSprites(FleetSprites& sprites, const std::vector<const sf::Image*>& images) {
+    unsigned int atlasWidth = 0;
+    unsigned int atlasHeight = 0;
+    for (const sf::Image* image : images) {
+        if (!image)
+            continue;
+        atlasWidth += image->getSize().x;
+        atlasHeight = std::max(atlasHeight, image->getSize().y);
+    }
+
+    sprites.frames.clear();
+    sprites.hasSprite = false;
+    sprites.vehicles.texture = nullptr;
+    if (atlasWidth == 0)
+        return false;
+
+    sf::Image atlas;
+    atlas.create(atlasWidth, atlasHeight, sf::Color::Transparent);
+    unsigned int x = 0;
+    for (const sf::Image* image : images) {
+        if (!image)
+            continue;
+        atlas.copy(*image, x, 0);
+        sprites.frames.push_back(sf::FloatRect(static_cast<float>(x), 0.f,
+            static_cast<float>(image->getSize().x), static_cast<float>(image->getSize().y)));
+        x += image->getSize().x;
+    }
+
+    if (!sprites.atlas.loadFromImage(atlas)) {
+        sprites.frames.clear();
+        return false;
+    }
+    sprites.vehicles.texture = &sprites.atlas;
+    sprites.hasSprite = true;
+    return true;
+}
+
+void drawFleet(sf::RenderTarget& target, FleetSprites& sprites, const Fleet& fleet, float alpha, const sf::View& view) {
+    // Skip vehicles outside the view (padded by the car length so rotated bodies aren't clipped)
+    sf::FloatRect visible(view.getCenter().x - view.getSize().x / 2 - CAR_LENGTH,
+        view.getCenter().y - view.getSize().y / 2 - CAR_LENGTH,
+        view.getSize().x + 2 * CAR_LENGTH, view.getSize().y + 2 * CAR_LENGTH);
+
+    // Every car sprite is stretched to the CAR_LENGTH x CAR_WIDTH body
+    const sf::Vector2f halfSize(CAR_LENGTH / 2.f, CAR_WIDTH / 2.f);
+
+    clearBatch(sprites.vehicles);
+    size_t count = fleetSize(fleet);
+    for (size_t i = 0; i < count; ++i) {
+        if (!visible.contains(fleet.positionX[i], fleet.positionY[i]))
+            continue;
+
+        sf::Vector2f position = vehicleRenderPosition(fleet, i, alpha);
+        float angle = vehicleRenderAngle(fleet, i, alpha);
+        if (sprites.hasSprite)
+            addRotatedQuad(sprites.vehicles, position, halfSize, angle, sprites.frames[i % sprites.frames.size()]);
+        else
+            addRotatedQuad(sprites.vehicles, position, halfSize, angle, sf::FloatRect(), sf::Color::Blue);
+    }
+    drawBatch(target, sprites.vehicles);
+}
+
+void drawFleetMarkers(sf::RenderTarget& target, FleetSprites& sprites, const Fleet& fleet, size_t highlighted,
+    float alpha, const sf::Vector2f& mapSize, const sf::FloatRect& area) {
+    const float radius = 3.f;
+
+    clearBatch(sprites.markers);
+    size_t count = fleetSize(fleet);
+    for (size_t i = 0; i < count; ++i) {
+        if (i == highlighted)
+            continue;
+
+        sf::Vector2f position = vehicleRenderPosition(fleet, i, alpha);
+        sf::Vector2f marker(area.left + position.x / mapSize.x * area.width, area.top + position.y / mapSize.y * area.height);
+        if (area.contains(marker))
+            addRect(sprites.markers, sf::FloatRect(marker.x - radius, marker.y - radius, 2 * radius, 2 * radius), sf::Color::Yellow);
+    }
+
+    // The highlighted vehicle goes last so it is drawn on top of the others
+    if (highlighted < count) {
+        sf::Vector2f position = vehicleRenderPosition(fleet, highlighted, alpha);
+        sf::Vector2f marker(area.left + position.x / mapSize.x * area.width, area.top + position.y / mapSize.y * area.height);
+        addRect(sprites.markers, sf::FloatRect(marker.x - radius, marker.y - radius, 2 * radius, 2 * radius), sf::Color::Red);
+    }
+    drawBatch(target, sprites.markers);
+}
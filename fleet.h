@@ -0,0 +1,114 @@
+#pragma once
+#include "car.h"
+#include "road_map.h"
+#include "render_batch.h"
+#include "spatial_hash.h"
+#include "vehicle_profiles.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Bits of Fleet::controls, one byte per vehicle
+enum ControlBits : std::uint8_t {
+    CONTROL_ACCELERATE = 1 << 0,
+    CONTROL_BRAKE = 1 << 1,
+    CONTROL_TURN_LEFT = 1 << 2,
+    CONTROL_TURN_RIGHT = 1 << 3,
+    CONTROL_REFUEL = 1 << 4
+};
+
+// Consecutive vehicles [begin, end) that share a profile
+struct FleetRun {
+    size_t begin = 0;
+    size_t end = 0;
+    std::uint8_t profile = 0;
+};
+
+// Every simulated vehicle, stored as a structure of arrays. Index i in each array belongs
+// to vehicle i. The physics pass only walks the contiguous float arrays below; textures
+// and vertex batches live in FleetSprites and are shared by all vehicles.
+struct Fleet {
+    // Hot physics state
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> speed;
+    std::vector<float> angle;            // Degrees
+    std::vector<float> fuel;
+    std::vector<float> refuelCooldown;   // Simulated seconds until F can add fuel again
+    std::vector<double> mileage;
+    std::vector<std::uint8_t> controls;  // ControlBits for the current tick
+    std::vector<std::uint8_t> profile;   // Index into `profiles`
+
+    // Transform at the start of the last tick, only read for render interpolation
+    std::vector<float> previousX;
+    std::vector<float> previousY;
+    std::vector<float> previousAngle;
+
+    // Per-tick scratch for the batch integrator, resized by stepFleet
+    std::vector<float> targetX;
+    std::vector<float> targetY;
+    std::vector<float> moved;
+    std::vector<std::uint8_t> surface;   // SurfaceType for the move to targetX/targetY
+
+    // The kinds of vehicle in the fleet; the built-in car unless replaced (see loadVehicleProfiles).
+    // The integrator runs once per run of same-profile vehicles with that profile's model compiled
+    // in, so keeping each profile's vehicles together keeps a mixed fleet as fast as a uniform one.
+    std::vector<VehicleProfile> profiles{ VehicleProfile() };
+    std::vector<FleetRun> profileRuns;   // Rebuilt by stepFleet when profileRunsStale is set
+    bool profileRunsStale = true;
+
+    // Vehicle positions after the last tick, for collisions and proximity queries
+    SpatialHash neighbours;
+    bool collisions = false;             // Push overlapping cars apart at the end of every tick
+};
+
+size_t fleetSize(const Fleet& fleet);
+size_t addVehicle(Fleet& fleet, const sf::Vector2f& position, float angle, float fuel, std::uint8_t profile = 0);
+void setVehicleProfile(Fleet& fleet, size_t vehicle, std::uint8_t profile);
+const CarTuning& vehicleTuning(const Fleet& fleet, size_t vehicle);
+
+// Rebuild fleet.profileRuns if vehicles were added or changed profile since the last call
+void updateProfileRuns(Fleet& fleet);
+void resetVehicle(Fleet& fleet, size_t vehicle, const sf::Vector2f& position, float angle, float fuel);
+std::uint8_t packControls(const CarControls& controls);
+
+// Per-vehicle physics, split the same way as the single-car version it replaces.
+// These are the reference formulas the batch kernels in batch_physics.h must match.
+void handleInput(Fleet& fleet, size_t vehicle, float deltaTime, const VehicleProfile& profile);
+void updateCar(Fleet& fleet, size_t vehicle, float deltaTime, const RoadMap& roads);
+
+// Separate every pair of overlapping car bodies (rotated CAR_LENGTH x CAR_WIDTH boxes) found
+// through fleet.neighbours, and slow both cars down like a boundary hit. No car is pushed off the road.
+void collideVehicles(Fleet& fleet, const RoadMap& roads);
+
+// Advance every vehicle by one tick using its current controls, then rebuild fleet.neighbours
+// (and resolve collisions when fleet.collisions is set). Each vehicle drives with its own profile.
+void stepFleet(Fleet& fleet, float deltaTime, const RoadMap& roads);
+void stepFleetScalar(Fleet& fleet, float deltaTime, const RoadMap& roads);
+
+sf::Vector2f vehiclePosition(const Fleet& fleet, size_t vehicle);
+sf::Vector2f vehicleRenderPosition(const Fleet& fleet, size_t vehicle, float alpha);
+float vehicleRenderAngle(const Fleet& fleet, size_t vehicle, float alpha);
+
+// Render resources shared by the whole fleet. Every car sprite is packed side by side into one
+// atlas texture so the visible fleet is a single batch of quads and a single draw call.
+struct FleetSprites {
+    sf::Texture atlas;
+    std::vector<sf::FloatRect> frames;  // Texture rect of each car sprite in the atlas
+    bool hasSprite = false;             // Untextured blue quads are drawn when no sprite loaded
+    QuadBatch vehicles;
+    QuadBatch markers;
+};
+
+// Pack the given car images into the atlas; vehicle i is drawn with frame i % frames.size().
+// Missing images (nullptr) are skipped.
+bool buildFleetSprites(FleetSprites& sprites, const std::vector<const sf::Image*>& images);
+bool loadFleetSprites(FleetSprites& sprites, const std::vector<std::string>& textureFiles);
+
+// Draw every vehicle inside the view in one call
+void drawFleet(sf::RenderTarget& target, FleetSprites& sprites, const Fleet& fleet, float alpha, const sf::View& view);
+
+// Draw one dot per vehicle inside `area`, which shows a map of mapSize world pixels; `highlighted`
+// (the player) is drawn in red, the rest in yellow
+void drawFleetMarkers(sf::RenderTarget& target, FleetSprites& sprites, const Fleet& fleet, size_t highlighted,
+    float alpha, const sf::Vector2f& mapSize, const sf::FloatRect& area);
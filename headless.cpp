@@ -0,0 +1,276 @@
+#include "headless.h"
+#include "ai_driver.h"
+#include "input.h"
+#include "snapshot.h"
+#include "telemetry.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static bool parseKeys(const std::string& keys, CarControls& controls) {
+    controls = CarControls();
+    if (keys == "-")
+        return true;
+
+    for (char key : keys) {
+        switch (std::toupper(static_cast<unsigned char>(key))) {
+        case 'W': controls.accelerate = true; break;
+        case 'S': controls.brake = true; break;
+        case 'A': controls.turnLeft = true; break;
+        case 'D': controls.turnRight = true; break;
+        case 'F': controls.refuel = true; break;
+        default: return false;
+        }
+    }
+    return true;
+}
+
+bool loadScenario(const std::string& path, Scenario& scenario) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Error opening scenario: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        std::string::size_type comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        std::istringstream in(line);
+        std::string directive;
+        if (!(in >> directive))
+            continue;
+
+        bool ok = true;
+        if (directive == "start") {
+            ok = static_cast<bool>(in >> scenario.startPosition.x >> scenario.startPosition.y);
+            in >> scenario.startAngle;
+        }
+        else if (directive == "fuel") {
+            ok = static_cast<bool>(in >> scenario.startFuel);
+        }
+        else if (directive == "duration") {
+            ok = static_cast<bool>(in >> scenario.duration) && scenario.duration >= 0;
+        }
+        else if (directive == "tickrate") {
+            ok = static_cast<bool>(in >> scenario.tickRate) && scenario.tickRate > 0;
+        }
+        else if (directive == "vehicles") {
+            ok = static_cast<bool>(in >> scenario.vehicles) && scenario.vehicles > 0;
+        }
+        else if (directive == "mask") {
+            ok = static_cast<bool>(in >> scenario.roadMaskFile);
+        }
+        else if (directive == "telemetry") {
+            ok = static_cast<bool>(in >> scenario.telemetryFile);
+        }
+        else if (directive == "maxspeed") {
+            ok = static_cast<bool>(in >> scenario.tuning.maxSpeed) && scenario.tuning.maxSpeed > 0;
+        }
+        else if (directive == "acceleration") {
+            ok = static_cast<bool>(in >> scenario.tuning.acceleration);
+        }
+        else if (directive == "friction") {
+            ok = static_cast<bool>(in >> scenario.tuning.friction);
+        }
+        else if (directive == "turnrate") {
+            ok = static_cast<bool>(in >> scenario.tuning.turnRate);
+        }
+        else if (directive == "drag") {
+            ok = static_cast<bool>(in >> scenario.tuning.drag) && scenario.tuning.drag >= 0;
+        }
+        else if (directive == "understeer") {
+            ok = static_cast<bool>(in >> scenario.tuning.understeer) && scenario.tuning.understeer >= 0
+                && scenario.tuning.understeer <= 1;
+        }
+        else if (directive == "model") {
+            std::string model;
+            ok = (in >> model) && parseVehicleModel(model, scenario.model);
+        }
+        else if (directive == "collisions") {
+            std::string value;
+            ok = (in >> value) && (value == "on" || value == "off");
+            scenario.collisions = value == "on";
+        }
+        else if (directive == "input") {
+            ScenarioStep step;
+            std::string keys;
+            ok = (in >> step.time >> keys) && parseKeys(keys, step.controls);
+            if (ok)
+                scenario.steps.push_back(step);
+        }
+        else {
+            ok = false;
+        }
+
+        if (!ok) {
+            std::cerr << path << ":" << lineNumber << ": invalid scenario line" << std::endl;
+            return false;
+        }
+    }
+
+    std::stable_sort(scenario.steps.begin(), scenario.steps.end(),
+        [](const ScenarioStep& a, const ScenarioStep& b) { return a.time < b.time; });
+    return true;
+}
+
+void simulateScenario(const Scenario& scenario, const RoadMap& roads, Fleet& fleet, ScenarioResult& result,
+    TelemetryRecorder* telemetry) {
+    fleet = Fleet();
+    fleet.collisions = scenario.collisions;
+    fleet.profiles[0].model = scenario.model;
+    fleet.profiles[0].tuning = scenario.tuning;
+    for (size_t i = 0; i < scenario.vehicles; ++i)
+        addVehicle(fleet, scenario.startPosition, scenario.startAngle, scenario.startFuel);
+
+    FixedTimestep timestep;
+    timestep.tickRate = scenario.tickRate;
+    float deltaTime = tickDuration(timestep);
+    unsigned long long totalTicks = static_cast<unsigned long long>(scenario.duration * scenario.tickRate + 0.5f);
+
+    // The script holds keys through the same input state the window's key events drive
+    size_t nextStep = 0;
+    InputState input;
+    unsigned long long blockedTicks = 0;
+    float fuelUsed = 0.f;
+    for (unsigned long long tick = 0; tick < totalTicks; ++tick) {
+        // Switch to the scripted controls once their start time is reached
+        float simTime = tick * deltaTime;
+        beginInputTick(input);
+        while (nextStep < scenario.steps.size() && scenario.steps[nextStep].time <= simTime)
+            setInputHeld(input, packControls(scenario.steps[nextStep++].controls));
+
+        std::fill(fleet.controls.begin(), fleet.controls.end(), inputControls(input));
+        float fuelBefore = fleet.fuel[0];
+        stepFleet(fleet, deltaTime, roads);
+        if (fleet.fuel[0] < fuelBefore)
+            fuelUsed += fuelBefore - fleet.fuel[0];
+        if (fleet.surface[0] == SURFACE_OFF_ROAD || fleet.surface[0] == SURFACE_OUT_OF_BOUNDS)
+            ++blockedTicks;
+        if (telemetry)
+            recordTelemetry(*telemetry, fleet, tick + 1);
+    }
+
+    result.finalPosition = vehiclePosition(fleet, 0);
+    result.finalFuel = fleet.fuel[0];
+    result.fuelUsed = fuelUsed;
+    result.distance = fleet.mileage[0];
+    result.offRoadTime = blockedTicks * deltaTime;
+}
+
+int runHeadless(const Scenario& scenario) {
+    RoadMap roads;
+    if (!loadRoadMap(roads, scenario.roadMaskFile))
+        return -1;
+
+    TelemetryRecorder telemetry;
+    telemetry.lossless = true;
+    if (!scenario.telemetryFile.empty() && !startTelemetry(telemetry, scenario.telemetryFile))
+        return -1;
+
+    sf::Clock wallClock;
+    Fleet fleet;
+    ScenarioResult result;
+    simulateScenario(scenario, roads, fleet, result, &telemetry);
+    float wallSeconds = wallClock.getElapsedTime().asSeconds();
+    stopTelemetry(telemetry);
+    unsigned long long totalTicks = static_cast<unsigned long long>(scenario.duration * scenario.tickRate + 0.5f);
+
+    std::cout << "Ticks: " << totalTicks << " (" << scenario.duration << " s at " << scenario.tickRate << " Hz)\n";
+    std::cout << "Vehicles: " << fleetSize(fleet) << "\n";
+    std::cout << "Final Position: (" << fleet.positionX[0] << ", " << fleet.positionY[0] << ")\n";
+    std::cout << "Final Fuel: " << fleet.fuel[0] << "\n";
+    std::cout << "Mileage: " << fleet.mileage[0] << "\n";
+    std::cout << "Fuel Used: " << result.fuelUsed << "\n";
+    std::cout << "Off-road Time: " << result.offRoadTime << " s\n";
+    std::cout << "Wall Time: " << wallSeconds << " s";
+    if (wallSeconds > 0)
+        std::cout << " (" << scenario.duration / wallSeconds << "x real time)";
+    std::cout << std::endl;
+    return 0;
+}
+
+bool simulateReplay(const Replay& replay, const RoadMap& roads, const RoadGraph& graph, Fleet& fleet) {
+    fleet.profiles = replay.profiles;
+    FixedTimestep timestep;
+    if (replay.startSnapshot.empty()) {
+        addVehicle(fleet, replay.startPosition, replay.startAngle, replay.startFuel);
+    }
+    else if (!restoreSnapshot(replay.startSnapshot, fleet, timestep) || fleetSize(fleet) == 0) {
+        std::cerr << "Replay has an invalid start snapshot" << std::endl;
+        return false;
+    }
+    timestep.tickRate = replay.tickRate;
+    float deltaTime = tickDuration(timestep);
+    fleet.collisions = true;  // As in the windowed game
+
+    // AI cars are not recorded; the same graph and seed drive them the same way again
+    AiTraffic traffic;
+    if (replay.aiDrivers > 0) {
+        if (replay.startSnapshot.empty())
+            spawnAiTraffic(traffic, fleet, graph, roads, replay.aiDrivers, replay.aiSeed);
+        else
+            attachAiTraffic(traffic, graph, roads, 1, replay.aiDrivers, replay.aiSeed);
+    }
+
+    // Recorded key changes are fed back through the input state, as the window's events were
+    size_t nextEvent = 0;
+    InputState input;
+    for (std::uint64_t tick = replay.startTick + 1; tick <= replay.ticks; ++tick) {
+        beginInputTick(input);
+        while (nextEvent < replay.events.size() && replay.events[nextEvent].tick <= tick) {
+            const ReplayEvent& event = replay.events[nextEvent++];
+            if (event.flags & REPLAY_RESET)
+                resetVehicle(fleet, 0, replay.startPosition, replay.startAngle, replay.startFuel);
+            setInputHeld(input, event.controls);
+        }
+
+        driveAiTraffic(traffic, fleet, tick);
+        fleet.controls[0] = inputControls(input);
+        stepFleet(fleet, deltaTime, roads);
+    }
+    return true;
+}
+
+int runReplay(const Replay& replay) {
+    RoadMap roads;
+    if (!loadRoadMap(roads, replay.roadMaskFile))
+        return -1;
+    if (surfaceGridHash(roads.surface) != replay.roadGridHash)
+        std::cerr << "Warning: " << replay.roadMaskFile << " differs from the map the session was recorded on" << std::endl;
+
+    RoadGraph graph;
+    if (replay.aiDrivers > 0)
+        loadRoadGraph(graph, roads, ROAD_GRAPH_CACHE_FILE);
+
+    sf::Clock wallClock;
+    Fleet fleet;
+    if (!simulateReplay(replay, roads, graph, fleet))
+        return -1;
+    float wallSeconds = wallClock.getElapsedTime().asSeconds();
+    float duration = (replay.ticks - replay.startTick) / replay.tickRate;
+
+    std::uint64_t checksum = vehicleChecksum(fleet, 0);
+    std::cout << "Ticks: " << replay.ticks - replay.startTick << " (" << duration << " s at " << replay.tickRate << " Hz)\n";
+    std::cout << "Input Changes: " << replay.events.size() << "\n";
+    std::cout << "Final Position: (" << fleet.positionX[0] << ", " << fleet.positionY[0] << ")\n";
+    std::cout << "Final Fuel: " << fleet.fuel[0] << "\n";
+    std::cout << "Mileage: " << fleet.mileage[0] << "\n";
+    std::cout << "Wall Time: " << wallSeconds << " s";
+    if (wallSeconds > 0)
+        std::cout << " (" << duration / wallSeconds << "x real time)";
+    std::cout << "\n";
+
+    if (checksum != replay.finalChecksum) {
+        std::cout << "Replay diverged from the recording" << std::endl;
+        return 1;
+    }
+    std::cout << "Replay matches the recording" << std::endl;
+    return 0;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "fleet.h"
+#include "replay.h"
+#include "simulation.h"
+#include <string>
+#include <vector>
+
+struct RoadGraph;
+struct TelemetryRecorder;
+
+// Controls held from `time` (in simulated seconds) until the next step begins
+struct ScenarioStep {
+    float time = 0.f;
+    CarControls controls;
+};
+
+// A scripted drive for headless runs: where the car starts, what the driver presses and for how long
+struct Scenario {
+    sf::Vector2f startPosition = sf::Vector2f(2450.f, 2064.f);
+    float startAngle = 0.f;
+    float startFuel = 2000.f;
+    float duration = 60.f;                   // Simulated seconds
+    size_t vehicles = 1;                     // Identical cars driving the same script
+    float tickRate = SIMULATION_TICK_RATE;
+    std::string roadMaskFile = "map_mask.jpeg";
+    std::string telemetryFile;               // Record every tick of every vehicle here when set
+    CarTuning tuning;
+    VehicleModel model = VEHICLE_MODEL_CAR;  // Every vehicle drives with this model and `tuning`
+    bool collisions = false;                 // Cars push each other apart (identical cars start stacked)
+    std::vector<ScenarioStep> steps;         // Sorted by time
+};
+
+// What happened to the first car of a scenario
+struct ScenarioResult {
+    sf::Vector2f finalPosition;
+    float finalFuel = 0.f;
+    float fuelUsed = 0.f;       // Burned; refuelling doesn't count against it
+    double distance = 0.0;      // Mileage driven
+    float offRoadTime = 0.f;    // Simulated seconds spent blocked off-road or at the map boundary
+};
+
+// Parse a scenario file. Each line is one directive, '#' starts a comment:
+//   start <x> <y> [angle]    fuel <amount>      duration <seconds>
+//   tickrate <hz>            mask <file>        vehicles <count>
+//   telemetry <file>         maxspeed <value>   acceleration <value>
+//   friction <value>         turnrate <degrees per second>   collisions <on|off>
+//   drag <value>             understeer <0..1>  model <car|heavy>
+//   input <seconds> <keys>
+// where <keys> is any combination of W/S/A/D/F, or '-' to release everything.
+bool loadScenario(const std::string& path, Scenario& scenario);
+
+// Run the scenario to its end on an already loaded road map. Safe to call from several threads
+// at once with the same road map, as long as each call has its own fleet.
+void simulateScenario(const Scenario& scenario, const RoadMap& roads, Fleet& fleet, ScenarioResult& result,
+    TelemetryRecorder* telemetry = nullptr);
+
+// Simulate the scenario as fast as possible (no window, audio or textures) and print the final state
+int runHeadless(const Scenario& scenario);
+
+// Re-simulate a recorded session on an already loaded road map; the recorded vehicle is fleet
+// vehicle 0. The graph is only used when the replay has AI traffic. Returns false if the start
+// snapshot is invalid.
+bool simulateReplay(const Replay& replay, const RoadMap& roads, const RoadGraph& graph, Fleet& fleet);
+
+// Re-simulate a recorded session as fast as possible and check that it ends in exactly the
+// recorded state. Returns 0 on a bit-for-bit match.
+int runReplay(const Replay& replay);
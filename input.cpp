@@ -0,0 +1,73 @@
+#include "input.h"
+#include "fleet.h"
+#include "simulation.h"
+
+static_assert(CONTROL_ACCELERATE == 1 << ACTION_ACCELERATE && CONTROL_BRAKE == 1 << ACTION_BRAKE
+    && CONTROL_TURN_LEFT == 1 << ACTION_TURN_LEFT && CONTROL_TURN_RIGHT == 1 << ACTION_TURN_RIGHT
+    && CONTROL_REFUEL == 1 << ACTION_REFUEL, "driving actions must match ControlBits");
+
+// Which key does what
+static const sf::Keyboard::Key ACTION_KEYS[ACTION_COUNT] = {
+    sf::Keyboard::W, sf::Keyboard::S, sf::Keyboard::A, sf::Keyboard::D, sf::Keyboard::F,
+    sf::Keyboard::Left, sf::Keyboard::Right, sf::Keyboard::Up, sf::Keyboard::Down
+};
+
+static int actionOfKey(sf::Keyboard::Key key) {
+    for (int action = 0; action < ACTION_COUNT; ++action) {
+        if (ACTION_KEYS[action] == key)
+            return action;
+    }
+    return -1;
+}
+
+void beginInputFrame(InputState& input, float frameTime) {
+    input.pressed = 0;
+    input.pendingTime += frameTime;
+    std::uint64_t ticks = static_cast<std::uint64_t>(input.pendingTime * SIMULATION_TICK_RATE);
+    input.tick += ticks;
+    input.pendingTime -= ticks / SIMULATION_TICK_RATE;
+}
+
+void beginInputTick(InputState& input) {
+    input.pressed = 0;
+    ++input.tick;
+}
+
+void handleInputEvent(InputState& input, const sf::Event& event) {
+    if (event.type == sf::Event::KeyPressed || event.type == sf::Event::KeyReleased) {
+        int action = actionOfKey(event.key.code);
+        if (action < 0)
+            return;
+
+        std::uint32_t bit = 1u << action;
+        if (event.type == sf::Event::KeyReleased) {
+            input.held &= ~bit;
+        }
+        else if (!(input.held & bit)) {
+            // Key repeat sends more KeyPressed events while held; only the first is a press
+            input.held |= bit;
+            input.pressed |= bit;
+        }
+    }
+    else if (event.type == sf::Event::LostFocus) {
+        // Releases that happen in another window are never seen here
+        input.held = 0;
+    }
+}
+
+void setInputHeld(InputState& input, std::uint32_t held) {
+    input.pressed |= held & ~input.held;
+    input.held = held;
+}
+
+bool inputReady(InputState& input, InputAction action, std::uint32_t cooldownTicks) {
+    if (!inputHeld(input, action))
+        return false;
+
+    std::uint32_t bit = 1u << action;
+    if (!inputPressed(input, action) && (input.fired & bit) && input.tick - input.lastFired[action] < cooldownTicks)
+        return false;
+    input.lastFired[action] = input.tick;
+    input.fired |= bit;
+    return true;
+}
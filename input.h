@@ -0,0 +1,61 @@
+#pragma once
+#include <SFML/Window.hpp>
+#include <cstdint>
+
+// Everything a held key does. The first five are in ControlBits order, so the driving
+// controls are the low bits of InputState::held.
+enum InputAction : std::uint8_t {
+    ACTION_ACCELERATE,    // W
+    ACTION_BRAKE,         // S
+    ACTION_TURN_LEFT,     // A
+    ACTION_TURN_RIGHT,    // D
+    ACTION_REFUEL,        // F
+    ACTION_PREVIOUS_SONG, // Left, in the music menu
+    ACTION_NEXT_SONG,     // Right
+    ACTION_VOLUME_UP,     // Up
+    ACTION_VOLUME_DOWN,   // Down
+    ACTION_COUNT
+};
+
+// The input of one frame as bitsets, one bit per InputAction. `held` is kept up to date from
+// the window's key events, so the keyboard is never polled; anything else (a scenario, a
+// replay) drives the same state with setInputHeld. Time is counted in simulation ticks and
+// repeat cooldowns are a flat array of the tick each action last fired, so checking one is an
+// integer compare rather than a clock read, and scripted input repeats exactly.
+struct InputState {
+    std::uint32_t held = 0;
+    std::uint32_t pressed = 0;                    // Went down since the last beginInputFrame/Tick
+    std::uint64_t tick = 0;                       // Ticks of input seen so far
+    float pendingTime = 0.f;                      // Frame time not yet a whole tick
+    std::uint64_t lastFired[ACTION_COUNT] = {};   // Tick each action last fired in inputReady
+    std::uint32_t fired = 0;                      // Actions whose lastFired is set
+};
+
+// Start a window frame that lasts `frameTime` seconds: forget last frame's presses and
+// advance by the whole ticks (at SIMULATION_TICK_RATE) it covers
+void beginInputFrame(InputState& input, float frameTime);
+
+// Start exactly one tick, for input driven by the simulation rather than by the window
+void beginInputTick(InputState& input);
+
+// Update the held keys from a key or focus event; other events are ignored
+void handleInputEvent(InputState& input, const sf::Event& event);
+
+// Replace the held actions, e.g. with scripted input
+void setInputHeld(InputState& input, std::uint32_t held);
+
+inline bool inputHeld(const InputState& input, InputAction action) {
+    return (input.held >> action) & 1;
+}
+
+inline bool inputPressed(const InputState& input, InputAction action) {
+    return (input.pressed >> action) & 1;
+}
+
+// ControlBits for the driving actions being held
+inline std::uint8_t inputControls(const InputState& input) {
+    return static_cast<std::uint8_t>(input.held & 0x1F);
+}
+
+// True while `action` is held, at most once per `cooldownTicks`, starting the moment it goes down
+bool inputReady(InputState& input, InputAction action, std::uint32_t cooldownTicks);
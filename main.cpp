@@ -4,9 +4,27 @@
 #include <SFML/System.hpp>
 #include <iostream>
 #include <cmath>
-#include <map>
 #include <fstream>
 #include <ctime>
+#include <cstdio>
+#include "simulation.h"
+#include "car.h"
+#include "fleet.h"
+#include "batch_physics.h"
+#include "headless.h"
+#include "scenario_batch.h"
+#include "ui.h"
+#include "minimap.h"
+#include "world_tiles.h"
+#include "assets.h"
+#include "music.h"
+#include "telemetry.h"
+#include "snapshot.h"
+#include "ai_driver.h"
+#include "profiler.h"
+#include "sim_thread.h"
+#include "input.h"
+#include "world_layer.h"
 
 // All Global Booleans
 bool showRestartButton = false;
@@ -21,151 +39,240 @@ bool musicMenuToggled = false;
 bool showCar = false;
 bool escapeMenuToggled = false;
 bool darkMode = true;
-static bool inFuelArea = false;
+bool showProfiler = false;
 int escapeCount = 0;
 
-// Constants for car physics and road behavior
-const float MAX_SPEED = 120.f;
-const float ACCELERATION = 100.f;
-const float TURN_RATE = 120.f;
-const float FRICTION = 20.f;
-const float MIN_TURN_SPEED = 20.f;
+// Constants for menu behavior
 const float MENU_TOGGLE_COOLDOWN = 0.1f;
 const float MUSIC_CHANGE_COOLDOWN = 0.5f;
+// Held arrow keys in the music menu repeat every 0.2 s, counted in ticks
+const std::uint32_t MUSIC_KEY_COOLDOWN = static_cast<std::uint32_t>(0.2f * SIMULATION_TICK_RATE);
+
+// What the buttons of the escape and music menus do
+enum MenuAction {
+    MENU_RESTART,
+    MENU_CHANGE_THEME,
+    MENU_MUSIC,
+    MENU_QUIT,
+    MENU_GENERATE_LOG,
+    MENU_PLAY_PAUSE,
+    MENU_NEXT_SONG,
+    MENU_PREVIOUS_SONG,
+    MENU_BACK
+};
 
-// Key Cooldown 
-std::map<sf::Keyboard::Key, sf::Clock> keyCooldowns;
-
-// Struct for Car
-struct Car {
-    sf::RectangleShape shape;
-    sf::Sprite sprite;
-    sf::Texture texture;
-    float speed = 0.f;
-    float fuel = 2000.f;
-    float angle = 0.f;
-    bool hasSprite = false;
-    long double mileage = 0;
-    sf::Vector2f position;
+// Computer-driven cars sharing the roads with the player
+const size_t AI_DRIVER_COUNT = 4;
 
-};
+// The profiler overlay re-lays out its figures this often rather than every frame
+const std::uint64_t PROFILER_REFRESH_FRAMES = 30;
+
+// A paused frame in which nothing would change is skipped; the loop then waits this long for input
+const float IDLE_FRAME_TIME = 1.f / 30.f;
+
+// Optional parts of the world layer, for WorldLayerKey::layers
+const std::uint32_t WORLD_LAYER_CAR = 1;
+const std::uint32_t WORLD_LAYER_STATS = 2;
+const std::uint32_t WORLD_LAYER_ENLARGED_MINIMAP = 4;
+
+// Held keys and repeat cooldowns, updated from window events
+InputState input;
 
 // Function Prototypes
-void generateLogFile(const Car& car);
+void generateLogFile(const Fleet& fleet, size_t vehicle);
 void restrictView(sf::View& view, const sf::Vector2u& mapSize);
 void timeDelay(float seconds);
-void drawDynamicMinimap(sf::RenderWindow& window, const sf::Sprite& mapSprite, const sf::View& view, const Car& car);
-bool isKeyReady(sf::Keyboard::Key key, float cooldownTime);
-void handleInput(Car& car, float deltaTime, float handling);
-void updateCar(Car& car, float deltaTime, const sf::Image& roadMask);
-void drawInteractiveStats(sf::RenderWindow& window, const Car& car, const sf::View& view);
-void showMiniMape(sf::RenderWindow& window, const sf::View& view, sf::Sprite map);
-void drawEscapeMenu(sf::RenderWindow& window, const sf::View& view,
-    std::vector<std::pair<sf::RectangleShape, std::string>>& escapeMenuButtons);
-void showMusicMenu(sf::RenderWindow& window, const sf::View& view, sf::Music& backgroundMusic, std::vector<std::string>& songList, int& currentSongIndex, float& volume);
-void drawMinimap(sf::RenderWindow& window, sf::RenderTexture& miniMapTexture, const sf::Sprite& mapSprite, const sf::View& view, bool enlarged);
-
-int main()
+void drawDynamicMinimap(sf::RenderTarget& target, MinimapLayer& minimap, const sf::View& view, FleetSprites& sprites, const Fleet& fleet, size_t player, float alpha);
+void buildStatsPanel(UiMenu& panel, const sf::Font& font);
+void buildEscapeMenu(UiMenu& menu, const sf::Font& font, const sf::Vector2f& viewSize);
+void buildMusicMenu(UiMenu& menu, const sf::Font& font, const sf::Vector2f& viewSize);
+void drawInteractiveStats(sf::RenderTarget& target, UiMenu& panel, const Fleet& fleet, size_t vehicle, const RoadMap& roads, const sf::View& view);
+void buildProfilerPanel(UiMenu& panel, const sf::Font& font);
+void drawProfilerOverlay(sf::RenderWindow& window, UiMenu& panel, const FrameProfiler& profiler, SimulationThread& sim, const sf::View& view);
+void showMiniMape(sf::RenderTarget& target, const sf::View& view, MinimapLayer& minimap, FleetSprites& sprites, const Fleet& fleet, size_t player, float alpha);
+void drawEscapeMenu(sf::RenderWindow& window, const sf::View& view, UiMenu& menu);
+bool updateMusicMenu(UiMenu& menu, MusicPlayer& music);
+void showMusicMenu(sf::RenderWindow& window, const sf::View& view, UiMenu& menu);
+SessionState captureSession(const MusicPlayer& music);
+void restoreSession(const SessionState& session, MusicPlayer& music);
+
+int main(int argc, char* argv[])
 {
+    // Batch runs: simulate a scenario without opening a window
+    if (argc >= 3 && std::string(argv[1]) == "--headless") {
+        Scenario scenario;
+        if (!loadScenario(argv[2], scenario))
+            return -1;
+        return runHeadless(scenario);
+    }
+
+    // Re-simulate a recorded session and check it ends in the recorded state
+    if (argc >= 3 && std::string(argv[1]) == "--replay") {
+        Replay replay;
+        if (!loadReplay(argv[2], replay))
+            return -1;
+        return runReplay(replay);
+    }
+
+    // Parameter studies: every run of a batch file spread over all cores, one CSV row each
+    if (argc >= 3 && std::string(argv[1]) == "--batch") {
+        std::vector<ScenarioRun> runs;
+        if (!loadScenarioBatch(argv[2], runs))
+            return -1;
+        return runScenarioBatch(runs, argc >= 4 ? argv[3] : "scenario_report.csv");
+    }
+
+    // Check the vectorized physics against the scalar formulas on this machine
+    if (argc >= 2 && std::string(argv[1]) == "--verify-physics")
+        return verifyBatchPhysics(std::cout) ? 0 : 1;
+
+    // Re-cut the world tiles after the map or mask image changed
+    WorldTiles world;
+    if (argc >= 2 && std::string(argv[1]) == "--build-tiles")
+        return buildWorldTiles(world, "world", "main_img.png", "map_mask.jpeg") ? 0 : 1;
+
     // Rendering a Window and setting a fps limit
     sf::RenderWindow window(sf::VideoMode(1920, 1080), "Car Simulation");
     window.setFramerateLimit(90);
 
-    // Loading the map Texture & Sprite
-    sf::Texture mapTexture;
-    if (!mapTexture.loadFromFile("main_img.png")) {
+    // The map and mask are cut into tiles on the first run; after that only tiles near the view are loaded
+    if (!loadWorldTiles(world, "world") && !buildWorldTiles(world, "world", "main_img.png", "map_mask.jpeg")) {
         std::cerr << "Error loading map image!" << std::endl;
         return -1;
     }
-    sf::Sprite mapSprite(mapTexture);
+    TileStreamer mapTiles;
+    startTileStreamer(mapTiles, world, "map");
+    const sf::Vector2u worldSize(world.width, world.height);
+
+    // The font is parsed once; menus are built once per theme and only re-lay out changed strings
+    sf::Font uiFont;
+    loadUiFont(uiFont, "arial.ttf");
+
+    // Every other asset is decoded on worker threads while a loading frame is shown. Warm
+    // starts copy raw pixels and the classified road grid out of the mapped asset bundle.
+    AssetLoader assets;
+    startAssetLoader(assets, "assets.bundle");
+    const std::vector<std::string> carTextures = { "car4.png", "car1.png" };
+    for (const std::string& file : carTextures)
+        requestImage(assets, file);
+    requestImage(assets, "miniMap.png");
+    const std::string overviewFile = world.prefix + "_overview.png";
+    if (std::ifstream(overviewFile))
+        requestImage(assets, overviewFile);
+
+    // The mask is only kept as a packed surface grid plus its distance field; each decoded tile is dropped
+    RoadMap roads;
+    requestRoadMap(assets, roads, world);
+
+    sf::Text loadingText("Loading...", uiFont, 30);
+    loadingText.setPosition(40.f, 40.f);
+    while (window.isOpen() && !isAssetLoaderDone(assets)) {
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            if (event.type == sf::Event::Closed)
+                window.close();
+        }
+        window.clear();
+        window.draw(loadingText);
+        window.display();
+    }
+    if (!finishAssetLoader(assets))
+        return -1;
 
-    sf::Sprite miniMap;
+    // Both minimaps are downscaled once here; each frame only draws them and the vehicle markers
     sf::Texture miniTexture;
-    miniTexture.loadFromFile("miniMap.png");
-    miniMap.setTexture(miniTexture);
-    miniMap.setScale(0.27f, 0.27f);
-
-    sf::Sprite enlargedMiniMap;
-    sf::Texture enlargedTexture;
-    enlargedTexture.loadFromFile("main_img.png");
-    enlargedMiniMap.setTexture(enlargedTexture);
-
-    sf::Image roadMask;
-    if (!roadMask.loadFromFile("map_mask.jpeg")) {
-        std::cerr << "Error loading road mask!" << std::endl;
-        return -1;
-    }
+    if (const sf::Image* image = loadedImage(assets, "miniMap.png"))
+        miniTexture.loadFromImage(*image);
+    MinimapLayer cornerMinimap;
+    prerenderMinimap(cornerMinimap, miniTexture, 0.099f);
 
-    sf::Music backgroundMusic;
-    if (!backgroundMusic.openFromFile("basic_music.mp3")) {
+    MinimapLayer enlargedMinimapLayer;
+    prerenderTiledMinimap(enlargedMinimapLayer, world, "map", 0.27f, loadedImage(assets, overviewFile));
+
+    // Neighbouring songs are opened ahead of time on a worker thread so switching never stalls a frame
+    MusicPlayer music;
+    if (!startMusicPlayer(music, { "basic_music.mp3", "Adele.mp3", "Ainsi-Bas-La-Vida.mp3", "Akela-hon.mp3" }, 50.f)) {
         std::cerr << "Error loading music!" << std::endl;
         return -1;
     }
 
-    backgroundMusic.setLoop(true);
-    backgroundMusic.play();
-
-    std::vector<std::string> songList = { "basic_music.mp3", "Adele.mp3", "Ainsi-Bas-La-Vida.mp3", "Akela-hon.mp3" };
-    int currentSongIndex = 0;
-    float volume = 50.f;
-    backgroundMusic.setVolume(volume);
-
-    Car car;
-    car.shape.setSize(sf::Vector2f(80.f, 40.f));
-    car.shape.setOrigin(10000.f, 10000.f);
-    car.shape.setFillColor(sf::Color::Blue);
-
-    if (car.texture.loadFromFile("car4.png")) {
-        car.sprite.setTexture(car.texture);
-        car.sprite.setOrigin(car.texture.getSize().x / 2.f, car.texture.getSize().y / 2.f);
-        float scaleX = car.shape.getSize().x / car.texture.getSize().x;
-        float scaleY = car.shape.getSize().y / car.texture.getSize().y;
-        car.sprite.setScale(scaleX, scaleY);
-        car.hasSprite = true;
-    }
-
-    car.shape.setPosition(2450.f, 2064.f);
-    if (car.hasSprite)
-        car.sprite.setPosition(2450.f, 2064.f);
+    // Every vehicle lives in the fleet; the player drives vehicle 0 and all cars share one sprite atlas
+    const sf::Vector2f startPosition(2450.f, 2064.f);
+    Fleet fleet;
+    // Kinds of vehicle (car, truck, bus); without the file everyone drives the built-in car
+    loadVehicleProfiles("vehicles.txt", fleet.profiles);
+    size_t player = addVehicle(fleet, startPosition, 0.f, MAX_FUEL);
+    fleet.collisions = true;
+
+    // The road graph is cached next to the tiles; AI cars plan on it and drive with the player's controls
+    RoadGraph roadGraph;
+    loadRoadGraph(roadGraph, roads, ROAD_GRAPH_CACHE_FILE);
+    AiTraffic aiTraffic;
+    std::uint32_t aiSeed = static_cast<std::uint32_t>(std::time(nullptr));
+    spawnAiTraffic(aiTraffic, fleet, roadGraph, roads, AI_DRIVER_COUNT, aiSeed);
+
+    // Every vehicle's state is recorded each tick; a background thread writes it out in binary chunks
+    TelemetryRecorder telemetry;
+    startTelemetry(telemetry, "car_simulation_telemetry.bin");
+
+    // The player's key presses are recorded per tick and saved as a replay when the window closes
+    Replay replay;
+    beginReplay(replay, fleet, player, SIMULATION_TICK_RATE, roads);
+    replay.aiDrivers = static_cast<std::uint32_t>(aiTraffic.drivers.size());
+    replay.aiSeed = aiSeed;
+    std::vector<char> quickSave;
+
+    FleetSprites vehicleSprites;
+    std::vector<const sf::Image*> carImages;
+    for (const std::string& file : carTextures)
+        carImages.push_back(loadedImage(assets, file));
+    buildFleetSprites(vehicleSprites, carImages);
+    releaseAssetLoader(assets);
 
     bool carPlaced = true;
     sf::View view;
     view.setSize(1280.0f, 768.0f);
-    sf::RenderTexture miniMapTexture;
-    if (!miniMapTexture.create(800, 600)) {
-        std::cerr << "Error creating mini map texture!" << std::endl;
-        return -1;
-    }
 
     sf::Clock clock;
+    FixedTimestep timestep;
+    timestep.tickRate = SIMULATION_TICK_RATE;
+
+    // Where frame time goes: F3 shows p50/p99 per zone, F4 starts and stops a Chrome trace capture
+    FrameProfiler profiler;
+    startProfiler(profiler);
+
+    // From here on the simulation ticks on its own thread; this thread polls input and draws
+    // the newest frame it published
+    SimulationThread sim;
+    startSimulationThread(sim, fleet, roads, timestep, aiTraffic, replay, telemetry, player, startPosition);
+    bool simPaused = true;
+    std::uint8_t sentControls = 0;
     ChangeTheme:
 
-    std::vector<std::pair<sf::RectangleShape, std::string>> escapeMenuButtons = {
-        {sf::RectangleShape(sf::Vector2f(300.f, 50.f)), "Restart"},
-        {sf::RectangleShape(sf::Vector2f(300.f, 50.f)), "Change Theme"},
-        {sf::RectangleShape(sf::Vector2f(300.f, 50.f)), "Music"},
-        {sf::RectangleShape(sf::Vector2f(300.f, 50.f)), "Quit"},
-        {sf::RectangleShape(sf::Vector2f(300.f, 50.f)), "Generate Log"}
-    };
-
-    float buttonStartY = 0; // Adjusted dynamically later
-    float buttonSpacing = 70.f;
-
-    for (size_t i = 0; i < escapeMenuButtons.size(); ++i) {
-        escapeMenuButtons[i].first.setFillColor(sf::Color(100, 100, 200));
-        if (darkMode)
-            escapeMenuButtons[i].first.setOutlineColor(sf::Color::White);
-        else
-            escapeMenuButtons[i].first.setOutlineColor(sf::Color::Black);
-        escapeMenuButtons[i].first.setOutlineThickness(2.f);
-        escapeMenuButtons[i].first.setPosition(0, buttonStartY + i * buttonSpacing); // Dynamic update later
-    }
+    UiMenu statsPanel;
+    UiMenu escapeMenu;
+    UiMenu musicMenuPanel;
+    buildStatsPanel(statsPanel, uiFont);
+    buildEscapeMenu(escapeMenu, uiFont, view.getSize());
+    buildMusicMenu(musicMenuPanel, uiFont, view.getSize());
+    UiMenu profilerPanel;
+    buildProfilerPanel(profilerPanel, uiFont);
+
+    // While the game is paused behind a menu the world is drawn once into this and reused
+    WorldLayerCache worldLayer;
    
     bool virginity = true;
     
     while (window.isOpen()) {
+        std::uint64_t frameStart = profileNow(profiler);
+        const RenderFrame& frame = latestFrame(sim);
+        float frameTime = clock.restart().asSeconds();
+        beginInputFrame(input, frameTime);
+        bool sawEvent = false;
         sf::Event event;
         while (window.pollEvent(event)) {
+            sawEvent = true;
+            handleInputEvent(input, event);
             if (event.type == sf::Event::Closed)
                 window.close();
 
@@ -184,7 +291,6 @@ int main()
                     if (!virginity && !showCar)
                     {
                         showCar = !showCar;
-                        car.shape.setOrigin(40.f, 20.f);
                     }
 
                 }
@@ -195,6 +301,12 @@ int main()
                     statsToggled = true;
                 }
 
+                // Play/Pause in the music menu (M Key)
+                if (musicMenu && event.key.code == sf::Keyboard::M && !musicMenuToggled) {
+                    toggleMusicPause(music);
+                    musicMenuToggled = true;
+                }
+
                 // Minimap Toggle (M Key)
                 if (event.key.code == sf::Keyboard::M && !minimapToggled && !showEscapeMenu && !musicMenu) {
                     enlargedMinimap = !enlargedMinimap;
@@ -210,16 +322,46 @@ int main()
                     musicMenuToggled = true;
                 }
 
+                // Profiler overlay (F3) and trace capture (F4)
+                if (event.key.code == sf::Keyboard::F3)
+                    showProfiler = !showProfiler;
+                if (event.key.code == sf::Keyboard::F4) {
+                    std::unique_lock<std::mutex> lock = lockSimulation(sim);
+                    if (profiler.capturing) {
+                        saveChromeTrace({ &profiler, &sim.profiler }, "frame_trace.json");
+                    }
+                    else {
+                        startProfileCapture(profiler);
+                        startProfileCapture(sim.profiler);
+                    }
+                }
+
+                // Quick save (F5) and quick load (F9) of the whole session
+                if (event.key.code == sf::Keyboard::F5) {
+                    std::unique_lock<std::mutex> lock = lockSimulation(sim);
+                    SessionState session = captureSession(music);
+                    takeSnapshot(quickSave, fleet, timestep, &session);
+                    saveSnapshot(quickSave, "quicksave.snapshot");
+                }
+                if (event.key.code == sf::Keyboard::F9 && (!quickSave.empty() || loadSnapshot("quicksave.snapshot", quickSave))) {
+                    std::unique_lock<std::mutex> lock = lockSimulation(sim);
+                    SessionState session;
+                    if (restoreSnapshot(quickSave, fleet, timestep, &session) && fleetSize(fleet) > player) {
+                        restoreSession(session, music);
+                        resetAiTraffic(aiTraffic);
+                        // The session replay now starts from the loaded state
+                        continueReplayFrom(replay, quickSave, timestep.tick);
+                        markSimulationChanged(sim);
+                    }
+                    else {
+                        std::cerr << "Quick save does not match this version or vehicles.txt" << std::endl;
+                        quickSave.clear();
+                    }
+                }
+
                 if (showEscapeMenu && event.key.code == sf::Keyboard::R)
                 {
-                    car.shape.setPosition(2450.f, 2064.f);
-                    if (car.hasSprite)
-                        car.sprite.setPosition(2450.f, 2064.f);
-                    car.speed = 0;
-                    car.angle = 0;
-                    car.fuel = 2000;
-                    car.mileage = 0;
-                    car.speed = 0;
+                    sendSimCommand(sim, SIM_RESET_PLAYER);
                     showEscapeMenu = !showEscapeMenu;
                 }
             }
@@ -240,7 +382,54 @@ int main()
                 musicMenuToggled = false;
             }
 
-            if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left && !showEscapeMenu) {
+            if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left && (showEscapeMenu || musicMenu)) {
+                sf::Vector2f mousePos = window.mapPixelToCoords(sf::Vector2i(event.mouseButton.x, event.mouseButton.y));
+
+                const UiButton* clicked = menuButtonAt(showEscapeMenu ? escapeMenu : musicMenuPanel, view.getCenter(), mousePos);
+                switch (clicked ? clicked->action : UI_NO_ACTION) {
+                case MENU_RESTART:
+                    // Reset car properties
+                    sendSimCommand(sim, SIM_RESET_PLAYER);
+                    showEscapeMenu = false;
+                    virginity = false;
+                    showCar = true;
+                    break;
+                case MENU_CHANGE_THEME:
+                    darkMode = !darkMode;
+                    {
+                        ProfileScope stall(profiler, PROFILE_STALL);
+                        timeDelay(0.26f);
+                    }
+                    goto ChangeTheme;
+                case MENU_MUSIC:
+                    musicMenu = true;
+                    showEscapeMenu = false;
+                    break;
+                case MENU_QUIT:
+                    window.close();
+                    break;
+                case MENU_GENERATE_LOG: {
+                    generateLogFile(frame.fleet, player);
+                    ProfileScope stall(profiler, PROFILE_STALL);
+                    timeDelay(0.26f);
+                    break;
+                }
+                case MENU_PLAY_PAUSE:
+                    toggleMusicPause(music);
+                    break;
+                case MENU_NEXT_SONG:
+                    nextSong(music);
+                    break;
+                case MENU_PREVIOUS_SONG:
+                    previousSong(music);
+                    break;
+                case MENU_BACK:
+                    musicMenu = false;  // Close the music menu
+                    showEscapeMenu = true;  // Show the escape menu
+                    break;
+                }
+            }
+            else if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
                 sf::Vector2f mousePos = window.mapPixelToCoords(sf::Vector2i(event.mouseButton.x, event.mouseButton.y));
                 sf::FloatRect miniMapBounds(view.getCenter().x + view.getSize().x / 2 - 210.f,
                     view.getCenter().y - view.getSize().y / 2 + 10.f,
@@ -252,78 +441,35 @@ int main()
             }
         }
 
-        if (carPlaced && !showEscapeMenu) {
-            float deltaTime = clock.restart().asSeconds();
-            handleInput(car, deltaTime, TURN_RATE);
-            updateCar(car, deltaTime, roadMask);
+        addProfileSample(profiler, PROFILE_INPUT, frameStart, profileNow(profiler));
 
-            view.setCenter(car.shape.getPosition());
-            window.setView(view);
+        // The simulation thread only needs to hear what the player holds and whether a menu
+        // paused the game; rendering interpolates past the last tick it published
+        {
+            ProfileScope scope(profiler, PROFILE_AUDIO);
+            updateMusicPlayer(music, frameTime);
         }
-        if (carPlaced && !showEscapeMenu) {
-            float deltaTime = clock.restart().asSeconds();
-            handleInput(car, deltaTime, TURN_RATE);
-            updateCar(car, deltaTime, roadMask);
-
-            view.setCenter(car.shape.getPosition());
-            restrictView(view, mapTexture.getSize());  // Add this line
+        std::uint8_t controls = inputControls(input);
+        if (controls != sentControls && sendSimCommand(sim, SIM_SET_CONTROLS, controls))
+            sentControls = controls;
+        bool pause = !carPlaced || showEscapeMenu || musicMenu || escapeMenuToggled;
+        if (pause != simPaused && sendSimCommand(sim, pause ? SIM_PAUSE : SIM_RESUME))
+            simPaused = pause;
+        float alpha = frameAlpha(frame);
+        sf::Vector2f playerPosition = vehicleRenderPosition(frame.fleet, player, alpha);
 
-            window.setView(view);
-        }
         if (carPlaced && !showEscapeMenu) {
-            float deltaTime = clock.restart().asSeconds();
-            handleInput(car, deltaTime, TURN_RATE);
-            updateCar(car, deltaTime, roadMask);
-
-            view.setCenter(car.shape.getPosition());
-            restrictView(view, mapTexture.getSize());  // Add this line
+            view.setCenter(playerPosition);
+            restrictView(view, worldSize);
 
             window.setView(view);
         }
-        if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left && showEscapeMenu) {
-            sf::Vector2f mousePos = window.mapPixelToCoords(sf::Vector2i(event.mouseButton.x, event.mouseButton.y));
-
-            for (size_t i = 0; i < escapeMenuButtons.size(); ++i) {
-                if (escapeMenuButtons[i].first.getGlobalBounds().contains(mousePos)) {
-                    if (escapeMenuButtons[i].second == "Restart") {
-                        // Reset car properties
-                        car.shape.setPosition(2450.f, 2064.f);
-                        if (car.hasSprite)
-                            car.sprite.setPosition(2450.f, 2064.f);
-                        car.speed = 0;
-                        car.angle = 0;
-                        car.fuel = 2000;
-                        car.mileage = 0;
-                        car.position.x = 0;
-                        car.position.y = 0;
-                        showEscapeMenu = false;
-                        virginity = false;
-                        showCar = true;
-                    }
-                    else if (escapeMenuButtons[i].second == "Change Theme") {
-
-                        darkMode = !darkMode;
-                        timeDelay(0.26f);
-                        goto ChangeTheme;
-                       
-                    }
-                    else if (escapeMenuButtons[i].second == "Music") {
-                        musicMenu = true;
-                        showEscapeMenu = false;
-                    }
-                    else if (escapeMenuButtons[i].second == "Quit") {
-                        window.close();
-                    }
-                    else if (escapeMenuButtons[i].second == "Generate Log") {
-
-                        generateLogFile(car);
-                        timeDelay(0.26f);
-                    }
-                }
-            }
+        // Stream the tiles around whatever view the window is drawing with
+        bool tilesChanged;
+        {
+            ProfileScope scope(profiler, PROFILE_WORLD);
+            tilesChanged = updateTileStreamer(mapTiles, window.getView());
         }
-        window.clear();
-        window.draw(mapSprite);
         if (!showEscapeMenu && escapeCount == 0)
         {
             showEscapeMenu = !showEscapeMenu;
@@ -334,470 +480,313 @@ int main()
                 for (auto& y : x)
                     *ptr += y.second;
         }
-        if (car.hasSprite && showCar) {
-            window.draw(car.sprite);
-        }
-        else {
-            window.draw(car.shape);
-        }
 
-        if (showStats) {
-            drawInteractiveStats(window, car, view);
+        // While paused, the world only looks different when the simulation republishes, the view
+        // moves, a tile arrives or a layer is toggled, and the UI only after an event or a label
+        // change. An unchanged world comes from the cache; an unchanged frame isn't drawn at all.
+        WorldLayerKey worldKey;
+        worldKey.frame = frame.sequence;
+        worldKey.alpha = alpha;
+        worldKey.viewCenter = window.getView().getCenter();
+        worldKey.viewSize = window.getView().getSize();
+        worldKey.layers = (showCar ? WORLD_LAYER_CAR : 0) | (showStats ? WORLD_LAYER_STATS : 0)
+            | (enlargedMinimap ? WORLD_LAYER_ENLARGED_MINIMAP : 0);
+        if (!pause || tilesChanged)
+            invalidateWorldLayer(worldLayer);
+        bool worldCurrent = worldLayerCurrent(worldLayer, worldKey);
+        bool musicChanged = musicMenu && updateMusicMenu(musicMenuPanel, music);
+        if (worldCurrent && !sawEvent && !musicChanged && !showProfiler) {
+            // The last presented frame is still exactly right
+            {
+                ProfileScope stall(profiler, PROFILE_STALL);
+                sf::sleep(sf::seconds(IDLE_FRAME_TIME));
+            }
+            addProfileSample(profiler, PROFILE_FRAME, frameStart, profileNow(profiler));
+            endProfileFrame(profiler);
+            continue;
         }
 
-        if (enlargedMinimap) {
-            showMiniMape(window, view, enlargedMiniMap);
+        if (worldCurrent) {
+            ProfileScope scope(profiler, PROFILE_WORLD);
+            drawWorldLayer(window, worldLayer);
         }
         else {
-            drawDynamicMinimap(window, miniMap, view, car);
-        }
+            sf::RenderTarget* layer = pause ? beginWorldLayer(worldLayer, window.getSize(), window.getView(), worldKey) : nullptr;
+            sf::RenderTarget& target = layer ? *layer : window;
 
+            // The enlarged minimap stands in for tiles that are still loading
+            {
+                ProfileScope scope(profiler, PROFILE_WORLD);
+                target.clear();
+                drawWorldTiles(target, mapTiles, target.getView(), &enlargedMinimapLayer.texture.getTexture(), 0.27f);
+            }
+            if (showCar) {
+                ProfileScope scope(profiler, PROFILE_VEHICLES);
+                drawFleet(target, vehicleSprites, frame.fleet, alpha, view);
+            }
 
-        if (showEscapeMenu) {
-            // Update button positions dynamically based on the view
-            float buttonStartY = view.getCenter().y - 100.f; // Center vertically
-            for (size_t i = 0; i < escapeMenuButtons.size(); ++i) {
-                escapeMenuButtons[i].first.setPosition(view.getCenter().x - 150.f, buttonStartY + i * 70.f);
+            if (showStats) {
+                ProfileScope scope(profiler, PROFILE_UI);
+                drawInteractiveStats(target, statsPanel, frame.fleet, player, roads, view);
             }
 
-            // Draw the escape menu with clickable buttons
-            drawEscapeMenu(window, view, escapeMenuButtons);
+            if (enlargedMinimap) {
+                ProfileScope scope(profiler, PROFILE_MINIMAP);
+                showMiniMape(target, view, enlargedMinimapLayer, vehicleSprites, frame.fleet, player, alpha);
+            }
+            else {
+                ProfileScope scope(profiler, PROFILE_MINIMAP);
+                drawDynamicMinimap(target, cornerMinimap, view, vehicleSprites, frame.fleet, player, alpha);
+            }
+
+            if (layer) {
+                endWorldLayer(worldLayer);
+                drawWorldLayer(window, worldLayer);
+            }
+        }
+
+        std::uint64_t uiStart = profileNow(profiler);
+        if (showProfiler) {
+            drawProfilerOverlay(window, profilerPanel, profiler, sim, view);
+        }
+
+        if (showEscapeMenu) {
+            // Draw the escape menu with clickable buttons, anchored on the view center
+            drawEscapeMenu(window, view, escapeMenu);
         }
         if (musicMenu) {
-            showMusicMenu(window, view, backgroundMusic, songList, currentSongIndex, volume);
+            showMusicMenu(window, view, musicMenuPanel);
         }
+        addProfileSample(profiler, PROFILE_UI, uiStart, profileNow(profiler));
 
-        window.display();
+        {
+            ProfileScope scope(profiler, PROFILE_PRESENT);
+            window.display();
+        }
+        addProfileSample(profiler, PROFILE_FRAME, frameStart, profileNow(profiler));
+        endProfileFrame(profiler);
     }
 
+    // The simulated state belongs to this thread again once the simulation thread has stopped
+    stopSimulationThread(sim);
+    if (profiler.capturing)
+        saveChromeTrace({ &profiler, &sim.profiler }, "frame_trace.json");
+    endReplay(replay, fleet, player, timestep.tick);
+    saveReplay(replay, "last_session.replay");
     return 0;
 }
 
-bool isKeyReady(sf::Keyboard::Key key, float cooldownTime) {
-    // Check if the cooldown has elapsed for the given key
-    if (keyCooldowns[key].getElapsedTime().asSeconds() >= cooldownTime) {
-        keyCooldowns[key].restart();
-        return true;
+SessionState captureSession(const MusicPlayer& music) {
+    SessionState session;
+    for (int action = 0; action < ACTION_COUNT; ++action) {
+        if (input.fired & (1u << action))
+            session.keyCooldowns.emplace_back(action, static_cast<std::uint32_t>(input.tick - input.lastFired[action]));
     }
-    return false;
+    session.song = music.current;
+    session.songOffset = musicOffset(music);
+    return session;
 }
 
-void handleInput(Car& car, float deltaTime, float handling) {
-    if (car.fuel <= 0)
-        return;
-
-    // Define friction and drag coefficients
-    const float FRICTION = 26.f;  // Friction opposing movement
-    const float DRAG = 0.02f;     // Air resistance
-
-    // Acceleration and braking
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::W)) {
-        car.speed += ACCELERATION * deltaTime;
-        if (car.speed > MAX_SPEED)
-            car.speed = MAX_SPEED;
-        car.fuel -= 5 * deltaTime; // Consume more fuel for acceleration
-    }
-
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::S)) {
-        car.speed -= ACCELERATION * deltaTime * 0.5f;
-        if (car.speed < -MAX_SPEED / 3)
-            car.speed = -MAX_SPEED / 3;
-        car.fuel -= 2 * deltaTime;
-    }
-
-
-    // Apply drag and friction
-    car.speed *= (1 - DRAG * deltaTime);  // Simulates air resistance
-    if (car.speed > 0) {
-        car.speed -= FRICTION * deltaTime;
-        if (car.speed < 0) car.speed = 0;
-    }
-    else if (car.speed < 0) {
-        car.speed += FRICTION * deltaTime;
-        if (car.speed > 0) car.speed = 0;
-    }
-
-    // Turning with dynamic handling based on speed
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::A) && std::abs(car.speed) > MIN_TURN_SPEED) {
-        car.angle -= handling * deltaTime * (car.speed / MAX_SPEED);
-    }
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::D) && std::abs(car.speed) > MIN_TURN_SPEED) {
-        car.angle += handling * deltaTime * (car.speed / MAX_SPEED);
+void restoreSession(const SessionState& session, MusicPlayer& music) {
+    input.fired = 0;
+    for (const auto& cooldown : session.keyCooldowns) {
+        if (cooldown.first < 0 || cooldown.first >= ACTION_COUNT)
+            continue;
+        input.lastFired[cooldown.first] = input.tick - cooldown.second;
+        input.fired |= 1u << cooldown.first;
     }
+    if (session.song >= 0)
+        seekMusic(music, session.song, session.songOffset);
 }
 
-void updateCar(Car& car, float deltaTime, const sf::Image& roadMask) {
-    if (!escapeMenuToggled && !musicMenu) {
-        float angleRadians = car.angle * 3.14159f / 180.f;
-        sf::Vector2f movement(std::cos(angleRadians) * car.speed * deltaTime,
-            std::sin(angleRadians) * car.speed * deltaTime);
-
-        sf::Vector2f newPosition = car.shape.getPosition() + movement;
-
-        if (newPosition.x < 0 || newPosition.y < 0 ||
-            newPosition.x >= roadMask.getSize().x || newPosition.y >= roadMask.getSize().y) {
-            car.speed *= 0.5f; // Halve speed on collision with boundaries
-            return;
-        }
-
-        sf::Color pixelColor = roadMask.getPixel(static_cast<unsigned int>(newPosition.x),
-            static_cast<unsigned int>(newPosition.y));
-        if (pixelColor == sf::Color::Black) {
-            car.speed *= 0.7f; // Reduce speed more significantly on off-road
-            return;
-        }
-        else if (pixelColor == sf::Color::Green)
-        {
-
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::F) && isKeyReady(sf::Keyboard::F, 0.33f))
-            {
-                if (car.fuel < 1051)
-                    car.fuel += 10;
-
-                else
-                    car.fuel += (2000 - car.fuel);
-            }
-
-
-        }
-
-        car.shape.move(movement);
-        car.shape.setRotation(car.angle);
-
-        if (car.hasSprite) {
-            car.sprite.setPosition(car.shape.getPosition());
-            car.sprite.setRotation(car.angle);
-        }
-        float dx = car.speed * cos(car.angle) * deltaTime;
-        float dy = car.speed * sin(car.angle) * deltaTime;
-
-        car.position.x += dx;
-        car.position.y += dy;
-
-        // Accumulate mileage
-        car.mileage += std::sqrt(dx * dx + dy * dy);
+void buildStatsPanel(UiMenu& panel, const sf::Font& font) {
+    // Button properties, relative to the top-left corner of the view
+    const float buttonWidth = 180.f;
+    const float buttonHeight = 40.f;
+    const float buttonSpacing = 10.f;
 
+    const char* stats[] = { "Fuel", "Speed", "Position", "Mileage", "Fuel Station" };
+    for (int i = 0; i < 5; ++i) {
+        UiButton& button = addButton(panel, font, UI_NO_ACTION, stats[i],
+            sf::FloatRect(0.f, (buttonHeight + buttonSpacing) * i, buttonWidth, buttonHeight), 14, darkMode);
+        button.centered = false;
     }
 }
 
-void drawInteractiveStats(sf::RenderWindow& window, const Car& car, const sf::View& view) {
-    sf::Font font;
-    if (!font.loadFromFile("arial.ttf")) {
-        std::cerr << "Error loading font!" << std::endl;
-        return;
-    }
-
-    // Button properties
-    const float buttonWidth = 180.f;
-    const float buttonHeight = 40.f;
-    const float buttonSpacing = 10.f;
+void drawInteractiveStats(sf::RenderTarget& target, UiMenu& panel, const Fleet& fleet, size_t vehicle, const RoadMap& roads, const sf::View& view) {
     const sf::Vector2f startPos(view.getCenter().x - view.getSize().x / 2 + 20.f,
         view.getCenter().y - view.getSize().y / 2 + 20.f);
 
-    // Create reusable button style
-    auto createButton = [&](const std::string& label, float yOffset) {
-        sf::RectangleShape button(sf::Vector2f(buttonWidth, buttonHeight));
-        button.setFillColor(sf::Color(100, 100, 200)); // Blue with slight transparency
-        if (darkMode)
-            button.setOutlineColor(sf::Color::White);
-        else
-            button.setOutlineColor(sf::Color::Black);
-        button.setOutlineThickness(2.f);
-        button.setPosition(startPos.x, startPos.y + yOffset);
-
-        sf::Text buttonText;
-        buttonText.setFont(font);
-        buttonText.setString(label);
-        buttonText.setCharacterSize(14);
-        buttonText.setFillColor(sf::Color::White);
-        buttonText.setPosition(button.getPosition().x + 10.f, button.getPosition().y + 10.f);
-
-        return std::make_pair(button, buttonText);
-        };
-
-    // Create buttons
-    std::vector<std::pair<sf::RectangleShape, sf::Text>> buttons;
-
     // Fuel stat
-    buttons.push_back(createButton("Fuel: " + std::to_string(static_cast<int>(car.fuel) / 20) + "%", 0.f));
+    setButtonLabel(panel.buttons[0], "Fuel: " + std::to_string(static_cast<int>(fleet.fuel[vehicle]) / 20) + "%");
 
     // Speed stat
-    buttons.push_back(createButton("Speed: " + std::to_string(static_cast<int>(std::abs(car.speed) / 2)) + " km/h",
-        (buttonHeight + buttonSpacing) * 1));
+    setButtonLabel(panel.buttons[1], "Speed: " + std::to_string(static_cast<int>(std::abs(fleet.speed[vehicle]) / 2)) + " km/h");
 
     // X-Y position
-    buttons.push_back(createButton("Position: (" + std::to_string(static_cast<int>(car.position.x)) + ", " +
-        std::to_string(static_cast<int>(car.position.y)) + ")",
-        (buttonHeight + buttonSpacing) * 2));
+    setButtonLabel(panel.buttons[2], "Position: (" + std::to_string(static_cast<int>(fleet.positionX[vehicle])) + ", " +
+        std::to_string(static_cast<int>(fleet.positionY[vehicle])) + ")");
 
     // Mileage stat
-    buttons.push_back(createButton("Mileage: " + std::to_string(static_cast<int>((car.mileage) / 1000) / 2) + " km",
-        (buttonHeight + buttonSpacing) * 3));
-
-    // Draw buttons
-    for (const auto& button : buttons) {
-        window.draw(button.first);  // Draw button background
-        window.draw(button.second); // Draw button text
+    setButtonLabel(panel.buttons[3], "Mileage: " + std::to_string(static_cast<int>((fleet.mileage[vehicle]) / 1000) / 2) + " km");
+
+    // Nearest fuel station, from the zone index rather than the pixels around the car
+    float x = fleet.positionX[vehicle], y = fleet.positionY[vehicle];
+    std::uint32_t zone = zoneAt(roads.zones, x, y);
+    std::uint32_t station = nearestFuelZone(roads.zones, x, y);
+    if (zone != NO_SURFACE_ZONE && roads.zones.zones[zone].type == SURFACE_FUEL) {
+        setButtonLabel(panel.buttons[4], "Fuel Station: here");
+    }
+    else if (station != NO_SURFACE_ZONE) {
+        const SurfaceZone& fuel = roads.zones.zones[station];
+        float distance = std::hypot(fuel.centroidX - x, fuel.centroidY - y);
+        setButtonLabel(panel.buttons[4], "Fuel Station: " + std::to_string(static_cast<int>(distance) / 2) + " m");
+    }
+    else {
+        setButtonLabel(panel.buttons[4], "Fuel Station: none");
     }
-}
-
-void showMiniMape(sf::RenderWindow& window, const sf::View& view, sf::Sprite map) {
-    // Define the original resolution of the map sprite
-    float originalWidth = 3000.f;
-    float originalHeight = 2258.f;
-
-    // Scale the map sprite to your desired scale
-    float scaleFactor = 0.27f;  // Example scale factor (10%)
-
-    map.setScale(scaleFactor, scaleFactor);
-
-    // Get the scaled size of the map
-    float scaledWidth = originalWidth * scaleFactor;
-    float scaledHeight = originalHeight * scaleFactor;
-
-    // Position the map sprite so that its center aligns with the view's center
-    map.setPosition(view.getCenter().x - scaledWidth / 2, view.getCenter().y - scaledHeight / 2);
 
-    // Draw the map sprite
-    window.draw(map);
+    drawMenu(target, panel, startPos);
 }
 
-void drawEscapeMenu(sf::RenderWindow& window, const sf::View& view,
-    std::vector<std::pair<sf::RectangleShape, std::string>>& escapeMenuButtons) {
-    // Create semi-transparent overlay
-    sf::RectangleShape menuOverlay(sf::Vector2f(view.getSize().x, view.getSize().y));
-    if (darkMode)
-        menuOverlay.setFillColor(sf::Color(0, 0, 0, 150));
-    else
-        menuOverlay.setFillColor(sf::Color(175, 175, 175, 150));
-    menuOverlay.setPosition(view.getCenter().x - view.getSize().x / 2, view.getCenter().y - view.getSize().y / 2);
-
-    // Load font
-    sf::Font font;
-    if (!font.loadFromFile("arial.ttf")) {
-        std::cerr << "Error loading font!" << std::endl;
-        return;
+void buildProfilerPanel(UiMenu& panel, const sf::Font& font) {
+    // A header row, then one row per zone: name, p50 and p99 in their own columns
+    const float rowHeight = 20.f;
+    sf::RectangleShape background(sf::Vector2f(250.f, rowHeight * (PROFILE_ZONE_COUNT + 1) + 10.f));
+    background.setFillColor(darkMode ? UI_DARK_OVERLAY : UI_LIGHT_OVERLAY);
+    background.setOutlineColor(darkMode ? sf::Color::White : sf::Color::Black);
+    background.setOutlineThickness(2.f);
+    addPanel(panel, background);
+
+    panel.labels.resize((PROFILE_ZONE_COUNT + 1) * 3);
+    const float columns[3] = { 10.f, 110.f, 180.f };
+    for (int row = 0; row <= PROFILE_ZONE_COUNT; ++row) {
+        for (int column = 0; column < 3; ++column) {
+            UiLabel& label = panel.labels[row * 3 + column];
+            initLabel(label, font, 14, "");
+            label.text.setPosition(columns[column], 5.f + row * rowHeight);
+        }
     }
+    setLabelString(panel.labels[0], "Zone (ms)");
+    setLabelString(panel.labels[1], "p50");
+    setLabelString(panel.labels[2], "p99");
+}
 
-    // Set up text for button labels
-    sf::Text buttonText;
-    buttonText.setFont(font);
-    buttonText.setCharacterSize(25);
-    buttonText.setFillColor(sf::Color::White);
-
-    // Draw overlay
-    window.draw(menuOverlay);
+void drawProfilerOverlay(sf::RenderWindow& window, UiMenu& panel, const FrameProfiler& profiler, SimulationThread& sim, const sf::View& view) {
+    // Right of the Tab stats panel
+    const sf::Vector2f startPos(view.getCenter().x - view.getSize().x / 2 + 220.f,
+        view.getCenter().y - view.getSize().y / 2 + 20.f);
 
-    // Draw buttons and their labels
-    for (auto& button : escapeMenuButtons) {
-        if (button.second == "Restart" && !showRestartButton) {
-            // Change the label to "Continue"
-            buttonText.setString("Start");
-        }
-        else {
-            // Use the existing label
-            buttonText.setString(button.second);
+    // AI, physics and recording run on the simulation thread; their figures are per simulation step
+    if (profiler.frames % PROFILER_REFRESH_FRAMES == 0 || panel.labels[3].content.empty()) {
+        std::unique_lock<std::mutex> lock = lockSimulation(sim);
+        char figure[16];
+        for (int zone = 0; zone < PROFILE_ZONE_COUNT; ++zone) {
+            bool simulated = zone == PROFILE_AI || zone == PROFILE_PHYSICS || zone == PROFILE_RECORD;
+            const FrameProfiler& source = simulated ? sim.profiler : profiler;
+            UiLabel* row = &panel.labels[(zone + 1) * 3];
+            setLabelString(row[0], std::string(profileZoneName(static_cast<ProfileZone>(zone))) + (simulated ? " (sim)" : ""));
+            std::snprintf(figure, sizeof(figure), "%.2f", profilePercentile(source, static_cast<ProfileZone>(zone), 0.5f));
+            setLabelString(row[1], figure);
+            std::snprintf(figure, sizeof(figure), "%.2f", profilePercentile(source, static_cast<ProfileZone>(zone), 0.99f));
+            setLabelString(row[2], figure);
         }
+    }
 
-        // Draw the button
-        window.draw(button.first);
+    drawMenu(window, panel, startPos);
+}
 
-        // Center the text on the button
-        buttonText.setPosition(
-            button.first.getPosition().x + (button.first.getSize().x - buttonText.getLocalBounds().width) / 2.f,
-            button.first.getPosition().y + (button.first.getSize().y - buttonText.getLocalBounds().height) / 2.f - 5.f);
+void showMiniMape(sf::RenderTarget& target, const sf::View& view, MinimapLayer& minimap, FleetSprites& sprites, const Fleet& fleet, size_t player, float alpha) {
+    // The whole map, pre-rendered at 0.27 scale, centered on the view
+    sf::Vector2f size(minimap.texture.getSize());
+    sf::Vector2f position(view.getCenter().x - size.x / 2, view.getCenter().y - size.y / 2);
+    drawMinimapLayer(target, minimap, position);
 
-        // Draw the button text
-        window.draw(buttonText);
-    }
+    // Vehicle markers on top
+    sf::Vector2f mapSize(minimap.sourceSize);
+    drawFleetMarkers(target, sprites, fleet, player, alpha, mapSize, sf::FloatRect(position.x, position.y, size.x, size.y));
 }
 
-void showMusicMenu(sf::RenderWindow& window, const sf::View& view, sf::Music& backgroundMusic, std::vector<std::string>& songList, int& currentSongIndex, float& volume) {
-    // Create the overlay for the menu
-    sf::RectangleShape menuOverlay(sf::Vector2f(view.getSize().x, view.getSize().y));
-    if(darkMode)
-        menuOverlay.setFillColor(sf::Color(0, 0, 0, 150));
-    else
-        menuOverlay.setFillColor(sf::Color(175, 175, 175, 150));
-    menuOverlay.setPosition(view.getCenter().x - view.getSize().x / 2, view.getCenter().y - view.getSize().y / 2);
-
-    // Load the font
-    sf::Font font;
-    if (!font.loadFromFile("arial.ttf")) {
-        std::cerr << "Error loading font!" << std::endl;
-        return;
+void buildEscapeMenu(UiMenu& menu, const sf::Font& font, const sf::Vector2f& viewSize) {
+    setMenuOverlay(menu, viewSize, darkMode);
+
+    const char* labels[] = { "Restart", "Change Theme", "Music", "Quit", "Generate Log" };
+    const MenuAction actions[] = { MENU_RESTART, MENU_CHANGE_THEME, MENU_MUSIC, MENU_QUIT, MENU_GENERATE_LOG };
+    for (int i = 0; i < 5; ++i) {
+        UiButton& button = addButton(menu, font, actions[i], labels[i], sf::FloatRect(-150.f, -100.f + i * 70.f, 300.f, 50.f), 25, darkMode);
+        button.labelOffsetY = -5.f;
     }
+}
 
-    // Create the title text
-    sf::Text title("Music Menu", font, 24);
-    title.setFillColor(sf::Color::White);
-    title.setStyle(sf::Text::Bold | sf::Text::Underlined);
-    title.setPosition(view.getCenter().x - title.getLocalBounds().width / 2.f, view.getCenter().y - 250.f);
+void drawEscapeMenu(sf::RenderWindow& window, const sf::View& view, UiMenu& menu) {
+    // "Restart" reads "Start" until the game has been started once
+    setButtonLabel(menu.buttons[0], showRestartButton ? "Restart" : "Start");
 
-    // Create volume text
-    sf::Text volumeText("Volume: " + std::to_string(static_cast<int>(volume)) + "%", font, 20);
-    volumeText.setFillColor(sf::Color::White);
-    volumeText.setPosition(view.getCenter().x - volumeText.getLocalBounds().width / 2.f, view.getCenter().y - 180.f);
+    drawMenu(window, menu, view.getCenter());
+}
 
-    // Create current song text
-    sf::Text currentSongText("Current Song: " + songList[currentSongIndex], font, 20);
-    currentSongText.setFillColor(sf::Color::White);
-    currentSongText.setPosition(view.getCenter().x - currentSongText.getLocalBounds().width / 2.f, view.getCenter().y - 130.f);
+void buildMusicMenu(UiMenu& menu, const sf::Font& font, const sf::Vector2f& viewSize) {
+    setMenuOverlay(menu, viewSize, darkMode);
 
     // Create a background box for the text elements
-    sf::RectangleShape infoBox(sf::Vector2f(400.f, 180.f)); // Box size (adjusted for all text)
-    infoBox.setFillColor(sf::Color(100, 100, 200, 180)); // Semi-transparent black box
-    if(darkMode)
-        infoBox.setOutlineColor(sf::Color::White); // White outline
-    else
-        infoBox.setOutlineColor(sf::Color::Black);
-    infoBox.setOutlineThickness(2.f); // Outline thickness
-    infoBox.setPosition(view.getCenter().x - 200.f, view.getCenter().y - 220.f); // Position the box
-
-    // Draw the overlay and text box
-    window.draw(menuOverlay);
-    window.draw(infoBox);  // Draw the background box
-
-    // Draw the text elements inside the box
-    window.draw(title);
-    window.draw(volumeText);
-    window.draw(currentSongText);
-
-    // Create buttons for Play/Pause, Next Song, Previous Song, and Back
-    std::vector<std::pair<sf::RectangleShape, std::string>> musicMenuButtons = {
-        {sf::RectangleShape(sf::Vector2f(300.f, 50.f)), "Play/Pause"},
-        {sf::RectangleShape(sf::Vector2f(300.f, 50.f)), "Next Song"},
-        {sf::RectangleShape(sf::Vector2f(300.f, 50.f)), "Previous Song"},
-        {sf::RectangleShape(sf::Vector2f(300.f, 50.f)), "Back"}
-    };
-
-    // Set up button appearance and position
-    float buttonStartY = view.getCenter().y - 30.f; // Adjust vertically based on the view
-    float buttonSpacing = 70.f;
-
-    for (size_t i = 0; i < musicMenuButtons.size(); ++i) {
-        // Set button color and outline
-        musicMenuButtons[i].first.setFillColor(sf::Color(100, 100, 200));  // Light gray button color
-        if (darkMode)
-            musicMenuButtons[i].first.setOutlineColor(sf::Color::White);  // White outline
-        else
-            musicMenuButtons[i].first.setOutlineColor(sf::Color::Black);
-        musicMenuButtons[i].first.setOutlineThickness(2.f);  // Outline thickness
-        musicMenuButtons[i].first.setPosition(view.getCenter().x - 150.f, buttonStartY + i * buttonSpacing);
-
-        // Create text for each button
-        sf::Text buttonText(musicMenuButtons[i].second, font, 20);
-        buttonText.setFillColor(sf::Color::White);  // White text
-        buttonText.setPosition(musicMenuButtons[i].first.getPosition().x + (musicMenuButtons[i].first.getSize().x / 2.f) - buttonText.getLocalBounds().width / 2.f,
-            musicMenuButtons[i].first.getPosition().y + (musicMenuButtons[i].first.getSize().y / 2.f) - buttonText.getLocalBounds().height / 2.f);
-
-        // Draw button rectangle and textsddd
-        window.draw(musicMenuButtons[i].first);  // Draw the button rectangle
-        window.draw(buttonText);  // Draw the button text
-    }
+    sf::RectangleShape infoBox(sf::Vector2f(400.f, 180.f));
+    infoBox.setFillColor(sf::Color(100, 100, 200, 180));
+    infoBox.setOutlineColor(darkMode ? sf::Color::White : sf::Color::Black);
+    infoBox.setOutlineThickness(2.f);
+    infoBox.setPosition(-200.f, -220.f);
+    addPanel(menu, infoBox);
+
+    // Title, volume and current song; the last two are re-centered when their string changes
+    menu.labels.resize(3);
+    initLabel(menu.labels[0], font, 24, "Music Menu");
+    menu.labels[0].text.setStyle(sf::Text::Bold | sf::Text::Underlined);
+    centerLabel(menu.labels[0], 0.f, -250.f);
+    initLabel(menu.labels[1], font, 20, "");
+    initLabel(menu.labels[2], font, 20, "");
+
+    // Buttons for Play/Pause, Next Song, Previous Song, and Back
+    const char* labels[] = { "Play/Pause", "Next Song", "Previous Song", "Back" };
+    const MenuAction actions[] = { MENU_PLAY_PAUSE, MENU_NEXT_SONG, MENU_PREVIOUS_SONG, MENU_BACK };
+    for (int i = 0; i < 4; ++i)
+        addButton(menu, font, actions[i], labels[i], sf::FloatRect(-150.f, -30.f + i * 70.f, 300.f, 50.f), 20, darkMode);
+}
 
-    // Event handling for button clicks
-    sf::Event event;
-    while (window.pollEvent(event)) {
-        if (event.type == sf::Event::Closed)
-            window.close();
-
-        if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
-            sf::Vector2f mousePos = window.mapPixelToCoords(sf::Vector2i(event.mouseButton.x, event.mouseButton.y));
-
-            // Check if any of the main menu buttons were clicked
-            for (size_t i = 0; i < musicMenuButtons.size(); ++i) {
-                if (musicMenuButtons[i].first.getGlobalBounds().contains(mousePos)) {
-                    if (musicMenuButtons[i].second == "Play/Pause") {
-                        if (backgroundMusic.getStatus() == sf::Music::Playing) {
-                            backgroundMusic.pause();
-                        }
-                        else {
-                            backgroundMusic.play();
-                        }
-                    }
-                    else if (musicMenuButtons[i].second == "Next Song") {
-                        currentSongIndex = (currentSongIndex + 1) % songList.size();
-                        if (!backgroundMusic.openFromFile(songList[currentSongIndex])) {
-                            std::cerr << "Error loading song: " << songList[currentSongIndex] << std::endl;
-                        }
-                        else {
-                            backgroundMusic.play();
-                        }
-                    }
-                    else if (musicMenuButtons[i].second == "Previous Song") {
-                        currentSongIndex = (currentSongIndex - 1 + songList.size()) % songList.size();
-                        if (!backgroundMusic.openFromFile(songList[currentSongIndex])) {
-                            std::cerr << "Error loading song: " << songList[currentSongIndex] << std::endl;
-                        }
-                        else {
-                            backgroundMusic.play();
-                        }
-                    }
-                    else if (musicMenuButtons[i].second == "Back") {
-                        musicMenu = false;  // Close the music menu
-                        showEscapeMenu = true;  // Show the escape menu
-                    }
-                }
-            }
-        }
+bool updateMusicMenu(UiMenu& menu, MusicPlayer& music) {
+    // Keyboard shortcuts; clicks and M are handled with the other window events
+    if (inputReady(input, ACTION_PREVIOUS_SONG, MUSIC_KEY_COOLDOWN)) {
+        previousSong(music);
     }
 
-    // Keyboard shortcuts handling
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::M)) {
-        if (backgroundMusic.getStatus() == sf::Music::Playing) {
-            backgroundMusic.pause();
-        }
-        else {
-            backgroundMusic.play();
-        }
+    if (inputReady(input, ACTION_NEXT_SONG, MUSIC_KEY_COOLDOWN)) {
+        nextSong(music);
     }
 
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left) && isKeyReady(sf::Keyboard::Left, 0.2f)) {
-        currentSongIndex = (currentSongIndex - 1 + songList.size()) % songList.size();
-        if (!backgroundMusic.openFromFile(songList[currentSongIndex])) {
-            std::cerr << "Error loading song: " << songList[currentSongIndex] << std::endl;
-        }
-        else {
-            backgroundMusic.play();
-        }
+    if (inputReady(input, ACTION_VOLUME_UP, MUSIC_KEY_COOLDOWN)) {
+        setMusicVolume(music, std::min(music.volume + 5.f, 100.f));
     }
 
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right) && isKeyReady(sf::Keyboard::Right, 0.2f)) {
-        currentSongIndex = (currentSongIndex + 1) % songList.size();
-        if (!backgroundMusic.openFromFile(songList[currentSongIndex])) {
-            std::cerr << "Error loading song: " << songList[currentSongIndex] << std::endl;
-        }
-        else {
-            backgroundMusic.play();
-        }
+    if (inputReady(input, ACTION_VOLUME_DOWN, MUSIC_KEY_COOLDOWN)) {
+        setMusicVolume(music, std::max(music.volume - 5.f, 0.f));
     }
 
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up) && isKeyReady(sf::Keyboard::Up, 0.2f)) {
-        volume = std::min(volume + 5.f, 100.f);
-        backgroundMusic.setVolume(volume);
+    // Volume and song are laid out again only when they change, which is also when the menu needs drawing
+    bool changed = false;
+    if (setLabelString(menu.labels[1], "Volume: " + std::to_string(static_cast<int>(music.volume)) + "%")) {
+        centerLabel(menu.labels[1], 0.f, -180.f);
+        changed = true;
     }
-
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down) && isKeyReady(sf::Keyboard::Down, 0.2f)) {
-        volume = std::max(volume - 5.f, 0.f);
-        backgroundMusic.setVolume(volume);
+    if (setLabelString(menu.labels[2], "Current Song: " + currentSongName(music))) {
+        centerLabel(menu.labels[2], 0.f, -130.f);
+        changed = true;
     }
+    return changed;
 }
 
-void drawMinimap(sf::RenderWindow& window, sf::RenderTexture& miniMapTexture, const sf::Sprite& mapSprite, const sf::View& view, bool enlarged)
-{
-
-    miniMapTexture.clear();
-    miniMapTexture.draw(mapSprite);
-    miniMapTexture.display();
-
-    sf::Sprite miniMapSprite(miniMapTexture.getTexture());
-    miniMapSprite.setScale(0.25f, 0.25f);
-    miniMapSprite.setPosition(view.getCenter().x + view.getSize().x / 2 - 210.f, view.getCenter().y - view.getSize().y / 2 + 10.f);
-    window.draw(miniMapSprite);
+void showMusicMenu(sf::RenderWindow& window, const sf::View& view, UiMenu& menu) {
+    drawMenu(window, menu, view.getCenter());
 }
 
-void generateLogFile(const Car& car) {
+void generateLogFile(const Fleet& fleet, size_t vehicle) {
     std::ofstream logFile("car_simulation_log.txt", std::ios::app);
     if (!logFile) {
         std::cerr << "Error opening log file!" << std::endl;
@@ -819,12 +808,12 @@ void generateLogFile(const Car& car) {
     std::strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", &timeInfo);
     // Write car details to the log file
     logFile << "Log Timestamp: " << timeStr << "\n";
-    logFile << "Car Position: (" << car.shape.getPosition().x << ", " << car.shape.getPosition().y << ")\n";
-    logFile << "Mileage: " << car.mileage / 2000 << " km\n";
-    logFile << "Fuel: " << car.fuel / 20 << " L\n";
+    logFile << "Car Position: (" << fleet.positionX[vehicle] << ", " << fleet.positionY[vehicle] << ")\n";
+    logFile << "Mileage: " << fleet.mileage[vehicle] / 2000 << " km\n";
+    logFile << "Fuel: " << fleet.fuel[vehicle] / 20 << " L\n";
     srand(time(0));
     logFile << "Engine Temperature: " << ((rand() % 50) + 50) << "C\n";
-    logFile << "Tire Wear: " << int(car.mileage / 1000) << "%\n";
+    logFile << "Tire Wear: " << int(fleet.mileage[vehicle] / 1000) << "%\n";
     logFile << "-------------------------------\n";
 
     logFile.close();
@@ -862,7 +851,7 @@ void timeDelay(float seconds)
 
 }
 
-void drawDynamicMinimap(sf::RenderWindow& window, const sf::Sprite& mapSprite, const sf::View& view, const Car& car) {
+void drawDynamicMinimap(sf::RenderTarget& target, MinimapLayer& minimap, const sf::View& view, FleetSprites& sprites, const Fleet& fleet, size_t player, float alpha) {
     // Define the minimap size and position
     float minimapWidth = 300.f;
     float minimapHeight = 200.f;
@@ -873,27 +862,13 @@ void drawDynamicMinimap(sf::RenderWindow& window, const sf::Sprite& mapSprite, c
     sf::RectangleShape minimapBackground(sf::Vector2f(minimapWidth - 5.f, minimapHeight + 6.f));
     minimapBackground.setPosition(minimapPosition);
     minimapBackground.setFillColor(sf::Color(50, 50, 50, 200));
-    window.draw(minimapBackground);
-
-    // Scale the map sprite to fit within the minimap
-    sf::Sprite scaledMapSprite = mapSprite;
-    float scaleX = minimapWidth / mapSprite.getGlobalBounds().width;
-    float scaleY = minimapHeight / mapSprite.getGlobalBounds().height;
-    scaledMapSprite.setScale(0.099f, 0.099f);
-    scaledMapSprite.setPosition(minimapPosition);
-    window.draw(scaledMapSprite);
-
-    // Calculate the car's position on the minimap
-    sf::Vector2f carPositionOnMap = car.shape.getPosition();
-    sf::Vector2f mapSize(mapSprite.getTexture()->getSize());
-    sf::Vector2f scaledCarPosition(
-        (carPositionOnMap.x / mapSize.x) * minimapWidth + minimapPosition.x,
-        (carPositionOnMap.y / mapSize.y) * minimapHeight + minimapPosition.y
-    );
-
-    // Draw the car as a dot on the minimap
-    sf::CircleShape carDot(3.f);  // Radius of the dot
-    carDot.setFillColor(sf::Color::Red);
-    carDot.setPosition(scaledCarPosition - sf::Vector2f(carDot.getRadius(), carDot.getRadius() - 20.f));
-    window.draw(carDot);
-}
\ No newline at end of file
+    target.draw(minimapBackground);
+
+    // The map was already downscaled to minimap size at startup
+    drawMinimapLayer(target, minimap, minimapPosition);
+
+    // Draw every car as a dot on the minimap in one batch
+    sf::Vector2f mapSize(minimap.sourceSize);
+    sf::FloatRect markerArea(minimapPosition.x, minimapPosition.y + 20.f, minimapWidth, minimapHeight);
+    drawFleetMarkers(target, sprites, fleet, player, alpha, mapSize, markerArea);
+}
@@ -0,0 +1,122 @@
+#include "minimap.h"
+#include <algorithm>
+#include <iostream>
+
+static void drawScaled(sf::RenderTexture& target, const sf::Texture& texture) {
+    sf::Sprite sprite(texture);
+    sprite.setScale(static_cast<float>(target.getSize().x) / texture.getSize().x,
+        static_cast<float>(target.getSize().y) / texture.getSize().y);
+
+    target.clear(sf::Color::Transparent);
+    target.draw(sprite);
+    target.display();
+}
+
+// Halve `source` into the two ping-pong steps until one more halving would pass targetSize,
+// and return the last texture written (or the source itself if it was already small enough)
+static const sf::Texture* halveTowards(sf::RenderTexture (&steps)[2], const sf::Texture& source, const sf::Vector2u& targetSize) {
+    const sf::Texture* current = &source;
+    sf::Vector2u size = source.getSize();
+    int next = 0;
+    while (size.x / 2 >= targetSize.x && size.y / 2 >= targetSize.y) {
+        sf::Vector2u half(size.x / 2, size.y / 2);
+        if (!steps[next].create(half.x, half.y))
+            break;
+        steps[next].setSmooth(true);
+        drawScaled(steps[next], *current);
+
+        current = &steps[next].getTexture();
+        size = half;
+        next = 1 - next;
+    }
+    return current;
+}
+
+static sf::Vector2u scaledSize(const sf::Vector2u& size, float scale) {
+    return sf::Vector2u(std::max(1u, static_cast<unsigned int>(size.x * scale)),
+        std::max(1u, static_cast<unsigned int>(size.y * scale)));
+}
+
+bool prerenderMinimap(MinimapLayer& layer, sf::Texture& source, float scale) {
+    layer.ready = false;
+    layer.sourceSize = source.getSize();
+    if (layer.sourceSize.x == 0 || layer.sourceSize.y == 0)
+        return false;
+
+    sf::Vector2u targetSize = scaledSize(layer.sourceSize, scale);
+
+    bool wasSmooth = source.isSmooth();
+    source.setSmooth(true);
+
+    sf::RenderTexture steps[2];
+    const sf::Texture* current = halveTowards(steps, source, targetSize);
+
+    bool created = layer.texture.create(targetSize.x, targetSize.y);
+    if (created) {
+        layer.texture.setSmooth(true);
+        drawScaled(layer.texture, *current);
+        layer.sprite.setTexture(layer.texture.getTexture(), true);
+        layer.ready = true;
+    }
+    else {
+        std::cerr << "Error creating mini map texture!" << std::endl;
+    }
+
+    source.setSmooth(wasSmooth);
+    return created;
+}
+
+bool prerenderTiledMinimap(MinimapLayer& layer, const WorldTiles& world, const std::string& tileLayer, float scale,
+    const sf::Image* overview) {
+    layer.ready = false;
+    layer.sourceSize = sf::Vector2u(world.width, world.height);
+    sf::Vector2u targetSize = scaledSize(layer.sourceSize, scale);
+    if (!layer.texture.create(targetSize.x, targetSize.y)) {
+        std::cerr << "Error creating mini map texture!" << std::endl;
+        return false;
+    }
+    layer.texture.setSmooth(true);
+    layer.texture.clear(sf::Color::Transparent);
+
+    std::string overviewFile = world.prefix + "_overview.png";
+    sf::Texture cachedTexture;
+    bool cached = overview && overview->getSize() == targetSize && cachedTexture.loadFromImage(*overview);
+    if (cached) {
+        layer.texture.draw(sf::Sprite(cachedTexture));
+    }
+    else {
+        // Each tile is downscaled on its own and placed at its scaled position
+        sf::RenderTexture steps[2];
+        for (unsigned int y = 0; y < tilesDown(world); ++y) {
+            for (unsigned int x = 0; x < tilesAcross(world); ++x) {
+                sf::Texture tile;
+                if (!tile.loadFromFile(tileFile(world, tileLayer, x, y)))
+                    continue;
+                tile.setSmooth(true);
+
+                sf::IntRect rect = tileRect(world, x, y);
+                const sf::Texture* current = halveTowards(steps, tile, scaledSize(tile.getSize(), scale));
+                sf::Sprite sprite(*current);
+                sprite.setScale(rect.width * scale / current->getSize().x, rect.height * scale / current->getSize().y);
+                sprite.setPosition(rect.left * scale, rect.top * scale);
+                layer.texture.draw(sprite);
+            }
+        }
+    }
+    layer.texture.display();
+
+    if (!cached && !layer.texture.getTexture().copyToImage().saveToFile(overviewFile))
+        std::cerr << "Could not cache map overview to " << overviewFile << std::endl;
+
+    layer.sprite.setTexture(layer.texture.getTexture(), true);
+    layer.ready = true;
+    return true;
+}
+
+void drawMinimapLayer(sf::RenderTarget& target, MinimapLayer& layer, const sf::Vector2f& position) {
+    if (!layer.ready)
+        return;
+
+    layer.sprite.setPosition(position);
+    target.draw(layer.sprite);
+}
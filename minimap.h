@@ -0,0 +1,27 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include "world_tiles.h"
+
+// A map image pre-rendered once at the size it is shown on screen. Drawing it is a single
+// small textured quad, so the per-frame cost no longer depends on the size of the map.
+struct MinimapLayer {
+    sf::RenderTexture texture;
+    sf::Sprite sprite;
+    sf::Vector2u sourceSize;  // Size of the image it was rendered from
+    bool ready = false;
+};
+
+// Downscale `source` by `scale` into the layer. The image is halved with bilinear filtering
+// until one step from the target size, the same box-filtered chain a mipmap would give,
+// so roads stay readable instead of aliasing away. The source's smoothing flag is restored.
+bool prerenderMinimap(MinimapLayer& layer, sf::Texture& source, float scale);
+
+// Same for a tiled map, downscaling one tile at a time. The result is cached as
+// `<prefix>_overview.png`; pass that image back in as `overview` (already decoded by the
+// asset loader) and the tiles aren't touched at all. Only the image's size is checked, so
+// buildWorldTiles deletes the cache whenever the tiles are rebuilt.
+bool prerenderTiledMinimap(MinimapLayer& layer, const WorldTiles& world, const std::string& tileLayer, float scale,
+    const sf::Image* overview);
+
+// Place the layer's top-left corner at `position` and draw it
+void drawMinimapLayer(sf::RenderTarget& target, MinimapLayer& layer, const sf::Vector2f& position);
@@ -0,0 +1,163 @@
+#include "music.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+static std::unique_ptr<sf::Music> openTrack(const std::string& file) {
+    std::unique_ptr<sf::Music> music(new sf::Music());
+    if (!music->openFromFile(file)) {
+        std::cerr << "Error loading song: " << file << std::endl;
+        return nullptr;
+    }
+    music->setLoop(true);
+    return music;
+}
+
+static bool isReady(const std::future<std::unique_ptr<sf::Music>>& future) {
+    return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+static void prepareTrack(MusicPlayer& player, PreparedTrack& track, int index) {
+    if (track.index == index && track.music.valid())
+        return;
+
+    if (track.music.valid())
+        player.discarded.push_back(std::move(track.music));
+    track.index = index;
+    track.music = std::async(std::launch::async, openTrack, player.songs[index]);
+}
+
+static void prepareNeighbours(MusicPlayer& player) {
+    int count = static_cast<int>(player.songs.size());
+    prepareTrack(player, player.next, (player.current + 1) % count);
+    prepareTrack(player, player.previous, (player.current - 1 + count) % count);
+}
+
+bool startMusicPlayer(MusicPlayer& player, const std::vector<std::string>& songList, float volume) {
+    // Check the playlist once here instead of failing on the render thread later
+    player.songs.clear();
+    for (const std::string& song : songList) {
+        if (std::ifstream(song))
+            player.songs.push_back(song);
+        else
+            std::cerr << "Song not found, skipping: " << song << std::endl;
+    }
+    if (player.songs.empty())
+        return false;
+
+    player.current = 0;
+    player.volume = volume;
+    player.playing = openTrack(player.songs[0]);
+    if (!player.playing)
+        return false;
+
+    player.playing->setVolume(volume);
+    player.playing->play();
+    prepareNeighbours(player);
+    return true;
+}
+
+static void switchTrack(MusicPlayer& player, int direction) {
+    PreparedTrack& track = direction > 0 ? player.next : player.previous;
+    if (!isReady(track.music)) {
+        // Still opening; finish the switch from updateMusicPlayer instead of waiting here
+        player.pendingSwitch = direction;
+        return;
+    }
+    player.pendingSwitch = 0;
+
+    std::unique_ptr<sf::Music> music = track.music.get();
+    player.current = track.index;
+    if (music) {
+        if (player.crossfade > 0.f && player.playing) {
+            player.fading = std::move(player.playing);
+            player.fadeElapsed = 0.f;
+        }
+        else if (player.playing) {
+            player.playing->stop();
+        }
+
+        player.playing = std::move(music);
+        player.playing->setVolume(player.fading ? 0.f : player.volume);
+        if (player.pendingOffset >= 0.f)
+            player.playing->setPlayingOffset(sf::seconds(player.pendingOffset));
+        player.playing->play();
+    }
+    player.pendingOffset = -1.f;
+    prepareNeighbours(player);
+}
+
+void updateMusicPlayer(MusicPlayer& player, float frameTime) {
+    player.discarded.erase(std::remove_if(player.discarded.begin(), player.discarded.end(), isReady),
+        player.discarded.end());
+
+    if (player.pendingSwitch != 0)
+        switchTrack(player, player.pendingSwitch);
+
+    if (player.fading) {
+        player.fadeElapsed += frameTime;
+        float t = std::min(player.fadeElapsed / player.crossfade, 1.f);
+        if (player.playing)
+            player.playing->setVolume(player.volume * t);
+        player.fading->setVolume(player.volume * (1.f - t));
+        if (t >= 1.f)
+            player.fading.reset();
+    }
+}
+
+void nextSong(MusicPlayer& player) {
+    if (!player.songs.empty())
+        switchTrack(player, 1);
+}
+
+void previousSong(MusicPlayer& player) {
+    if (!player.songs.empty())
+        switchTrack(player, -1);
+}
+
+void toggleMusicPause(MusicPlayer& player) {
+    if (!player.playing)
+        return;
+
+    if (player.playing->getStatus() == sf::Music::Playing) {
+        player.playing->pause();
+        if (player.fading) {
+            player.fading.reset();
+            player.playing->setVolume(player.volume);
+        }
+    }
+    else {
+        player.playing->play();
+    }
+}
+
+void setMusicVolume(MusicPlayer& player, float volume) {
+    player.volume = volume;
+    if (player.playing && !player.fading)
+        player.playing->setVolume(volume);
+}
+
+const std::string& currentSongName(const MusicPlayer& player) {
+    static const std::string none;
+    return player.songs.empty() ? none : player.songs[player.current];
+}
+
+float musicOffset(const MusicPlayer& player) {
+    return player.playing ? player.playing->getPlayingOffset().asSeconds() : 0.f;
+}
+
+void seekMusic(MusicPlayer& player, int index, float offset) {
+    if (index < 0 || index >= static_cast<int>(player.songs.size()))
+        return;
+
+    if (index == player.current && player.playing && player.pendingSwitch == 0) {
+        player.playing->setPlayingOffset(sf::seconds(offset));
+        return;
+    }
+
+    // Open the wanted song in the "next" slot and switch to it as soon as it is ready
+    prepareTrack(player, player.next, index);
+    player.pendingOffset = offset;
+    switchTrack(player, 1);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <SFML/Audio.hpp>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+const float MUSIC_CROSSFADE = 0.5f;  // Seconds both tracks overlap when switching; 0 cuts instantly
+
+// A track being opened on a background thread
+struct PreparedTrack {
+    int index = -1;
+    std::future<std::unique_ptr<sf::Music>> music;
+};
+
+// Background music with the previous and next songs of the playlist opened ahead of time on a
+// worker thread. Switching hands over to an already opened track (with an optional crossfade),
+// so the render thread never waits on the decoder opening or seeking a file.
+struct MusicPlayer {
+    std::vector<std::string> songs;     // Only files that existed at startup
+    int current = 0;
+    float volume = 50.f;
+    float crossfade = MUSIC_CROSSFADE;
+
+    std::unique_ptr<sf::Music> playing;
+    std::unique_ptr<sf::Music> fading;  // The previous track while it fades out
+    float fadeElapsed = 0.f;
+
+    PreparedTrack next;
+    PreparedTrack previous;
+    int pendingSwitch = 0;              // +1/-1 when a switch waits for its track to finish opening
+    float pendingOffset = -1.f;         // Seconds to seek to once the switched-to track starts, if >= 0
+
+    // Tracks nobody wants any more, kept until their open finishes so dropping them never blocks
+    std::vector<std::future<std::unique_ptr<sf::Music>>> discarded;
+};
+
+// Drop missing files from the playlist, open and play the first song, then prepare its neighbours.
+// Returns false if no song could be played.
+bool startMusicPlayer(MusicPlayer& player, const std::vector<std::string>& songList, float volume);
+
+// Advance the crossfade and finish a switch whose track has become ready; call once per frame
+void updateMusicPlayer(MusicPlayer& player, float frameTime);
+
+void nextSong(MusicPlayer& player);
+void previousSong(MusicPlayer& player);
+void toggleMusicPause(MusicPlayer& player);
+void setMusicVolume(MusicPlayer& player, float volume);
+
+const std::string& currentSongName(const MusicPlayer& player);
+
+// Seconds into the current song
+float musicOffset(const MusicPlayer& player);
+
+// Continue from `offset` seconds into song `index`. Another song is opened in the background
+// like any other switch, so this never blocks either.
+void seekMusic(MusicPlayer& player, int index, float offset);
@@ -0,0 +1,123 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+static std::chrono::steady_clock::time_point profileEpoch() {
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    return epoch;
+}
+
+void startProfiler(FrameProfiler& profiler, std::uint32_t thread, const std::string& threadName) {
+    profileEpoch();
+    profiler.thread = thread;
+    profiler.threadName = threadName;
+    for (ProfileZoneHistory& history : profiler.zones)
+        history = ProfileZoneHistory();
+    profiler.frames = 0;
+    profiler.capturing = false;
+    profiler.trace.clear();
+    profiler.droppedEvents = 0;
+}
+
+std::uint64_t profileNow(const FrameProfiler&) {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - profileEpoch()).count());
+}
+
+void addProfileSample(FrameProfiler& profiler, ProfileZone zone, std::uint64_t start, std::uint64_t end) {
+    std::uint64_t duration = end > start ? end - start : 0;
+    profiler.zones[zone].frameNanoseconds += duration;
+    if (!profiler.capturing)
+        return;
+
+    if (profiler.trace.size() >= PROFILE_TRACE_CAPACITY) {
+        ++profiler.droppedEvents;
+        return;
+    }
+    ProfileEvent event;
+    event.start = start;
+    event.duration = static_cast<std::uint32_t>(std::min<std::uint64_t>(duration, 0xFFFFFFFFu));
+    event.zone = static_cast<std::uint8_t>(zone);
+    profiler.trace.push_back(event);
+}
+
+void endProfileFrame(FrameProfiler& profiler) {
+    size_t slot = static_cast<size_t>(profiler.frames % PROFILE_WINDOW_FRAMES);
+    for (ProfileZoneHistory& history : profiler.zones) {
+        history.milliseconds[slot] = history.frameNanoseconds / 1e6f;
+        history.frameNanoseconds = 0;
+    }
+    ++profiler.frames;
+}
+
+float profilePercentile(const FrameProfiler& profiler, ProfileZone zone, float fraction) {
+    size_t count = static_cast<size_t>(std::min<std::uint64_t>(profiler.frames, PROFILE_WINDOW_FRAMES));
+    if (count == 0)
+        return 0.f;
+
+    float sorted[PROFILE_WINDOW_FRAMES];
+    std::copy(profiler.zones[zone].milliseconds, profiler.zones[zone].milliseconds + count, sorted);
+    size_t rank = std::min(static_cast<size_t>(fraction * count), count - 1);
+    std::nth_element(sorted, sorted + rank, sorted + count);
+    return sorted[rank];
+}
+
+const char* profileZoneName(ProfileZone zone) {
+    static const char* names[PROFILE_ZONE_COUNT] = {
+        "Frame", "Input", "AI", "Physics", "Record", "World", "Vehicles", "Minimap", "UI", "Audio", "Stall", "Present"
+    };
+    return zone < PROFILE_ZONE_COUNT ? names[zone] : "?";
+}
+
+void startProfileCapture(FrameProfiler& profiler) {
+    profiler.trace.clear();
+    profiler.trace.reserve(PROFILE_TRACE_CAPACITY / 16);
+    profiler.droppedEvents = 0;
+    profiler.capturing = true;
+}
+
+bool saveChromeTrace(const std::vector<FrameProfiler*>& profilers, const std::string& path) {
+    for (FrameProfiler* profiler : profilers)
+        profiler->capturing = false;
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        std::cerr << "Error writing trace: " << path << std::endl;
+        return false;
+    }
+
+    // A name for each thread, then complete ("X") events; timestamps are in microseconds
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    char line[160];
+    size_t events = 0;
+    for (FrameProfiler* profiler : profilers) {
+        file << (events++ == 0 ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+            << profiler->thread << ",\"args\":{\"name\":\"" << profiler->threadName << "\"}}";
+    }
+    for (FrameProfiler* profiler : profilers) {
+        for (const ProfileEvent& event : profiler->trace) {
+            std::snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                profileZoneName(static_cast<ProfileZone>(event.zone)), static_cast<unsigned int>(profiler->thread),
+                event.start / 1e3, event.duration / 1e3);
+            file << line;
+            ++events;
+        }
+        if (profiler->droppedEvents > 0)
+            std::cerr << profiler->threadName << " trace was full; " << profiler->droppedEvents << " events were dropped" << std::endl;
+        profiler->trace.clear();
+        profiler->trace.shrink_to_fit();
+    }
+    file << "\n]}\n";
+
+    std::cout << "Wrote " << events - profilers.size() << " trace events to " << path << std::endl;
+    return static_cast<bool>(file);
+}
+
+ProfileScope::ProfileScope(FrameProfiler& profiler, ProfileZone zone)
+    : profiler(profiler), zone(zone), start(profileNow(profiler)) {
+}
+
+ProfileScope::~ProfileScope() {
+    addProfileSample(profiler, zone, start, profileNow(profiler));
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Parts of a frame that are timed separately
+enum ProfileZone {
+    PROFILE_FRAME,     // The whole frame, from polling events to display
+    PROFILE_INPUT,     // Window events and key handling
+    PROFILE_AI,        // Steering the AI cars, every tick of a simulation step
+    PROFILE_PHYSICS,   // Fleet physics and collisions, every tick of a simulation step
+    PROFILE_RECORD,    // Telemetry recording
+    PROFILE_WORLD,     // Map tile streaming and drawing
+    PROFILE_VEHICLES,  // Car sprites
+    PROFILE_MINIMAP,
+    PROFILE_UI,        // Stats panel, menus and this overlay
+    PROFILE_AUDIO,
+    PROFILE_STALL,     // Deliberate waits such as timeDelay
+    PROFILE_PRESENT,   // window.display(), including the frame rate limit's sleep
+    PROFILE_ZONE_COUNT
+};
+
+const size_t PROFILE_WINDOW_FRAMES = 256;        // Frames the percentiles are taken over
+const size_t PROFILE_TRACE_CAPACITY = 1 << 20;   // Most events one trace capture keeps
+
+// One timed scope, in nanoseconds since the first profiler started
+struct ProfileEvent {
+    std::uint64_t start;
+    std::uint32_t duration;
+    std::uint8_t zone;
+};
+
+// Frame times of one zone over the last PROFILE_WINDOW_FRAMES frames. A zone entered several
+// times in a frame (physics runs once per tick) counts as the sum of its scopes.
+struct ProfileZoneHistory {
+    float milliseconds[PROFILE_WINDOW_FRAMES] = {};
+    std::uint64_t frameNanoseconds = 0;  // Scopes of the frame in progress
+};
+
+// Scoped timers for one thread's loop. Recording a scope is two clock reads and an add, so the
+// profiler is always on, in every build; the overlay only sorts the window when it is drawn.
+// While a trace is captured every scope is also kept as an event for saveChromeTrace.
+// Only the thread that owns the profiler may record into it. Every profiler shares one clock,
+// so traces of several threads line up.
+struct FrameProfiler {
+    std::uint32_t thread = 1;          // Thread id in traces
+    std::string threadName = "Main";
+    ProfileZoneHistory zones[PROFILE_ZONE_COUNT];
+    std::uint64_t frames = 0;          // Frames finished so far
+    bool capturing = false;
+    std::vector<ProfileEvent> trace;
+    std::uint64_t droppedEvents = 0;   // Events past PROFILE_TRACE_CAPACITY in this capture
+};
+
+void startProfiler(FrameProfiler& profiler, std::uint32_t thread = 1, const std::string& threadName = "Main");
+
+// Nanoseconds since the first profiler started
+std::uint64_t profileNow(const FrameProfiler& profiler);
+
+// Count [start, end) toward `zone` for the current frame
+void addProfileSample(FrameProfiler& profiler, ProfileZone zone, std::uint64_t start, std::uint64_t end);
+
+// Close the frame (or simulation step): each zone's total becomes its newest sample
+void endProfileFrame(FrameProfiler& profiler);
+
+// Frame time of `zone` in milliseconds that `fraction` of the recorded frames stayed under
+float profilePercentile(const FrameProfiler& profiler, ProfileZone zone, float fraction);
+
+const char* profileZoneName(ProfileZone zone);
+
+// Keep every scope from now on, for saveChromeTrace
+void startProfileCapture(FrameProfiler& profiler);
+
+// Write the captured scopes of every profiler as one Chrome trace JSON (chrome://tracing,
+// Perfetto), one track per thread, and stop capturing
+bool saveChromeTrace(const std::vector<FrameProfiler*>& profilers, const std::string& path);
+
+// Times the rest of the enclosing block
+struct ProfileScope {
+    FrameProfiler& profiler;
+    ProfileZone zone;
+    std::uint64_t start;
+
+    ProfileScope(FrameProfiler& profiler, ProfileZone zone);
+    ~ProfileScope();
+};
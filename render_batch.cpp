@@ -0,0 +1,59 @@
+#include "render_batch.h"
+#include <cmath>
+
+void clearBatch(QuadBatch& batch) {
+    batch.vertices.clear();
+}
+
+void addRect(QuadBatch& batch, const sf::FloatRect& rect, const sf::Color& color) {
+    float right = rect.left + rect.width;
+    float bottom = rect.top + rect.height;
+    batch.vertices.append(sf::Vertex(sf::Vector2f(rect.left, rect.top), color));
+    batch.vertices.append(sf::Vertex(sf::Vector2f(right, rect.top), color));
+    batch.vertices.append(sf::Vertex(sf::Vector2f(right, bottom), color));
+    batch.vertices.append(sf::Vertex(sf::Vector2f(rect.left, bottom), color));
+}
+
+void addOutline(QuadBatch& batch, const sf::FloatRect& rect, float thickness, const sf::Color& color) {
+    if (thickness <= 0.f)
+        return;
+
+    float outerWidth = rect.width + 2 * thickness;
+    addRect(batch, sf::FloatRect(rect.left - thickness, rect.top - thickness, outerWidth, thickness), color);
+    addRect(batch, sf::FloatRect(rect.left - thickness, rect.top + rect.height, outerWidth, thickness), color);
+    addRect(batch, sf::FloatRect(rect.left - thickness, rect.top, thickness, rect.height), color);
+    addRect(batch, sf::FloatRect(rect.left + rect.width, rect.top, thickness, rect.height), color);
+}
+
+void addRectangleShape(QuadBatch& batch, const sf::RectangleShape& shape) {
+    sf::FloatRect rect(shape.getPosition().x, shape.getPosition().y, shape.getSize().x, shape.getSize().y);
+    addRect(batch, rect, shape.getFillColor());
+    addOutline(batch, rect, shape.getOutlineThickness(), shape.getOutlineColor());
+}
+
+void addRotatedQuad(QuadBatch& batch, const sf::Vector2f& center, const sf::Vector2f& halfSize, float angle,
+    const sf::FloatRect& textureRect, const sf::Color& color) {
+    float radians = angle * 3.14159f / 180.f;
+    float cosA = std::cos(radians);
+    float sinA = std::sin(radians);
+
+    // Corners in the quad's own frame, rotated about its center
+    const float cornerX[4] = { -halfSize.x, halfSize.x, halfSize.x, -halfSize.x };
+    const float cornerY[4] = { -halfSize.y, -halfSize.y, halfSize.y, halfSize.y };
+    const float u[4] = { textureRect.left, textureRect.left + textureRect.width, textureRect.left + textureRect.width, textureRect.left };
+    const float v[4] = { textureRect.top, textureRect.top, textureRect.top + textureRect.height, textureRect.top + textureRect.height };
+
+    for (int i = 0; i < 4; ++i) {
+        sf::Vector2f position(center.x + cornerX[i] * cosA - cornerY[i] * sinA,
+            center.y + cornerX[i] * sinA + cornerY[i] * cosA);
+        batch.vertices.append(sf::Vertex(position, color, sf::Vector2f(u[i], v[i])));
+    }
+}
+
+void drawBatch(sf::RenderTarget& target, const QuadBatch& batch, sf::RenderStates states) {
+    if (batch.vertices.getVertexCount() == 0)
+        return;
+
+    states.texture = batch.texture;
+    target.draw(batch.vertices, states);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+
+// Quads that share one texture (or none) collected over a frame and submitted in a single
+// draw call. Clearing keeps the vertex storage, so a batch that is refilled every frame
+// stops allocating once it has seen its largest frame.
+struct QuadBatch {
+    sf::VertexArray vertices = sf::VertexArray(sf::Quads);
+    const sf::Texture* texture = nullptr;
+};
+
+void clearBatch(QuadBatch& batch);
+
+// Untextured axis-aligned rectangle
+void addRect(QuadBatch& batch, const sf::FloatRect& rect, const sf::Color& color);
+
+// Border drawn outside the rectangle, like sf::Shape's positive outline thickness
+void addOutline(QuadBatch& batch, const sf::FloatRect& rect, float thickness, const sf::Color& color);
+
+// The fill and outline of a rectangle shape, in the shape's untransformed position
+void addRectangleShape(QuadBatch& batch, const sf::RectangleShape& shape);
+
+// Quad of halfSize around center, rotated by angle degrees, showing textureRect of the batch texture
+void addRotatedQuad(QuadBatch& batch, const sf::Vector2f& center, const sf::Vector2f& halfSize, float angle,
+    const sf::FloatRect& textureRect, const sf::Color& color = sf::Color::White);
+
+void drawBatch(sf::RenderTarget& target, const QuadBatch& batch, sf::RenderStates states = sf::RenderStates::Default);
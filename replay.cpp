@@ -0,0 +1,203 @@
+#include "replay.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const char REPLAY_MAGIC[4] = { 'R', 'R', 'P', 'L' };
+static const std::uint32_t REPLAY_VERSION = 5;  // Only this layout is read
+
+static void hashBytes(std::uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+template <typename T>
+static void writeValue(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool readValue(std::ifstream& file, T& value) {
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+static void writeProfile(std::ofstream& file, const VehicleProfile& profile) {
+    writeValue(file, static_cast<std::uint32_t>(profile.name.size()));
+    file.write(profile.name.data(), profile.name.size());
+    writeValue(file, profile.model);
+    writeValue(file, profile.tuning.maxSpeed);
+    writeValue(file, profile.tuning.acceleration);
+    writeValue(file, profile.tuning.friction);
+    writeValue(file, profile.tuning.drag);
+    writeValue(file, profile.tuning.turnRate);
+    writeValue(file, profile.tuning.minTurnSpeed);
+    writeValue(file, profile.tuning.understeer);
+}
+
+static bool readProfile(std::ifstream& file, VehicleProfile& profile) {
+    std::uint32_t nameLength = 0;
+    if (!readValue(file, nameLength) || nameLength >= 4096)
+        return false;
+    profile.name.resize(nameLength);
+    return file.read(&profile.name[0], nameLength) && readValue(file, profile.model) && profile.model < VEHICLE_MODEL_COUNT
+        && readValue(file, profile.tuning.maxSpeed) && readValue(file, profile.tuning.acceleration)
+        && readValue(file, profile.tuning.friction) && readValue(file, profile.tuning.drag)
+        && readValue(file, profile.tuning.turnRate) && readValue(file, profile.tuning.minTurnSpeed)
+        && readValue(file, profile.tuning.understeer);
+}
+
+std::uint64_t vehicleChecksum(const Fleet& fleet, size_t vehicle) {
+    std::uint64_t hash = 14695981039346656037ull;
+    hashBytes(hash, &fleet.positionX[vehicle], sizeof(float));
+    hashBytes(hash, &fleet.positionY[vehicle], sizeof(float));
+    hashBytes(hash, &fleet.speed[vehicle], sizeof(float));
+    hashBytes(hash, &fleet.angle[vehicle], sizeof(float));
+    hashBytes(hash, &fleet.fuel[vehicle], sizeof(float));
+    hashBytes(hash, &fleet.refuelCooldown[vehicle], sizeof(float));
+    hashBytes(hash, &fleet.mileage[vehicle], sizeof(double));
+    return hash;
+}
+
+void beginReplay(Replay& replay, const Fleet& fleet, size_t vehicle, float tickRate, const RoadMap& roads) {
+    replay.startPosition = vehiclePosition(fleet, vehicle);
+    replay.startAngle = fleet.angle[vehicle];
+    replay.startFuel = fleet.fuel[vehicle];
+    replay.tickRate = tickRate;
+    replay.roadGridHash = surfaceGridHash(roads.surface);
+    replay.profiles = fleet.profiles;
+    replay.events.clear();
+    replay.startTick = 0;
+    replay.startSnapshot.clear();
+    replay.ticks = 0;
+    replay.finalChecksum = 0;
+}
+
+void continueReplayFrom(Replay& replay, const std::vector<char>& snapshot, std::uint64_t tick) {
+    replay.events.clear();
+    replay.startTick = tick;
+    replay.startSnapshot = snapshot;
+    replay.ticks = tick;
+    replay.finalChecksum = 0;
+}
+
+void recordReplayTick(Replay& replay, std::uint64_t tick, std::uint8_t controls) {
+    if (!replay.events.empty() && replay.events.back().tick == tick) {
+        replay.events.back().controls = controls;
+        return;
+    }
+
+    std::uint8_t held = replay.events.empty() ? 0 : replay.events.back().controls;
+    if (controls == held)
+        return;
+
+    ReplayEvent event;
+    event.tick = tick;
+    event.controls = controls;
+    replay.events.push_back(event);
+}
+
+void recordReplayReset(Replay& replay, std::uint64_t tick) {
+    // A reset releases every key, just like resetVehicle clears the controls
+    ReplayEvent event;
+    event.tick = tick;
+    event.flags = REPLAY_RESET;
+    if (!replay.events.empty() && replay.events.back().tick == tick)
+        replay.events.back() = event;
+    else
+        replay.events.push_back(event);
+}
+
+void endReplay(Replay& replay, const Fleet& fleet, size_t vehicle, std::uint64_t ticks) {
+    replay.ticks = ticks;
+    replay.finalChecksum = vehicleChecksum(fleet, vehicle);
+}
+
+bool saveReplay(const Replay& replay, const std::string& path) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Error writing replay: " << path << std::endl;
+        return false;
+    }
+
+    file.write(REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+    writeValue(file, REPLAY_VERSION);
+    writeValue(file, replay.startPosition.x);
+    writeValue(file, replay.startPosition.y);
+    writeValue(file, replay.startAngle);
+    writeValue(file, replay.startFuel);
+    writeValue(file, replay.tickRate);
+    writeValue(file, static_cast<std::uint32_t>(replay.roadMaskFile.size()));
+    file.write(replay.roadMaskFile.data(), replay.roadMaskFile.size());
+    writeValue(file, replay.roadGridHash);
+    writeValue(file, replay.startTick);
+    writeValue(file, static_cast<std::uint64_t>(replay.startSnapshot.size()));
+    file.write(replay.startSnapshot.data(), replay.startSnapshot.size());
+    writeValue(file, replay.aiDrivers);
+    writeValue(file, replay.aiSeed);
+    writeValue(file, static_cast<std::uint32_t>(replay.profiles.size()));
+    for (const VehicleProfile& profile : replay.profiles)
+        writeProfile(file, profile);
+    writeValue(file, replay.ticks);
+    writeValue(file, replay.finalChecksum);
+    writeValue(file, static_cast<std::uint64_t>(replay.events.size()));
+    for (const ReplayEvent& event : replay.events) {
+        writeValue(file, event.tick);
+        writeValue(file, event.controls);
+        writeValue(file, event.flags);
+    }
+    return static_cast<bool>(file);
+}
+
+bool loadReplay(const std::string& path, Replay& replay) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(REPLAY_MAGIC)];
+    std::uint32_t version = 0;
+    if (!file.read(magic, sizeof(magic)) || !readValue(file, version)
+        || std::memcmp(magic, REPLAY_MAGIC, sizeof(magic)) != 0 || version != REPLAY_VERSION) {
+        std::cerr << "Error reading replay: " << path << std::endl;
+        return false;
+    }
+
+    std::uint32_t maskLength = 0;
+    std::uint64_t eventCount = 0;
+    bool ok = readValue(file, replay.startPosition.x) && readValue(file, replay.startPosition.y)
+        && readValue(file, replay.startAngle) && readValue(file, replay.startFuel)
+        && readValue(file, replay.tickRate) && readValue(file, maskLength) && maskLength < 4096;
+    if (ok) {
+        replay.roadMaskFile.resize(maskLength);
+        ok = file.read(&replay.roadMaskFile[0], maskLength) && readValue(file, replay.roadGridHash);
+    }
+
+    std::uint64_t snapshotSize = 0;
+    ok = ok && readValue(file, replay.startTick) && readValue(file, snapshotSize) && snapshotSize < (1ull << 32);
+    if (ok) {
+        replay.startSnapshot.resize(static_cast<size_t>(snapshotSize));
+        ok = static_cast<bool>(file.read(replay.startSnapshot.data(), replay.startSnapshot.size()));
+    }
+    ok = ok && readValue(file, replay.aiDrivers) && readValue(file, replay.aiSeed);
+
+    std::uint32_t profileCount = 0;
+    ok = ok && readValue(file, profileCount) && profileCount > 0 && profileCount <= MAX_VEHICLE_PROFILES;
+    if (ok)
+        replay.profiles.resize(profileCount);
+    for (std::uint32_t i = 0; ok && i < profileCount; ++i)
+        ok = readProfile(file, replay.profiles[i]);
+    ok = ok && readValue(file, replay.ticks) && readValue(file, replay.finalChecksum) && readValue(file, eventCount);
+
+    replay.events.clear();
+    for (std::uint64_t i = 0; ok && i < eventCount; ++i) {
+        ReplayEvent event;
+        ok = readValue(file, event.tick) && readValue(file, event.controls) && readValue(file, event.flags);
+        if (ok)
+            replay.events.push_back(event);
+    }
+
+    if (!ok) {
+        std::cerr << "Replay file is truncated: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "fleet.h"
+#include "simulation.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Bits of ReplayEvent::flags
+enum ReplayFlags : std::uint8_t {
+    REPLAY_RESET = 1 << 0  // Put the car back at the start before this tick
+};
+
+// Something that changed before tick `tick` was simulated (ticks count from 1)
+struct ReplayEvent {
+    std::uint64_t tick = 0;
+    std::uint8_t controls = 0;  // ControlBits held from this tick on
+    std::uint8_t flags = 0;
+};
+
+// A recorded driving session. The physics only ever advance in fixed ticks, so the start state,
+// the tick rate and the ticks at which the W/S/A/D/F keys changed reproduce the session exactly.
+// Only changes are stored, so an hour of driving is a few kilobytes.
+struct Replay {
+    sf::Vector2f startPosition;
+    float startAngle = 0.f;
+    float startFuel = MAX_FUEL;
+    float tickRate = SIMULATION_TICK_RATE;
+    std::string roadMaskFile = "map_mask.jpeg";
+    std::uint64_t roadGridHash = 0;  // surfaceGridHash of the road map the session was driven on
+    std::vector<ReplayEvent> events;
+    std::uint64_t startTick = 0;     // Tick the recording starts after
+    std::vector<char> startSnapshot; // Fleet to start from (see snapshot.h); empty to start at startPosition
+    std::uint32_t aiDrivers = 0;     // Computer-driven cars after the recorded vehicle (see ai_driver.h)
+    std::uint32_t aiSeed = 0;        // ...and the seed they were spawned and drive with
+    std::vector<VehicleProfile> profiles{ VehicleProfile() };  // Fleet::profiles the session was driven with
+    std::uint64_t ticks = 0;         // Ticks simulated in the session
+    std::uint64_t finalChecksum = 0; // vehicleChecksum of the recorded vehicle after the last tick
+};
+
+// Start recording `vehicle`, which must be in its start state; the fleet's profiles are recorded too
+void beginReplay(Replay& replay, const Fleet& fleet, size_t vehicle, float tickRate, const RoadMap& roads);
+
+// Start recording again from a restored snapshot taken at `tick`; earlier events are dropped
+void continueReplayFrom(Replay& replay, const std::vector<char>& snapshot, std::uint64_t tick);
+
+// Call right before simulating `tick` with the controls the vehicle will use for it
+void recordReplayTick(Replay& replay, std::uint64_t tick, std::uint8_t controls);
+
+// The vehicle was put back at the start; takes effect before `tick`
+void recordReplayReset(Replay& replay, std::uint64_t tick);
+
+// Finish the recording with the state the vehicle reached
+void endReplay(Replay& replay, const Fleet& fleet, size_t vehicle, std::uint64_t ticks);
+
+bool saveReplay(const Replay& replay, const std::string& path);
+bool loadReplay(const std::string& path, Replay& replay);
+
+// FNV-1a over the exact bits of a vehicle's physics state, for bit-for-bit comparisons
+std::uint64_t vehicleChecksum(const Fleet& fleet, size_t vehicle);
@@ -0,0 +1,590 @@
+#include "road_graph.h"
+#include "car.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <utility>
+
+namespace {
+
+const char ROAD_GRAPH_MAGIC[4] = { 'R', 'G', 'R', 'F' };
+const std::uint32_t ROAD_GRAPH_VERSION = 3;  // 3: stations come from zones that cover partial edge cells
+
+const float ROAD_GRAPH_CLEARANCE = CAR_WIDTH / 2.f + 4.f;  // Cells closer to an edge than this are too tight to steer through
+const float ROAD_GRAPH_SPUR = 2.f * CAR_LENGTH;      // Dead ends shorter than this are thinning artifacts
+
+// Cache key: the road grid plus everything the graph is built with beyond it, so changing a
+// build constant or the distance field rebuilds the cached graph
+std::uint64_t roadGraphKey(const RoadMap& roads) {
+    std::uint64_t key = surfaceGridHash(roads.surface);
+    auto mix = [&key](std::uint64_t value) {
+        key ^= value + 0x9E3779B97F4A7C15ull + (key << 6) + (key >> 2);
+    };
+    auto bits = [](float value) {
+        std::uint32_t word = 0;
+        std::memcpy(&word, &value, sizeof(word));
+        return word;
+    };
+    mix(bits(ROAD_GRAPH_CELL));
+    mix(static_cast<std::uint64_t>(ROAD_GRAPH_POINT_STEP));
+    mix(bits(ROAD_GRAPH_CLEARANCE));
+    mix(bits(ROAD_GRAPH_SPUR));
+    mix(bits(SURFACE_ZONE_CELL));
+    mix(bits(DISTANCE_FIELD_SCALE));
+    mix(DISTANCE_FIELD_VERSION);
+    return key;
+}
+
+// Neighbours in ring order starting north and going clockwise
+const int RING_X[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+const int RING_Y[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+struct CellGrid {
+    int width = 0;
+    int height = 0;
+    std::vector<std::uint8_t> cells;
+
+    std::uint8_t at(int x, int y) const {
+        if (x < 0 || y < 0 || x >= width || y >= height)
+            return 0;
+        return cells[static_cast<size_t>(y) * width + x];
+    }
+};
+
+void ringAround(const CellGrid& grid, int x, int y, std::uint8_t ring[8]) {
+    for (int k = 0; k < 8; ++k)
+        ring[k] = grid.at(x + RING_X[k], y + RING_Y[k]) ? 1 : 0;
+}
+
+// Number of 0 -> 1 steps going once around the ring; 3 or more means branches meet here
+int ringCrossings(const std::uint8_t ring[8]) {
+    int crossings = 0;
+    for (int k = 0; k < 8; ++k)
+        crossings += !ring[k] && ring[(k + 1) % 8];
+    return crossings;
+}
+
+int ringCount(const std::uint8_t ring[8]) {
+    int count = 0;
+    for (int k = 0; k < 8; ++k)
+        count += ring[k];
+    return count;
+}
+
+// Zhang-Suen thinning: peel boundary cells off in two alternating sub-passes until only a
+// one-cell wide, still connected centre line is left. Only cells still set are revisited.
+void thinToSkeleton(CellGrid& grid) {
+    std::vector<size_t> remaining;
+    for (size_t i = 0; i < grid.cells.size(); ++i) {
+        if (grid.cells[i])
+            remaining.push_back(i);
+    }
+
+    std::vector<size_t> removed;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int pass = 0; pass < 2; ++pass) {
+            removed.clear();
+            for (size_t index : remaining) {
+                int x = static_cast<int>(index % grid.width);
+                int y = static_cast<int>(index / grid.width);
+                std::uint8_t ring[8];
+                ringAround(grid, x, y, ring);
+
+                int count = ringCount(ring);
+                if (count < 2 || count > 6 || ringCrossings(ring) != 1)
+                    continue;
+
+                // ring[0], [2], [4], [6] are north, east, south and west
+                bool removable = pass == 0
+                    ? !(ring[0] && ring[2] && ring[4]) && !(ring[2] && ring[4] && ring[6])
+                    : !(ring[0] && ring[2] && ring[6]) && !(ring[0] && ring[4] && ring[6]);
+                if (removable)
+                    removed.push_back(index);
+            }
+
+            for (size_t index : removed)
+                grid.cells[index] = 0;
+            changed = changed || !removed.empty();
+        }
+
+        remaining.erase(std::remove_if(remaining.begin(), remaining.end(),
+            [&grid](size_t index) { return grid.cells[index] == 0; }), remaining.end());
+    }
+}
+
+sf::Vector2f cellCenter(int x, int y) {
+    return sf::Vector2f((x + 0.5f) * ROAD_GRAPH_CELL, (y + 0.5f) * ROAD_GRAPH_CELL);
+}
+
+struct TracedEdge {
+    std::uint32_t from;
+    std::uint32_t to;
+    std::vector<sf::Vector2f> points;
+};
+
+// Turn the skeleton into nodes (dead ends and clusters of branching cells) and the cell chains between them
+void traceSkeleton(const CellGrid& skeleton, std::vector<sf::Vector2f>& nodes, std::vector<TracedEdge>& edges) {
+    const int width = skeleton.width;
+    const size_t cellCount = skeleton.cells.size();
+    std::vector<std::uint32_t> nodeOf(cellCount, NO_ROAD_NODE);
+    std::vector<std::uint8_t> visited(cellCount, 0);
+
+    // Mark dead ends and branch points, then merge touching branch cells into one node
+    std::vector<std::uint8_t> isNodeCell(cellCount, 0);
+    for (size_t i = 0; i < cellCount; ++i) {
+        if (!skeleton.cells[i])
+            continue;
+        std::uint8_t ring[8];
+        ringAround(skeleton, static_cast<int>(i % width), static_cast<int>(i / width), ring);
+        int count = ringCount(ring);
+        isNodeCell[i] = count == 1 || ringCrossings(ring) >= 3;
+    }
+
+    std::vector<size_t> stack;
+    std::vector<std::vector<size_t>> nodeCells;
+    for (size_t i = 0; i < cellCount; ++i) {
+        if (!isNodeCell[i] || nodeOf[i] != NO_ROAD_NODE)
+            continue;
+
+        std::uint32_t node = static_cast<std::uint32_t>(nodes.size());
+        nodeCells.emplace_back();
+        sf::Vector2f sum;
+        stack.assign(1, i);
+        nodeOf[i] = node;
+        while (!stack.empty()) {
+            size_t cell = stack.back();
+            stack.pop_back();
+            nodeCells.back().push_back(cell);
+            int x = static_cast<int>(cell % width), y = static_cast<int>(cell / width);
+            sum += cellCenter(x, y);
+            for (int k = 0; k < 8; ++k) {
+                int nx = x + RING_X[k], ny = y + RING_Y[k];
+                if (nx < 0 || ny < 0 || nx >= width || ny >= skeleton.height)
+                    continue;
+                size_t next = static_cast<size_t>(ny) * width + nx;
+                if (isNodeCell[next] && nodeOf[next] == NO_ROAD_NODE) {
+                    nodeOf[next] = node;
+                    stack.push_back(next);
+                }
+            }
+        }
+        nodes.push_back(sum / static_cast<float>(nodeCells.back().size()));
+    }
+
+    std::set<std::pair<std::uint32_t, std::uint32_t>> adjacentNodes;
+    auto walk = [&](std::uint32_t startNode, size_t startCell) {
+        int sx = static_cast<int>(startCell % width), sy = static_cast<int>(startCell / width);
+        for (int k = 0; k < 8; ++k) {
+            int nx = sx + RING_X[k], ny = sy + RING_Y[k];
+            if (!skeleton.at(nx, ny))
+                continue;
+            size_t first = static_cast<size_t>(ny) * width + nx;
+            if (nodeOf[first] == startNode || visited[first])
+                continue;
+
+            TracedEdge edge;
+            edge.from = startNode;
+            edge.points.push_back(nodes[startNode]);
+
+            // Two nodes that touch directly are joined by a zero-cell edge, once
+            if (nodeOf[first] != NO_ROAD_NODE) {
+                std::pair<std::uint32_t, std::uint32_t> key(std::min(startNode, nodeOf[first]), std::max(startNode, nodeOf[first]));
+                if (adjacentNodes.insert(key).second) {
+                    edge.to = nodeOf[first];
+                    edge.points.push_back(nodes[edge.to]);
+                    edges.push_back(edge);
+                }
+                continue;
+            }
+
+            size_t previous = startCell;
+            size_t current = first;
+            int steps = 0;
+            for (;;) {
+                if (nodeOf[current] != NO_ROAD_NODE) {
+                    edge.to = nodeOf[current];
+                    break;
+                }
+                visited[current] = 1;
+                int cx = static_cast<int>(current % width), cy = static_cast<int>(current / width);
+                if (++steps % ROAD_GRAPH_POINT_STEP == 0)
+                    edge.points.push_back(cellCenter(cx, cy));
+
+                // Continue into a node if one is adjacent, else along the chain, straight steps first
+                size_t next = cellCount;
+                int rank = 3;
+                for (int j = 0; j < 8; ++j) {
+                    int nx = cx + RING_X[j], ny = cy + RING_Y[j];
+                    if (!skeleton.at(nx, ny))
+                        continue;
+                    size_t candidate = static_cast<size_t>(ny) * width + nx;
+                    if (candidate == previous || visited[candidate])
+                        continue;
+                    if (nodeOf[candidate] == startNode && steps < 2)
+                        continue;
+                    int candidateRank = nodeOf[candidate] != NO_ROAD_NODE ? 0 : (j % 2 == 0 ? 1 : 2);
+                    if (candidateRank < rank) {
+                        rank = candidateRank;
+                        next = candidate;
+                    }
+                }
+
+                if (next == cellCount) {
+                    // A dead end the classification missed becomes a node of its own
+                    edge.to = static_cast<std::uint32_t>(nodes.size());
+                    nodeOf[current] = edge.to;
+                    nodes.push_back(cellCenter(cx, cy));
+                    nodeCells.emplace_back(1, current);
+                    break;
+                }
+                previous = current;
+                current = next;
+            }
+
+            edge.points.push_back(nodes[edge.to]);
+            if (edge.to != edge.from)
+                edges.push_back(edge);
+        }
+    };
+
+    for (std::uint32_t node = 0; node < nodeCells.size(); ++node) {
+        for (size_t i = 0; i < nodeCells[node].size(); ++i)
+            walk(node, nodeCells[node][i]);
+    }
+}
+
+float polylineLength(const std::vector<sf::Vector2f>& points) {
+    float length = 0.f;
+    for (size_t i = 1; i < points.size(); ++i) {
+        sf::Vector2f step = points[i] - points[i - 1];
+        length += std::sqrt(step.x * step.x + step.y * step.y);
+    }
+    return length;
+}
+
+// The lookups derived from the nodes and edges, which the cache doesn't store
+void rebuildGraphIndex(RoadGraph& graph) {
+    std::vector<float> x(graph.nodes.size()), y(graph.nodes.size());
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        x[i] = graph.nodes[i].x;
+        y[i] = graph.nodes[i].y;
+    }
+    buildSpatialHash(graph.nodeIndex, x.data(), y.data(), x.size());
+
+    x.clear();
+    y.clear();
+    graph.indexedEdge.clear();
+    graph.indexedPoint.clear();
+    for (std::uint32_t e = 0; e < graph.edges.size(); ++e) {
+        for (std::uint32_t i = 0; i < graph.edges[e].pointCount; ++i) {
+            std::uint32_t point = graph.edges[e].firstPoint + i;
+            x.push_back(graph.pointX[point]);
+            y.push_back(graph.pointY[point]);
+            graph.indexedEdge.push_back(e);
+            graph.indexedPoint.push_back(point);
+        }
+    }
+    buildSpatialHash(graph.pointIndex, x.data(), y.data(), x.size());
+}
+
+// Fuel zones wide enough to stop in, each marked at its most open cell
+void findFuelStations(RoadGraph& graph, const RoadMap& roads) {
+    const SurfaceZones& zones = roads.zones;
+    std::vector<float> bestClearance(zones.zones.size(), -DISTANCE_FIELD_LIMIT);
+    std::vector<sf::Vector2f> best(zones.zones.size());
+    for (int y = 0; y < zones.height; ++y) {
+        for (int x = 0; x < zones.width; ++x) {
+            std::uint32_t zone = zones.labels[surfaceZoneCell(zones, x, y)];
+            if (zones.zones[zone].type != SURFACE_FUEL)
+                continue;
+            sf::Vector2f center((x + 0.5f) * SURFACE_ZONE_CELL, (y + 0.5f) * SURFACE_ZONE_CELL);
+            float clearance = distanceToEdge(roads.distance, center.x, center.y);
+            if (clearance > bestClearance[zone]) {
+                bestClearance[zone] = clearance;
+                best[zone] = center;
+            }
+        }
+    }
+
+    for (std::uint32_t zone : zones.fuelZones) {
+        if (bestClearance[zone] < ROAD_GRAPH_CLEARANCE)
+            continue;
+        FuelStation station;
+        station.x = best[zone].x;
+        station.y = best[zone].y;
+        station.zone = zone;
+        graph.stations.push_back(station);
+    }
+}
+
+float edgeLength(const RoadGraph& graph, const RoadEdge& edge) {
+    float length = 0.f;
+    for (std::uint32_t i = edge.firstPoint + 1; i < edge.firstPoint + edge.pointCount; ++i) {
+        float dx = graph.pointX[i] - graph.pointX[i - 1], dy = graph.pointY[i] - graph.pointY[i - 1];
+        length += std::sqrt(dx * dx + dy * dy);
+    }
+    return length;
+}
+
+// Give every station a node on the road right beside it, splitting the edge there if needed,
+// so a route to the station never has to cut across off-road to reach the pumps
+void connectFuelStations(RoadGraph& graph) {
+    for (FuelStation& station : graph.stations) {
+        std::uint32_t bestEdge = 0, bestPoint = 0;
+        float bestDistance = -1.f;
+        for (std::uint32_t e = 0; e < graph.edges.size(); ++e) {
+            const RoadEdge& edge = graph.edges[e];
+            for (std::uint32_t i = 0; i < edge.pointCount; ++i) {
+                float dx = graph.pointX[edge.firstPoint + i] - station.x, dy = graph.pointY[edge.firstPoint + i] - station.y;
+                if (bestDistance < 0.f || dx * dx + dy * dy < bestDistance) {
+                    bestDistance = dx * dx + dy * dy;
+                    bestEdge = e;
+                    bestPoint = i;
+                }
+            }
+        }
+        if (bestDistance < 0.f)
+            continue;
+
+        RoadEdge& edge = graph.edges[bestEdge];
+        if (bestPoint == 0 || bestPoint + 1 == edge.pointCount) {
+            station.node = bestPoint == 0 ? edge.from : edge.to;
+            continue;
+        }
+
+        // The two halves share the point the node sits on
+        station.node = static_cast<std::uint32_t>(graph.nodes.size());
+        RoadNode node;
+        node.x = graph.pointX[edge.firstPoint + bestPoint];
+        node.y = graph.pointY[edge.firstPoint + bestPoint];
+        graph.nodes.push_back(node);
+
+        RoadEdge second;
+        second.from = station.node;
+        second.to = edge.to;
+        second.firstPoint = edge.firstPoint + bestPoint;
+        second.pointCount = edge.pointCount - bestPoint;
+        edge.to = station.node;
+        edge.pointCount = bestPoint + 1;
+        edge.length = edgeLength(graph, edge);
+        second.length = edgeLength(graph, second);
+        graph.edges.push_back(second);
+    }
+}
+
+template <typename T>
+void writeVector(std::ofstream& file, const std::vector<T>& values) {
+    std::uint64_t count = values.size();
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T>
+bool readVector(std::ifstream& file, std::vector<T>& values) {
+    std::uint64_t count = 0;
+    if (!file.read(reinterpret_cast<char*>(&count), sizeof(count)) || count > (1ull << 28))
+        return false;
+    values.resize(static_cast<size_t>(count));
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(T)));
+}
+
+bool saveRoadGraph(const RoadGraph& graph, const std::string& path, std::uint64_t key) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    file.write(ROAD_GRAPH_MAGIC, sizeof(ROAD_GRAPH_MAGIC));
+    file.write(reinterpret_cast<const char*>(&ROAD_GRAPH_VERSION), sizeof(ROAD_GRAPH_VERSION));
+    file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+    writeVector(file, graph.nodes);
+    writeVector(file, graph.edges);
+    writeVector(file, graph.links);
+    writeVector(file, graph.pointX);
+    writeVector(file, graph.pointY);
+    writeVector(file, graph.stations);
+    return static_cast<bool>(file);
+}
+
+bool loadRoadGraphCache(RoadGraph& graph, const std::string& path, std::uint64_t key) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    char magic[4];
+    std::uint32_t version = 0;
+    std::uint64_t storedKey = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&storedKey), sizeof(storedKey));
+    if (!file || !std::equal(magic, magic + 4, ROAD_GRAPH_MAGIC) ||
+        version != ROAD_GRAPH_VERSION || storedKey != key)
+        return false;
+
+    if (!readVector(file, graph.nodes) || !readVector(file, graph.edges) || !readVector(file, graph.links) ||
+        !readVector(file, graph.pointX) || !readVector(file, graph.pointY) || !readVector(file, graph.stations))
+        return false;
+
+    rebuildGraphIndex(graph);
+    return true;
+}
+
+}
+
+void buildRoadGraph(RoadGraph& graph, const RoadMap& roads) {
+    graph = RoadGraph();
+
+    // Cells whose centre has room for a car body
+    CellGrid skeleton;
+    skeleton.width = static_cast<int>(roads.surface.width / ROAD_GRAPH_CELL);
+    skeleton.height = static_cast<int>(roads.surface.height / ROAD_GRAPH_CELL);
+    skeleton.cells.assign(static_cast<size_t>(skeleton.width) * skeleton.height, 0);
+    for (int y = 0; y < skeleton.height; ++y) {
+        for (int x = 0; x < skeleton.width; ++x) {
+            sf::Vector2f center = cellCenter(x, y);
+            skeleton.cells[static_cast<size_t>(y) * skeleton.width + x] =
+                distanceToEdge(roads.distance, center.x, center.y) >= ROAD_GRAPH_CLEARANCE;
+        }
+    }
+    thinToSkeleton(skeleton);
+
+    std::vector<sf::Vector2f> nodes;
+    std::vector<TracedEdge> traced;
+    traceSkeleton(skeleton, nodes, traced);
+
+    // Drop short dead-end spurs hanging off junctions
+    std::vector<int> degree(nodes.size(), 0);
+    for (const TracedEdge& edge : traced) {
+        ++degree[edge.from];
+        ++degree[edge.to];
+    }
+    std::vector<bool> keepEdge(traced.size(), true);
+    for (size_t i = 0; i < traced.size(); ++i) {
+        const TracedEdge& edge = traced[i];
+        bool spur = (degree[edge.from] == 1 && degree[edge.to] >= 3) || (degree[edge.to] == 1 && degree[edge.from] >= 3);
+        keepEdge[i] = !(spur && polylineLength(edge.points) < ROAD_GRAPH_SPUR);
+    }
+
+    // Compact: only nodes that still have an edge survive
+    std::vector<std::uint32_t> remap(nodes.size(), NO_ROAD_NODE);
+    std::vector<std::uint32_t> linkCount;
+    for (size_t i = 0; i < traced.size(); ++i) {
+        if (!keepEdge[i])
+            continue;
+        for (std::uint32_t end : { traced[i].from, traced[i].to }) {
+            if (remap[end] == NO_ROAD_NODE) {
+                remap[end] = static_cast<std::uint32_t>(graph.nodes.size());
+                RoadNode node;
+                node.x = nodes[end].x;
+                node.y = nodes[end].y;
+                graph.nodes.push_back(node);
+            }
+        }
+
+        RoadEdge edge;
+        edge.from = remap[traced[i].from];
+        edge.to = remap[traced[i].to];
+        edge.length = polylineLength(traced[i].points);
+        edge.firstPoint = static_cast<std::uint32_t>(graph.pointX.size());
+        edge.pointCount = static_cast<std::uint32_t>(traced[i].points.size());
+        for (const sf::Vector2f& point : traced[i].points) {
+            graph.pointX.push_back(point.x);
+            graph.pointY.push_back(point.y);
+        }
+        graph.edges.push_back(edge);
+    }
+
+    findFuelStations(graph, roads);
+    connectFuelStations(graph);
+
+    // Edge lists per node, stored back to back
+    for (const RoadEdge& edge : graph.edges) {
+        ++graph.nodes[edge.from].linkCount;
+        ++graph.nodes[edge.to].linkCount;
+    }
+    std::uint32_t offset = 0;
+    for (RoadNode& node : graph.nodes) {
+        node.firstLink = offset;
+        offset += node.linkCount;
+        node.linkCount = 0;
+    }
+    graph.links.resize(offset);
+    for (std::uint32_t e = 0; e < graph.edges.size(); ++e) {
+        RoadNode& from = graph.nodes[graph.edges[e].from];
+        graph.links[from.firstLink + from.linkCount++] = e;
+        RoadNode& to = graph.nodes[graph.edges[e].to];
+        graph.links[to.firstLink + to.linkCount++] = e;
+    }
+
+    rebuildGraphIndex(graph);
+}
+
+void loadRoadGraph(RoadGraph& graph, const RoadMap& roads, const std::string& cacheFile) {
+    std::uint64_t key = roadGraphKey(roads);
+    if (!loadRoadGraphCache(graph, cacheFile, key)) {
+        buildRoadGraph(graph, roads);
+        if (!saveRoadGraph(graph, cacheFile, key))
+            std::cerr << "Could not cache road graph to " << cacheFile << std::endl;
+    }
+}
+
+std::uint32_t nearestRoadNode(const RoadGraph& graph, float x, float y) {
+    if (graph.nodes.empty())
+        return NO_ROAD_NODE;
+
+    NeighbourQuery query;
+    std::vector<std::uint32_t>& candidates = query.found;
+    for (float radius = 4.f * SPATIAL_CELL_SIZE; candidates.empty() && radius < 64.f * SPATIAL_CELL_SIZE; radius *= 2.f)
+        queryNeighbours(graph.nodeIndex, x, y, radius, query);
+    if (candidates.empty()) {
+        for (std::uint32_t i = 0; i < graph.nodes.size(); ++i)
+            candidates.push_back(i);
+    }
+
+    std::uint32_t nearest = NO_ROAD_NODE;
+    float nearestDistance = 0.f;
+    for (std::uint32_t node : candidates) {
+        float dx = graph.nodes[node].x - x, dy = graph.nodes[node].y - y;
+        float distance = dx * dx + dy * dy;
+        if (nearest == NO_ROAD_NODE || distance < nearestDistance || (distance == nearestDistance && node < nearest)) {
+            nearest = node;
+            nearestDistance = distance;
+        }
+    }
+    return nearest;
+}
+
+bool nearestEdgePoint(const RoadGraph& graph, float x, float y, NeighbourQuery& query, std::uint32_t& edge,
+    std::uint32_t& point) {
+    if (graph.indexedPoint.empty())
+        return false;
+
+    // Any point nearer than the nearest one found lies inside the same radius, so the first
+    // radius that finds anything gives the exact answer
+    query.found.clear();
+    for (float radius = CAR_LENGTH; query.found.empty() && radius < 64.f * SPATIAL_CELL_SIZE; radius *= 2.f)
+        queryNeighbours(graph.pointIndex, x, y, radius, query);
+    if (query.found.empty()) {
+        for (std::uint32_t i = 0; i < graph.indexedPoint.size(); ++i)
+            query.found.push_back(i);
+    }
+
+    // Entries are in edge order, so the lowest entry is the lowest edge and index
+    std::uint32_t nearest = 0;
+    float nearestDistance = -1.f;
+    for (std::uint32_t entry : query.found) {
+        float dx = graph.pointX[graph.indexedPoint[entry]] - x, dy = graph.pointY[graph.indexedPoint[entry]] - y;
+        float distance = dx * dx + dy * dy;
+        if (nearestDistance < 0.f || distance < nearestDistance || (distance == nearestDistance && entry < nearest)) {
+            nearest = entry;
+            nearestDistance = distance;
+        }
+    }
+    edge = graph.indexedEdge[nearest];
+    point = graph.indexedPoint[nearest] - graph.edges[edge].firstPoint;
+    return true;
+}
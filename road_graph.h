@@ -0,0 +1,74 @@
+#pragma once
+#include "road_map.h"
+#include "spatial_hash.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+const float ROAD_GRAPH_CELL = 4.f;                    // World pixels per skeleton cell
+const int ROAD_GRAPH_POINT_STEP = 4;                  // Every 4th skeleton cell is kept as a steering point
+const std::uint32_t NO_ROAD_NODE = 0xFFFFFFFFu;
+// Where the game, replays and the benchmark all cache the graph; the key inside tells road grids apart
+const char* const ROAD_GRAPH_CACHE_FILE = "world.graph";
+
+// A junction or dead end of the road network. Its edges are links[firstLink, firstLink + linkCount).
+struct RoadNode {
+    float x = 0.f;
+    float y = 0.f;
+    std::uint32_t firstLink = 0;
+    std::uint32_t linkCount = 0;
+};
+
+// A stretch of road between two nodes, drivable both ways. points[firstPoint, firstPoint + pointCount)
+// follow the middle of the road from `from` to `to`, both nodes included.
+struct RoadEdge {
+    std::uint32_t from = 0;
+    std::uint32_t to = 0;
+    float length = 0.f;
+    std::uint32_t firstPoint = 0;
+    std::uint32_t pointCount = 0;
+};
+
+// A green fuel zone: where to stop inside it, and the node on the road right beside it
+struct FuelStation {
+    float x = 0.f;
+    float y = 0.f;
+    std::uint32_t node = NO_ROAD_NODE;
+    std::uint32_t zone = NO_SURFACE_ZONE;   // Its fuel zone in RoadMap::zones
+};
+
+// The road mask reduced to its centre lines. Drivable pixels wide enough for a car are thinned
+// to a one-cell skeleton, and the skeleton is traced into nodes and edges, so route planning
+// works on a few thousand nodes instead of millions of pixels.
+struct RoadGraph {
+    std::vector<RoadNode> nodes;
+    std::vector<RoadEdge> edges;
+    std::vector<std::uint32_t> links;       // Edge indices, grouped by node
+    std::vector<float> pointX;
+    std::vector<float> pointY;
+    std::vector<FuelStation> stations;
+    SpatialHash nodeIndex;                  // Node positions, rebuilt after loading
+    SpatialHash pointIndex;                 // Every edge's points, edge by edge, rebuilt after loading
+    std::vector<std::uint32_t> indexedEdge; // Edge of each pointIndex entry; edges that meet share a point
+    std::vector<std::uint32_t> indexedPoint;// Point of each pointIndex entry
+};
+
+void buildRoadGraph(RoadGraph& graph, const RoadMap& roads);
+
+// Load the graph from `cacheFile` if it was built from the same road grid with the same build
+// constants, else build and cache it
+void loadRoadGraph(RoadGraph& graph, const RoadMap& roads, const std::string& cacheFile);
+
+// Node nearest to a world position, or NO_ROAD_NODE if the graph is empty
+std::uint32_t nearestRoadNode(const RoadGraph& graph, float x, float y);
+
+// The edge point nearest to a world position, as an edge and a point index within it. Among
+// equally near points the lowest edge wins, then the lowest index. False if the graph has
+// no edges. `query` is scratch for the point index.
+bool nearestEdgePoint(const RoadGraph& graph, float x, float y, NeighbourQuery& query, std::uint32_t& edge,
+    std::uint32_t& point);
+
+// The node at the other end of an edge
+inline std::uint32_t otherRoadNode(const RoadEdge& edge, std::uint32_t node) {
+    return edge.from == node ? edge.to : edge.from;
+}
@@ -0,0 +1,75 @@
+#include "road_map.h"
+#include "world_tiles.h"
+#include <iostream>
+
+void buildRoadMap(RoadMap& map, const sf::Image& mask) {
+    buildSurfaceGrid(map.surface, mask);
+    buildDistanceField(map.distance, map.surface);
+    buildSurfaceZones(map.zones, map.surface);
+}
+
+void loadRoadMapDistance(RoadMap& map, const std::string& cacheFile) {
+    std::uint64_t key = surfaceGridHash(map.surface);
+    if (!loadDistanceField(map.distance, cacheFile, key)) {
+        buildDistanceField(map.distance, map.surface);
+        if (!saveDistanceField(map.distance, cacheFile, key))
+            std::cerr << "Could not cache distance field to " << cacheFile << std::endl;
+    }
+    buildSurfaceZones(map.zones, map.surface);
+}
+
+bool loadRoadMap(RoadMap& map, const std::string& maskFile) {
+    if (!loadSurfaceGrid(map.surface, maskFile))
+        return false;
+
+    loadRoadMapDistance(map, maskFile + ".sdf");
+    return true;
+}
+
+bool loadRoadMapTiles(RoadMap& map, const WorldTiles& world) {
+    initSurfaceGrid(map.surface, world.width, world.height);
+    for (unsigned int y = 0; y < tilesDown(world); ++y) {
+        for (unsigned int x = 0; x < tilesAcross(world); ++x) {
+            sf::Image tile;
+            if (!tile.loadFromFile(tileFile(world, "mask", x, y))) {
+                std::cerr << "Error loading road mask tile " << x << ", " << y << std::endl;
+                return false;
+            }
+            sf::IntRect rect = tileRect(world, x, y);
+            classifyMaskTile(map.surface, tile, rect.left, rect.top);
+        }
+    }
+
+    loadRoadMapDistance(map, world.prefix + ".sdf");
+    return true;
+}
+
+SurfaceType surfaceForMove(const RoadMap& map, float fromX, float fromY, float toX, float toY) {
+    SurfaceType surface = surfaceAt(map.surface, toX, toY);
+    // Off-road specks too small to be anything but noise in the mask are road in the
+    // distance field; the body sweep below has the final say there
+    if (surface == SURFACE_OFF_ROAD && distanceToEdge(map.distance, toX, toY) > 0.f)
+        surface = SURFACE_ROAD;
+    if (surface == SURFACE_OUT_OF_BOUNDS || surface == SURFACE_OFF_ROAD)
+        return surface;
+
+    if (sweepBodyHitsEdge(map.distance, fromX, fromY, toX, toY))
+        return SURFACE_OFF_ROAD;
+    return surface;
+}
+
+std::uint64_t surfaceGridHash(const SurfaceGrid& grid) {
+    // 64-bit FNV-1a over the dimensions and packed cells
+    std::uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](std::uint8_t byte) {
+        hash ^= byte;
+        hash *= 1099511628211ull;
+    };
+    for (int shift = 0; shift < 32; shift += 8) {
+        mix(static_cast<std::uint8_t>(grid.width >> shift));
+        mix(static_cast<std::uint8_t>(grid.height >> shift));
+    }
+    for (std::uint8_t cell : grid.cells)
+        mix(cell);
+    return hash;
+}
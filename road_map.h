@@ -0,0 +1,37 @@
+#pragma once
+#include "road_surface.h"
+#include "distance_field.h"
+#include "surface_zones.h"
+#include <string>
+
+struct WorldTiles;
+
+// Everything the physics needs to know about the map, derived once from the road mask
+struct RoadMap {
+    SurfaceGrid surface;
+    DistanceField distance;
+    SurfaceZones zones;
+};
+
+// Build from an already decoded mask (no disk cache)
+void buildRoadMap(RoadMap& map, const sf::Image& mask);
+
+// Decode and classify the mask file, loading the distance field from `<maskFile>.sdf` when it
+// matches the mask and rebuilding (and re-caching) it otherwise
+bool loadRoadMap(RoadMap& map, const std::string& maskFile);
+
+// Load the distance field for an already classified surface grid from `cacheFile`, or build it
+// and write the cache if the file is missing or was built from a different grid. The zones are
+// cheap enough to label again every time.
+void loadRoadMapDistance(RoadMap& map, const std::string& cacheFile);
+
+// Same as loadRoadMap, but classify the tiled mask one tile at a time so the full decoded mask is never in memory.
+// The distance field is cached as `<prefix>.sdf`.
+bool loadRoadMapTiles(RoadMap& map, const WorldTiles& world);
+
+// Surface a vehicle ends up on when moving from one point to another. The target pixel decides
+// road, fuel zone or off-road as before, and a swept body test against the distance field reports
+// off-road for any move that would clip an edge on the way, however large the step.
+SurfaceType surfaceForMove(const RoadMap& map, float fromX, float fromY, float toX, float toY);
+
+std::uint64_t surfaceGridHash(const SurfaceGrid& grid);
@@ -0,0 +1,52 @@
+#include "road_surface.h"
+#include <algorithm>
+#include <iostream>
+
+SurfaceType classifyMaskColor(const sf::Color& color) {
+    if (color.r < MASK_DARK_THRESHOLD && color.g < MASK_DARK_THRESHOLD && color.b < MASK_DARK_THRESHOLD)
+        return SURFACE_OFF_ROAD;
+    if (color.g >= color.r + MASK_GREEN_MARGIN && color.g >= color.b + MASK_GREEN_MARGIN)
+        return SURFACE_FUEL;
+    return SURFACE_ROAD;
+}
+
+void buildSurfaceGrid(SurfaceGrid& grid, const sf::Image& mask) {
+    initSurfaceGrid(grid, mask.getSize().x, mask.getSize().y);
+    classifyMaskTile(grid, mask, 0, 0);
+}
+
+void initSurfaceGrid(SurfaceGrid& grid, unsigned int width, unsigned int height) {
+    grid.width = width;
+    grid.height = height;
+    size_t count = static_cast<size_t>(grid.width) * grid.height;
+    grid.cells.assign((count + 3) / 4, 0);
+}
+
+void classifyMaskTile(SurfaceGrid& grid, const sf::Image& tile, unsigned int left, unsigned int top) {
+    // Walk the raw RGBA bytes once instead of calling getPixel per cell
+    const sf::Uint8* pixels = tile.getPixelsPtr();
+    if (!pixels)
+        return;
+
+    unsigned int width = std::min(tile.getSize().x, grid.width - std::min(left, grid.width));
+    unsigned int height = std::min(tile.getSize().y, grid.height - std::min(top, grid.height));
+    for (unsigned int y = 0; y < height; ++y) {
+        const sf::Uint8* row = pixels + static_cast<size_t>(y) * tile.getSize().x * 4;
+        size_t i = static_cast<size_t>(top + y) * grid.width + left;
+        for (unsigned int x = 0; x < width; ++x, ++i) {
+            const sf::Uint8* pixel = row + x * 4;
+            SurfaceType type = classifyMaskColor(sf::Color(pixel[0], pixel[1], pixel[2]));
+            grid.cells[i >> 2] |= static_cast<std::uint8_t>(type << ((i & 3) * 2));
+        }
+    }
+}
+
+bool loadSurfaceGrid(SurfaceGrid& grid, const std::string& maskFile) {
+    sf::Image mask;
+    if (!mask.loadFromFile(maskFile)) {
+        std::cerr << "Error loading road mask!" << std::endl;
+        return false;
+    }
+    buildSurfaceGrid(grid, mask);
+    return true;
+}
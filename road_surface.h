@@ -0,0 +1,44 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// What the road mask says about the pixel a vehicle is moving onto
+enum SurfaceType : std::uint8_t {
+    SURFACE_ROAD = 0,
+    SURFACE_OFF_ROAD = 1,        // Black in the mask
+    SURFACE_FUEL = 2,            // Green in the mask
+    SURFACE_OUT_OF_BOUNDS = 3
+};
+
+// Tolerances used to classify mask pixels; JPEG artifacts mean "black" and "green" are never exact
+const int MASK_DARK_THRESHOLD = 64;   // Every channel below this counts as off-road
+const int MASK_GREEN_MARGIN = 64;     // Green must beat red and blue by this much to be a fuel zone
+
+// The road mask classified once at load time and packed at 2 bits per pixel,
+// 16 times smaller than the RGBA image it is built from
+struct SurfaceGrid {
+    unsigned int width = 0;
+    unsigned int height = 0;
+    std::vector<std::uint8_t> cells;  // Four cells per byte, row-major
+};
+
+SurfaceType classifyMaskColor(const sf::Color& color);
+void buildSurfaceGrid(SurfaceGrid& grid, const sf::Image& mask);
+
+// Build the grid one mask tile at a time: size it once, then classify each tile into place
+void initSurfaceGrid(SurfaceGrid& grid, unsigned int width, unsigned int height);
+void classifyMaskTile(SurfaceGrid& grid, const sf::Image& tile, unsigned int left, unsigned int top);
+
+// Decode and classify a mask file; the decoded image is released before returning
+bool loadSurfaceGrid(SurfaceGrid& grid, const std::string& maskFile);
+
+// O(1) lookup of the surface under a world position
+inline SurfaceType surfaceAt(const SurfaceGrid& grid, float x, float y) {
+    if (x < 0 || y < 0 || x >= grid.width || y >= grid.height)
+        return SURFACE_OUT_OF_BOUNDS;
+
+    size_t index = static_cast<size_t>(y) * grid.width + static_cast<size_t>(x);
+    return static_cast<SurfaceType>((grid.cells[index >> 2] >> ((index & 3) * 2)) & 3);
+}
@@ -0,0 +1,103 @@
+#include "route_planner.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+void initRoutePlanner(RoutePlanner& planner, const RoadGraph& graph) {
+    size_t nodes = graph.nodes.size();
+    planner.graph = &graph;
+    planner.cache.clear();
+    planner.cost.assign(nodes, 0.f);
+    planner.arrivedBy.assign(nodes, 0);
+    planner.searchOf.assign(nodes, 0);
+    planner.closed.assign(nodes, 0);
+    planner.search = 0;
+}
+
+static float straightDistance(const RoadGraph& graph, std::uint32_t a, std::uint32_t b) {
+    float dx = graph.nodes[a].x - graph.nodes[b].x;
+    float dy = graph.nodes[a].y - graph.nodes[b].y;
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+static void searchRoute(RoutePlanner& planner, Route& route) {
+    const RoadGraph& graph = *planner.graph;
+    if (++planner.search == 0) {
+        // The search number wrapped; start the tags over
+        std::fill(planner.searchOf.begin(), planner.searchOf.end(), 0);
+        planner.search = 1;
+    }
+    ++planner.searches;
+
+    typedef std::pair<float, std::uint32_t> Entry;  // Estimated total length, node
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    auto touch = [&planner](std::uint32_t node) {
+        if (planner.searchOf[node] != planner.search) {
+            planner.searchOf[node] = planner.search;
+            planner.cost[node] = std::numeric_limits<float>::infinity();
+            planner.closed[node] = 0;
+        }
+    };
+
+    touch(route.from);
+    planner.cost[route.from] = 0.f;
+    open.push(Entry(straightDistance(graph, route.from, route.to), route.from));
+    while (!open.empty()) {
+        std::uint32_t node = open.top().second;
+        open.pop();
+        if (planner.closed[node])
+            continue;
+        planner.closed[node] = 1;
+        if (node == route.to)
+            break;
+
+        const RoadNode& current = graph.nodes[node];
+        for (std::uint32_t link = current.firstLink; link < current.firstLink + current.linkCount; ++link) {
+            std::uint32_t edge = graph.links[link];
+            std::uint32_t next = otherRoadNode(graph.edges[edge], node);
+            touch(next);
+            float cost = planner.cost[node] + graph.edges[edge].length;
+            if (planner.closed[next] || cost >= planner.cost[next])
+                continue;
+            planner.cost[next] = cost;
+            planner.arrivedBy[next] = edge;
+            open.push(Entry(cost + straightDistance(graph, next, route.to), next));
+        }
+    }
+
+    if (planner.searchOf[route.to] != planner.search || !planner.closed[route.to])
+        return;
+
+    // Walk the arrival edges back from the destination
+    route.found = true;
+    route.length = planner.cost[route.to];
+    for (std::uint32_t node = route.to; node != route.from; ) {
+        std::uint32_t edge = planner.arrivedBy[node];
+        route.edges.push_back(edge);
+        node = otherRoadNode(graph.edges[edge], node);
+    }
+    std::reverse(route.edges.begin(), route.edges.end());
+}
+
+std::shared_ptr<const Route> planRoute(RoutePlanner& planner, std::uint32_t from, std::uint32_t to) {
+    std::uint64_t key = (static_cast<std::uint64_t>(from) << 32) | to;
+    auto cached = planner.cache.find(key);
+    if (cached != planner.cache.end()) {
+        ++planner.cacheHits;
+        return cached->second;
+    }
+
+    std::shared_ptr<Route> route = std::make_shared<Route>();
+    route->from = from;
+    route->to = to;
+    if (planner.graph && from < planner.graph->nodes.size() && to < planner.graph->nodes.size())
+        searchRoute(planner, *route);
+
+    if (planner.cache.size() >= ROUTE_CACHE_LIMIT)
+        planner.cache.clear();
+    planner.cache.emplace(key, route);
+    return route;
+}
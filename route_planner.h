@@ -0,0 +1,39 @@
+#pragma once
+#include "road_graph.h"
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+const size_t ROUTE_CACHE_LIMIT = 8192;  // Routes kept before the cache starts over
+
+// The edges to drive, in order, to get from one node to another
+struct Route {
+    std::uint32_t from = NO_ROAD_NODE;
+    std::uint32_t to = NO_ROAD_NODE;
+    std::vector<std::uint32_t> edges;
+    float length = 0.f;
+    bool found = false;  // False if `to` can't be reached from `from`
+};
+
+// A* over the road graph with every answer cached by (from, to). Drivers share routes through
+// the cache, so many cars heading to the same fuel station cost one search. The search state
+// is reused between queries and tagged with a search number, so nothing is cleared per query.
+struct RoutePlanner {
+    const RoadGraph* graph = nullptr;
+    std::unordered_map<std::uint64_t, std::shared_ptr<const Route>> cache;
+
+    std::vector<float> cost;               // Best known distance from the start
+    std::vector<std::uint32_t> arrivedBy;  // Edge the best path enters each node through
+    std::vector<std::uint32_t> searchOf;   // Search number that last touched each node
+    std::vector<std::uint8_t> closed;
+    std::uint32_t search = 0;
+
+    size_t cacheHits = 0;
+    size_t searches = 0;
+};
+
+void initRoutePlanner(RoutePlanner& planner, const RoadGraph& graph);
+
+// Shortest route between two nodes. The result stays valid after the cache forgets it.
+std::shared_ptr<const Route> planRoute(RoutePlanner& planner, std::uint32_t from, std::uint32_t to);
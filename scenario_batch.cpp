@@ -0,0 +1,173 @@
+#include "scenario_batch.h"
+#include "thread_pool.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+
+static bool setParameter(Scenario& scenario, const std::string& param, float value) {
+    if (param == "maxspeed") scenario.tuning.maxSpeed = value;
+    else if (param == "acceleration") scenario.tuning.acceleration = value;
+    else if (param == "friction") scenario.tuning.friction = value;
+    else if (param == "turnrate") scenario.tuning.turnRate = value;
+    else if (param == "fuel") scenario.startFuel = value;
+    else if (param == "startx") scenario.startPosition.x = value;
+    else if (param == "starty") scenario.startPosition.y = value;
+    else if (param == "angle") scenario.startAngle = value;
+    else return false;
+    return scenario.tuning.maxSpeed > 0;
+}
+
+static std::string runName(const std::string& prefix, size_t index) {
+    std::ostringstream name;
+    name << prefix << "_" << index;
+    return name.str();
+}
+
+bool loadScenarioBatch(const std::string& path, std::vector<ScenarioRun>& runs) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Error opening scenario batch: " << path << std::endl;
+        return false;
+    }
+
+    Scenario base;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        std::string::size_type comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        std::istringstream in(line);
+        std::string directive;
+        if (!(in >> directive))
+            continue;
+
+        bool ok = true;
+        if (directive == "scenario") {
+            std::string scenarioFile;
+            base = Scenario();
+            ok = (in >> scenarioFile) && loadScenario(scenarioFile, base);
+        }
+        else if (directive == "run") {
+            ScenarioRun run;
+            run.scenario = base;
+            ok = static_cast<bool>(in >> run.name);
+            std::string param;
+            float value;
+            while (ok && in >> param)
+                ok = (in >> value) && setParameter(run.scenario, param, value);
+            if (ok)
+                runs.push_back(run);
+        }
+        else if (directive == "sweep") {
+            std::string param;
+            float from, to;
+            size_t count;
+            ok = (in >> param >> from >> to >> count) && count > 0;
+            for (size_t i = 0; ok && i < count; ++i) {
+                ScenarioRun run;
+                run.scenario = base;
+                run.name = runName(param, i);
+                float t = count > 1 ? static_cast<float>(i) / (count - 1) : 0.f;
+                ok = setParameter(run.scenario, param, from + (to - from) * t);
+                runs.push_back(run);
+            }
+        }
+        else if (directive == "random") {
+            size_t count;
+            unsigned int seed;
+            ok = static_cast<bool>(in >> count >> seed);
+
+            struct Range { std::string param; float min, max; };
+            std::vector<Range> ranges;
+            Range range;
+            while (ok && in >> range.param) {
+                ok = (in >> range.min >> range.max) && range.min <= range.max;
+                ranges.push_back(range);
+            }
+            ok = ok && !ranges.empty();
+            if (ok) {
+                std::mt19937 random(seed);
+                for (size_t i = 0; ok && i < count; ++i) {
+                    ScenarioRun run;
+                    run.scenario = base;
+                    run.name = runName("random", i);
+                    for (const Range& r : ranges)
+                        ok = ok && setParameter(run.scenario, r.param, std::uniform_real_distribution<float>(r.min, r.max)(random));
+                    runs.push_back(run);
+                }
+            }
+        }
+        else {
+            ok = false;
+        }
+
+        if (!ok) {
+            std::cerr << path << ":" << lineNumber << ": invalid batch line" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int runScenarioBatch(const std::vector<ScenarioRun>& runs, const std::string& reportFile, size_t threads) {
+    // Each distinct mask is loaded once and then only read, so every worker shares it
+    std::map<std::string, std::unique_ptr<RoadMap>> roadMaps;
+    for (const ScenarioRun& run : runs) {
+        std::unique_ptr<RoadMap>& roads = roadMaps[run.scenario.roadMaskFile];
+        if (roads)
+            continue;
+        roads.reset(new RoadMap());
+        if (!loadRoadMap(*roads, run.scenario.roadMaskFile))
+            return -1;
+    }
+
+    std::ofstream report(reportFile);
+    if (!report) {
+        std::cerr << "Error writing batch report: " << reportFile << std::endl;
+        return -1;
+    }
+
+    sf::Clock wallClock;
+    std::vector<ScenarioResult> results(runs.size());
+    ThreadPool pool;
+    startThreadPool(pool, threads);
+    for (size_t i = 0; i < runs.size(); ++i) {
+        const RoadMap* roads = roadMaps[runs[i].scenario.roadMaskFile].get();
+        submitTask(pool, [&runs, &results, roads, i]() {
+            Fleet fleet;
+            simulateScenario(runs[i].scenario, *roads, fleet, results[i]);
+        });
+    }
+    waitThreadPool(pool);
+    float wallSeconds = wallClock.getElapsedTime().asSeconds();
+
+    report << "name,maxspeed,acceleration,friction,turnrate,start_x,start_y,start_fuel,"
+        "fuel_used,distance,off_road_time,final_x,final_y,final_fuel\n";
+    report << std::setprecision(9);
+    double simulatedSeconds = 0.0;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        const Scenario& scenario = runs[i].scenario;
+        const ScenarioResult& result = results[i];
+        report << runs[i].name << "," << scenario.tuning.maxSpeed << "," << scenario.tuning.acceleration << ","
+            << scenario.tuning.friction << "," << scenario.tuning.turnRate << ","
+            << scenario.startPosition.x << "," << scenario.startPosition.y << "," << scenario.startFuel << ","
+            << result.fuelUsed << "," << result.distance << "," << result.offRoadTime << ","
+            << result.finalPosition.x << "," << result.finalPosition.y << "," << result.finalFuel << "\n";
+        simulatedSeconds += scenario.duration;
+    }
+
+    std::cout << "Runs: " << runs.size() << " on " << threadPoolSize(pool) << " threads\n";
+    std::cout << "Simulated: " << simulatedSeconds << " s\n";
+    std::cout << "Wall Time: " << wallSeconds << " s";
+    if (wallSeconds > 0)
+        std::cout << " (" << simulatedSeconds / wallSeconds << "x real time)";
+    std::cout << "\nReport: " << reportFile << std::endl;
+    return report ? 0 : -1;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "headless.h"
+#include <string>
+#include <vector>
+
+// One data point of a batch: a scenario with its own start and tuning values
+struct ScenarioRun {
+    std::string name;
+    Scenario scenario;
+};
+
+// Parse a batch file. Every run starts from the most recent base scenario, '#' starts a comment:
+//   scenario <file>                        base scenario for the lines that follow
+//   run <name> [<param> <value>]...        one run with some values changed
+//   sweep <param> <from> <to> <count>      evenly spaced values, ends included
+//   random <count> <seed> <param> <min> <max> [<param> <min> <max>]...
+//                                          uniformly sampled values (the seed makes them repeatable)
+// where <param> is maxspeed, acceleration, friction, turnrate, fuel, startx, starty or angle.
+bool loadScenarioBatch(const std::string& path, std::vector<ScenarioRun>& runs);
+
+// Simulate every run on a work-stealing pool of `threads` workers (0 = one per core) and
+// write one CSV row per run to `reportFile`
+int runScenarioBatch(const std::vector<ScenarioRun>& runs, const std::string& reportFile, size_t threads = 0);
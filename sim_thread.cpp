@@ -0,0 +1,186 @@
+#include "sim_thread.h"
+#include <algorithm>
+
+static const std::uint32_t SIM_FRAME_FRESH = 4;  // Set in `ready` until the window thread takes the frame
+static const std::uint64_t SIM_COMMAND_MASK = SIM_COMMAND_CAPACITY - 1;
+
+// Copy only what drawing reads; the vectors keep their capacity, so this allocates once
+static void copyRenderState(Fleet& to, const Fleet& from) {
+    to.positionX = from.positionX;
+    to.positionY = from.positionY;
+    to.previousX = from.previousX;
+    to.previousY = from.previousY;
+    to.previousAngle = from.previousAngle;
+    to.angle = from.angle;
+    to.speed = from.speed;
+    to.fuel = from.fuel;
+    to.mileage = from.mileage;
+}
+
+// Previous transforms are only filled in by the first tick, so a fleet that hasn't moved yet
+// is drawn where it is
+static void fillPreviousTransforms(Fleet& fleet) {
+    if (fleet.previousX.size() != fleetSize(fleet)) {
+        fleet.previousX = fleet.positionX;
+        fleet.previousY = fleet.positionY;
+        fleet.previousAngle = fleet.angle;
+    }
+}
+
+static void publishFrame(SimulationThread& sim) {
+    RenderFrame& frame = sim.frames[sim.back];
+    copyRenderState(frame.fleet, *sim.fleet);
+    fillPreviousTransforms(frame.fleet);
+    frame.tick = sim.timestep->tick;
+    frame.sequence = ++sim.published;
+    frame.tickRate = sim.timestep->tickRate;
+    frame.simulatedAt = std::chrono::steady_clock::now();
+    sim.back = sim.ready.exchange(sim.back | SIM_FRAME_FRESH, std::memory_order_acq_rel) & 3;
+}
+
+static bool popSimCommand(SimCommandQueue& queue, SimCommand& command) {
+    std::uint64_t tail = queue.tail.load(std::memory_order_relaxed);
+    if (tail == queue.head.load(std::memory_order_acquire))
+        return false;
+    command = queue.commands[tail & SIM_COMMAND_MASK];
+    queue.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+static void applySimCommand(SimulationThread& sim, const SimCommand& command) {
+    switch (command.type) {
+    case SIM_SET_CONTROLS:
+        sim.controls = command.controls;
+        break;
+    case SIM_PAUSE:
+        sim.paused = true;
+        break;
+    case SIM_RESUME:
+        sim.paused = false;
+        break;
+    case SIM_RESET_PLAYER:
+        resetVehicle(*sim.fleet, sim.player, sim.startPosition, 0.f, MAX_FUEL);
+        recordReplayReset(*sim.replay, sim.timestep->tick + 1);
+        sim.republish = true;
+        break;
+    }
+}
+
+static void runSimulation(SimulationThread* sim) {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point last = Clock::now();
+    while (!sim->stopping.load(std::memory_order_acquire)) {
+        Clock::time_point now = Clock::now();
+        float elapsed = std::chrono::duration<float>(now - last).count();
+        last = now;
+
+        float untilNextTick = 0.f;
+        {
+            std::lock_guard<std::mutex> lock(sim->stateMutex);
+            SimCommand command;
+            while (popSimCommand(sim->commands, command))
+                applySimCommand(*sim, command);
+
+            FixedTimestep& timestep = *sim->timestep;
+            bool ticked = false;
+            if (!sim->paused) {
+                accumulateFrameTime(timestep, elapsed);
+                while (consumeTick(timestep)) {
+                    {
+                        ProfileScope scope(sim->profiler, PROFILE_AI);
+                        driveAiTraffic(*sim->traffic, *sim->fleet, timestep.tick);
+                    }
+                    sim->fleet->controls[sim->player] = sim->controls;
+                    recordReplayTick(*sim->replay, timestep.tick, sim->controls);
+                    {
+                        ProfileScope scope(sim->profiler, PROFILE_PHYSICS);
+                        stepFleet(*sim->fleet, tickDuration(timestep), *sim->roads);
+                    }
+                    ProfileScope scope(sim->profiler, PROFILE_RECORD);
+                    recordTelemetry(*sim->telemetry, *sim->fleet, timestep.tick);
+                    ticked = true;
+                }
+                if (ticked)
+                    endProfileFrame(sim->profiler);
+                untilNextTick = tickDuration(timestep) - timestep.accumulator;
+            }
+            else {
+                untilNextTick = tickDuration(timestep);
+            }
+
+            if (ticked || sim->republish)
+                publishFrame(*sim);
+            sim->republish = false;
+        }
+
+        if (untilNextTick > 0.f)
+            std::this_thread::sleep_for(std::chrono::duration<float>(untilNextTick));
+    }
+}
+
+SimulationThread::~SimulationThread() {
+    stopSimulationThread(*this);
+}
+
+void startSimulationThread(SimulationThread& sim, Fleet& fleet, const RoadMap& roads, FixedTimestep& timestep,
+    AiTraffic& traffic, Replay& replay, TelemetryRecorder& telemetry, size_t player, const sf::Vector2f& startPosition) {
+    sim.fleet = &fleet;
+    sim.roads = &roads;
+    sim.timestep = &timestep;
+    sim.traffic = &traffic;
+    sim.replay = &replay;
+    sim.telemetry = &telemetry;
+    sim.player = player;
+    sim.startPosition = startPosition;
+    startProfiler(sim.profiler, 2, "Simulation");
+
+    // Every frame starts out as the initial state, so the window can draw before the first step
+    for (RenderFrame& frame : sim.frames) {
+        copyRenderState(frame.fleet, fleet);
+        fillPreviousTransforms(frame.fleet);
+        frame.tick = timestep.tick;
+        frame.tickRate = timestep.tickRate;
+        frame.simulatedAt = std::chrono::steady_clock::now();
+    }
+    sim.stopping = false;
+    sim.thread = std::thread(runSimulation, &sim);
+}
+
+void stopSimulationThread(SimulationThread& sim) {
+    if (!sim.thread.joinable())
+        return;
+    sim.stopping.store(true, std::memory_order_release);
+    sim.thread.join();
+}
+
+bool sendSimCommand(SimulationThread& sim, SimCommandType type, std::uint8_t controls) {
+    SimCommandQueue& queue = sim.commands;
+    std::uint64_t head = queue.head.load(std::memory_order_relaxed);
+    if (head - queue.tail.load(std::memory_order_acquire) >= SIM_COMMAND_CAPACITY)
+        return false;
+
+    SimCommand& command = queue.commands[head & SIM_COMMAND_MASK];
+    command.type = type;
+    command.controls = controls;
+    queue.head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+std::unique_lock<std::mutex> lockSimulation(SimulationThread& sim) {
+    return std::unique_lock<std::mutex>(sim.stateMutex);
+}
+
+void markSimulationChanged(SimulationThread& sim) {
+    sim.republish = true;
+}
+
+const RenderFrame& latestFrame(SimulationThread& sim) {
+    if (sim.ready.load(std::memory_order_acquire) & SIM_FRAME_FRESH)
+        sim.front = sim.ready.exchange(sim.front, std::memory_order_acq_rel) & 3;
+    return sim.frames[sim.front];
+}
+
+float frameAlpha(const RenderFrame& frame) {
+    float sinceTick = std::chrono::duration<float>(std::chrono::steady_clock::now() - frame.simulatedAt).count();
+    return std::min(std::max(sinceTick * frame.tickRate, 0.f), 1.f);
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "ai_driver.h"
+#include "fleet.h"
+#include "profiler.h"
+#include "replay.h"
+#include "simulation.h"
+#include "telemetry.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+const size_t SIM_COMMAND_CAPACITY = 256;  // Commands in flight to the simulation thread; a power of two
+
+// What the window thread asks of the simulation thread
+enum SimCommandType : std::uint8_t {
+    SIM_SET_CONTROLS,   // The player now holds `controls` (ControlBits)
+    SIM_PAUSE,          // Stop ticking until SIM_RESUME; paused time is not caught up on
+    SIM_RESUME,
+    SIM_RESET_PLAYER    // Put the player back at the start, as the Restart button does
+};
+
+struct SimCommand {
+    SimCommandType type = SIM_SET_CONTROLS;
+    std::uint8_t controls = 0;
+};
+
+// Single-producer single-consumer ring, like TelemetryRing: the window thread only writes
+// `head` and the simulation thread only writes `tail`
+struct SimCommandQueue {
+    SimCommand commands[SIM_COMMAND_CAPACITY];
+    alignas(64) std::atomic<std::uint64_t> head{ 0 };
+    alignas(64) std::atomic<std::uint64_t> tail{ 0 };
+};
+
+// Vehicle state as of one simulation step, for drawing. Only the columns the renderer reads are
+// filled in: positions, previous transforms, angle, speed, fuel and mileage.
+struct RenderFrame {
+    Fleet fleet;
+    std::uint64_t tick = 0;
+    std::uint64_t sequence = 0;   // Counts published frames, so a state republished at the same tick reads as new
+    float tickRate = SIMULATION_TICK_RATE;
+    std::chrono::steady_clock::time_point simulatedAt;  // When the last tick of the step finished
+};
+
+// The simulation on its own thread, ticking on its own clock at the fixed tick rate. The
+// window thread draws from a triple buffer of RenderFrames: the simulation thread fills the
+// back frame and swaps it with the ready one, the window thread swaps the ready one with its
+// front frame, and neither ever waits for the other. A slow frame therefore never delays a
+// tick, and a long step never delays a frame.
+//
+// Everything the thread simulates (fleet, timestep, AI, replay, telemetry) belongs to it while
+// it runs. The rare whole-state operations (quick save, quick load) take lockSimulation, which
+// waits at most for the step in progress.
+struct SimulationThread {
+    Fleet* fleet = nullptr;
+    const RoadMap* roads = nullptr;
+    FixedTimestep* timestep = nullptr;
+    AiTraffic* traffic = nullptr;
+    Replay* replay = nullptr;
+    TelemetryRecorder* telemetry = nullptr;
+    size_t player = 0;
+    sf::Vector2f startPosition;
+
+    FrameProfiler profiler;               // Zones of each simulation step; read it under lockSimulation
+    SimCommandQueue commands;
+
+    RenderFrame frames[3];
+    std::atomic<std::uint32_t> ready{ 1 };  // Index of the newest complete frame, plus SIM_FRAME_FRESH
+    std::uint32_t back = 0;                 // Owned by the simulation thread
+    std::uint64_t published = 0;            // Simulation thread only; frames published so far
+    std::uint32_t front = 2;                // Owned by the window thread
+
+    std::mutex stateMutex;                // Held by the simulation thread for every step
+    bool paused = true;                   // Guarded by stateMutex
+    bool republish = true;                // Guarded by stateMutex; publish a frame even without a tick
+    std::uint8_t controls = 0;            // Simulation thread only
+    std::atomic<bool> stopping{ false };
+    std::thread thread;
+
+    ~SimulationThread();
+};
+
+// Start simulating the given state, paused; the pointers must outlive the thread
+void startSimulationThread(SimulationThread& sim, Fleet& fleet, const RoadMap& roads, FixedTimestep& timestep,
+    AiTraffic& traffic, Replay& replay, TelemetryRecorder& telemetry, size_t player, const sf::Vector2f& startPosition);
+
+// Finish the step in progress and join the thread; the state belongs to the caller again
+void stopSimulationThread(SimulationThread& sim);
+
+// Queue a command from the window thread. Returns false if the queue is full; try again next frame.
+bool sendSimCommand(SimulationThread& sim, SimCommandType type, std::uint8_t controls = 0);
+
+// Exclusive access to the simulated state between steps. Call markSimulationChanged before
+// unlocking when the state was changed, so a new frame is published even while paused.
+std::unique_lock<std::mutex> lockSimulation(SimulationThread& sim);
+void markSimulationChanged(SimulationThread& sim);
+
+// The newest published frame (window thread only). It stays valid until the next call.
+const RenderFrame& latestFrame(SimulationThread& sim);
+
+// How far past the frame's last tick the present moment lies, in ticks, clamped to [0, 1]
+float frameAlpha(const RenderFrame& frame);
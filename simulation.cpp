@@ -0,0 +1,32 @@
+#include "simulation.h"
+
+float tickDuration(const FixedTimestep& timestep) {
+    return 1.f / timestep.tickRate;
+}
+
+void accumulateFrameTime(FixedTimestep& timestep, float frameTime) {
+    timestep.accumulator += frameTime;
+
+    // Never queue more work than maxTicksPerFrame, otherwise a slow frame makes the
+    // next one slower still
+    float maxBacklog = timestep.maxTicksPerFrame * tickDuration(timestep);
+    if (timestep.accumulator > maxBacklog)
+        timestep.accumulator = maxBacklog;
+}
+
+bool consumeTick(FixedTimestep& timestep) {
+    float dt = tickDuration(timestep);
+    if (timestep.accumulator < dt)
+        return false;
+
+    timestep.accumulator -= dt;
+    ++timestep.tick;
+    return true;
+}
+
+float interpolationAlpha(const FixedTimestep& timestep) {
+    float alpha = timestep.accumulator / tickDuration(timestep);
+    if (alpha < 0.f) alpha = 0.f;
+    if (alpha > 1.f) alpha = 1.f;
+    return alpha;
+}
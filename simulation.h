@@ -0,0 +1,25 @@
+#pragma once
+
+const float SIMULATION_TICK_RATE = 120.f;  // Physics ticks per second, independent of the frame rate
+
+// Fixed-timestep clock that decouples the physics tick rate from the render frame rate.
+// Frame time is fed into an accumulator and drained in whole ticks, so the simulation
+// always advances by the same deltaTime no matter how fast (or slow) frames are drawn.
+struct FixedTimestep {
+    float tickRate = SIMULATION_TICK_RATE;  // Simulation ticks per second
+    int maxTicksPerFrame = 8;               // Catch-up limit so a long stall can't spiral
+    float accumulator = 0.f;                // Frame time not yet consumed by ticks
+    unsigned long long tick = 0;            // Total ticks simulated so far
+};
+
+// Length of a single tick in seconds
+float tickDuration(const FixedTimestep& timestep);
+
+// Add a rendered frame's duration to the accumulator (clamped to maxTicksPerFrame ticks)
+void accumulateFrameTime(FixedTimestep& timestep, float frameTime);
+
+// Consume one tick from the accumulator; use as `while (consumeTick(timestep)) { ... }`
+bool consumeTick(FixedTimestep& timestep);
+
+// How far between the previous and the current tick the rendered frame lies, in [0, 1]
+float interpolationAlpha(const FixedTimestep& timestep);
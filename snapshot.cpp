@@ -0,0 +1,165 @@
+#include "snapshot.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const char SNAPSHOT_MAGIC[4] = { 'R', 'S', 'N', 'P' };
+
+struct SnapshotHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t vehicles;
+    std::uint64_t tick;
+    float tickRate;
+    float accumulator;
+    std::uint32_t keyCooldowns;
+    std::int32_t song;
+    float songOffset;
+    std::uint64_t profileTable;   // vehicleProfilesHash of the fleet's profiles
+};
+
+template <typename T>
+static void copyOut(char*& out, const std::vector<T>& column) {
+    std::memcpy(out, column.data(), column.size() * sizeof(T));
+    out += column.size() * sizeof(T);
+}
+
+template <typename T>
+static void copyIn(const char*& in, std::vector<T>& column, size_t count) {
+    column.resize(count);
+    std::memcpy(column.data(), in, count * sizeof(T));
+    in += count * sizeof(T);
+}
+
+// Bytes one vehicle takes across all columns: nine floats, the mileage, the controls and the profile
+static const size_t VEHICLE_BYTES = 9 * sizeof(float) + sizeof(double) + 2 * sizeof(std::uint8_t);
+
+// Bytes one key cooldown takes: the action and the ticks since it fired
+static const size_t KEY_COOLDOWN_BYTES = sizeof(std::int32_t) + sizeof(std::uint32_t);
+
+void takeSnapshot(std::vector<char>& blob, const Fleet& fleet, const FixedTimestep& timestep, const SessionState* session) {
+    size_t vehicles = fleetSize(fleet);
+    size_t keys = session ? session->keyCooldowns.size() : 0;
+
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));  // Padding too, so equal states give equal blobs
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.vehicles = vehicles;
+    header.tick = timestep.tick;
+    header.tickRate = timestep.tickRate;
+    header.accumulator = timestep.accumulator;
+    header.keyCooldowns = static_cast<std::uint32_t>(keys);
+    header.song = session ? session->song : -1;
+    header.songOffset = session ? session->songOffset : 0.f;
+    header.profileTable = vehicleProfilesHash(fleet.profiles);
+
+    blob.resize(sizeof(header) + vehicles * VEHICLE_BYTES + keys * KEY_COOLDOWN_BYTES);
+    char* out = blob.data();
+    std::memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+
+    copyOut(out, fleet.positionX);
+    copyOut(out, fleet.positionY);
+    copyOut(out, fleet.speed);
+    copyOut(out, fleet.angle);
+    copyOut(out, fleet.fuel);
+    copyOut(out, fleet.refuelCooldown);
+    copyOut(out, fleet.previousX);
+    copyOut(out, fleet.previousY);
+    copyOut(out, fleet.previousAngle);
+    copyOut(out, fleet.mileage);
+    copyOut(out, fleet.controls);
+    copyOut(out, fleet.profile);
+
+    for (size_t i = 0; i < keys; ++i) {
+        std::memcpy(out, &session->keyCooldowns[i].first, sizeof(std::int32_t));
+        std::memcpy(out + sizeof(std::int32_t), &session->keyCooldowns[i].second, sizeof(std::uint32_t));
+        out += KEY_COOLDOWN_BYTES;
+    }
+}
+
+bool restoreSnapshot(const std::vector<char>& blob, Fleet& fleet, FixedTimestep& timestep, SessionState* session) {
+    SnapshotHeader header;
+    if (blob.size() < sizeof(header))
+        return false;
+    std::memcpy(&header, blob.data(), sizeof(header));
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.version != SNAPSHOT_VERSION)
+        return false;
+
+    // Profile indices only mean the same vehicles with the same profile table
+    if (header.profileTable != vehicleProfilesHash(fleet.profiles))
+        return false;
+
+    // Bound the counts by the blob first so the expected size below can't overflow
+    if (header.vehicles > blob.size() / VEHICLE_BYTES || header.keyCooldowns > blob.size() / KEY_COOLDOWN_BYTES)
+        return false;
+    size_t vehicles = static_cast<size_t>(header.vehicles);
+    size_t keys = header.keyCooldowns;
+    if (blob.size() != sizeof(header) + vehicles * VEHICLE_BYTES + keys * KEY_COOLDOWN_BYTES)
+        return false;
+
+    // The profile column is the last one
+    const char* profileColumn = blob.data() + sizeof(header) + vehicles * (VEHICLE_BYTES - sizeof(std::uint8_t));
+    for (size_t i = 0; i < vehicles; ++i) {
+        if (static_cast<std::uint8_t>(profileColumn[i]) >= fleet.profiles.size())
+            return false;
+    }
+
+    const char* in = blob.data() + sizeof(header);
+    copyIn(in, fleet.positionX, vehicles);
+    copyIn(in, fleet.positionY, vehicles);
+    copyIn(in, fleet.speed, vehicles);
+    copyIn(in, fleet.angle, vehicles);
+    copyIn(in, fleet.fuel, vehicles);
+    copyIn(in, fleet.refuelCooldown, vehicles);
+    copyIn(in, fleet.previousX, vehicles);
+    copyIn(in, fleet.previousY, vehicles);
+    copyIn(in, fleet.previousAngle, vehicles);
+    copyIn(in, fleet.mileage, vehicles);
+    copyIn(in, fleet.controls, vehicles);
+    copyIn(in, fleet.profile, vehicles);
+    fleet.profileRunsStale = true;
+    // The hash isn't saved; the restored positions are the ones it was last built from
+    buildSpatialHash(fleet.neighbours, fleet.positionX.data(), fleet.positionY.data(), vehicles);
+
+    timestep.tick = header.tick;
+    timestep.tickRate = header.tickRate;
+    timestep.accumulator = header.accumulator;
+
+    if (session) {
+        session->keyCooldowns.resize(keys);
+        for (size_t i = 0; i < keys; ++i) {
+            std::memcpy(&session->keyCooldowns[i].first, in, sizeof(std::int32_t));
+            std::memcpy(&session->keyCooldowns[i].second, in + sizeof(std::int32_t), sizeof(std::uint32_t));
+            in += KEY_COOLDOWN_BYTES;
+        }
+        session->song = header.song;
+        session->songOffset = header.songOffset;
+    }
+    return true;
+}
+
+bool saveSnapshot(const std::vector<char>& blob, const std::string& path) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file || !file.write(blob.data(), blob.size())) {
+        std::cerr << "Error writing snapshot: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool loadSnapshot(const std::string& path, std::vector<char>& blob) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cerr << "Error opening snapshot: " << path << std::endl;
+        return false;
+    }
+    blob.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(blob.data(), blob.size())) {
+        std::cerr << "Error reading snapshot: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
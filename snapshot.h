@@ -0,0 +1,33 @@
+#pragma once
+#include "fleet.h"
+#include "simulation.h"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+const std::uint32_t SNAPSHOT_VERSION = 4;  // 2 added each vehicle's profile, 3 counts key cooldowns in ticks, 4 the profile table hash
+
+// Interactive state outside the simulation that a restore brings back as well
+struct SessionState {
+    std::vector<std::pair<std::int32_t, std::uint32_t>> keyCooldowns;  // InputAction, ticks since it last fired
+    std::int32_t song = -1;                                            // Playlist index, -1 when there is no music
+    float songOffset = 0.f;                                            // Seconds into the song
+};
+
+// The whole simulation as one flat, versioned blob: a fixed header followed by each fleet column
+// copied as a block. Taking or restoring a snapshot is a handful of memcpys, and reusing the same
+// blob (or fleet) keeps its allocation, so forking many runs from one checkpoint stays cheap.
+// Snapshots are only meant to be restored on the machine that took them (native endianness).
+void takeSnapshot(std::vector<char>& blob, const Fleet& fleet, const FixedTimestep& timestep,
+    const SessionState* session = nullptr);
+
+// Returns false, leaving everything untouched, if the blob is not a snapshot of this version, or
+// was taken with a different profile table. The table itself is not part of a snapshot, only a
+// hash of it (vehicleProfilesHash): the fleet's `profiles` must be set to the same table first.
+// fleet.neighbours is rebuilt from the restored positions, as the tick that reached them left it.
+bool restoreSnapshot(const std::vector<char>& blob, Fleet& fleet, FixedTimestep& timestep,
+    SessionState* session = nullptr);
+
+bool saveSnapshot(const std::vector<char>& blob, const std::string& path);
+bool loadSnapshot(const std::string& path, std::vector<char>& blob);
@@ -0,0 +1,67 @@
+#include "spatial_hash.h"
+#include <algorithm>
+#include <cmath>
+
+std::int32_t spatialCell(const SpatialHash& hash, float coordinate) {
+    return static_cast<std::int32_t>(std::floor(coordinate / hash.cellSize));
+}
+
+std::uint32_t spatialBucket(const SpatialHash& hash, std::int32_t cellX, std::int32_t cellY) {
+    std::uint32_t h = static_cast<std::uint32_t>(cellX) * 73856093u ^ static_cast<std::uint32_t>(cellY) * 19349663u;
+    return h & hash.bucketMask;
+}
+
+void buildSpatialHash(SpatialHash& hash, const float* positionX, const float* positionY, size_t count) {
+    // About two buckets per vehicle keeps unrelated cells from piling into one bucket
+    std::uint32_t buckets = 64;
+    while (buckets < count * 2)
+        buckets *= 2;
+    hash.bucketMask = buckets - 1;
+
+    hash.bucketStart.assign(buckets + 1, 0);
+    hash.vehicleBucket.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::uint32_t bucket = spatialBucket(hash, spatialCell(hash, positionX[i]), spatialCell(hash, positionY[i]));
+        hash.vehicleBucket[i] = bucket;
+        ++hash.bucketStart[bucket + 1];
+    }
+    for (std::uint32_t b = 0; b < buckets; ++b)
+        hash.bucketStart[b + 1] += hash.bucketStart[b];
+
+    // Scatter in vehicle order, so each bucket lists its vehicles by ascending index
+    hash.entries.resize(count);
+    hash.entryX.resize(count);
+    hash.entryY.resize(count);
+    std::vector<std::uint32_t> cursor(hash.bucketStart.begin(), hash.bucketStart.end() - 1);
+    for (size_t i = 0; i < count; ++i) {
+        std::uint32_t slot = cursor[hash.vehicleBucket[i]]++;
+        hash.entries[slot] = static_cast<std::uint32_t>(i);
+        hash.entryX[slot] = positionX[i];
+        hash.entryY[slot] = positionY[i];
+    }
+}
+
+void queryNeighbours(const SpatialHash& hash, float x, float y, float radius, NeighbourQuery& query) {
+    std::int32_t minX = spatialCell(hash, x - radius), maxX = spatialCell(hash, x + radius);
+    std::int32_t minY = spatialCell(hash, y - radius), maxY = spatialCell(hash, y + radius);
+
+    std::vector<std::uint32_t>& buckets = query.buckets;
+    buckets.clear();
+    for (std::int32_t cellY = minY; cellY <= maxY; ++cellY) {
+        for (std::int32_t cellX = minX; cellX <= maxX; ++cellX)
+            buckets.push_back(spatialBucket(hash, cellX, cellY));
+    }
+    std::sort(buckets.begin(), buckets.end());
+    buckets.erase(std::unique(buckets.begin(), buckets.end()), buckets.end());
+
+    query.found.clear();
+    const float radiusSquared = radius * radius;
+    for (std::uint32_t bucket : buckets) {
+        for (std::uint32_t e = hash.bucketStart[bucket]; e < hash.bucketStart[bucket + 1]; ++e) {
+            float offsetX = hash.entryX[e] - x;
+            float offsetY = hash.entryY[e] - y;
+            if (offsetX * offsetX + offsetY * offsetY <= radiusSquared)
+                query.found.push_back(hash.entries[e]);
+        }
+    }
+}
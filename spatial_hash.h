@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const float SPATIAL_CELL_SIZE = 96.f;  // Wider than two car bounding circles, so touching cars are in adjacent cells
+
+// Uniform grid over vehicle positions, hashed into a power-of-two number of buckets so the
+// map size doesn't matter. It is rebuilt every tick with a counting sort: vehicles of one
+// bucket end up contiguous (with a copy of their position), which makes a neighbour query
+// a scan of a few short runs instead of a pass over the whole fleet.
+struct SpatialHash {
+    float cellSize = SPATIAL_CELL_SIZE;
+    std::uint32_t bucketMask = 0;
+    std::vector<std::uint32_t> bucketStart;  // Entries of bucket b are [bucketStart[b], bucketStart[b + 1])
+    std::vector<std::uint32_t> entries;      // Vehicle indices, grouped by bucket
+    std::vector<float> entryX;               // Position of each entry
+    std::vector<float> entryY;
+    std::vector<std::uint32_t> vehicleBucket;
+};
+
+void buildSpatialHash(SpatialHash& hash, const float* positionX, const float* positionY, size_t count);
+
+// Buffers for queryNeighbours. Keep one around and pass it to every query, so a query
+// reuses the memory of the last one instead of allocating.
+struct NeighbourQuery {
+    std::vector<std::uint32_t> found;    // Vehicles within the radius of the last query
+    std::vector<std::uint32_t> buckets;  // Scratch: buckets overlapping the query
+};
+
+// Replace query.found with every vehicle within `radius` of (x, y)
+void queryNeighbours(const SpatialHash& hash, float x, float y, float radius, NeighbourQuery& query);
+
+std::int32_t spatialCell(const SpatialHash& hash, float coordinate);
+std::uint32_t spatialBucket(const SpatialHash& hash, std::int32_t cellX, std::int32_t cellY);
+
+// Call pairVisitor(i, j) once for every pair of vehicles closer than `radius` (at most cellSize),
+// with i < j. Only the 3x3 cells around each vehicle are searched.
+template <typename Visitor>
+void forEachClosePair(const SpatialHash& hash, float radius, Visitor pairVisitor) {
+    const float radiusSquared = radius * radius;
+    const size_t count = hash.entries.size();
+    std::uint32_t visited[9];
+
+    for (size_t e = 0; e < count; ++e) {
+        const std::uint32_t vehicle = hash.entries[e];
+        const float x = hash.entryX[e];
+        const float y = hash.entryY[e];
+        const std::int32_t cellX = spatialCell(hash, x);
+        const std::int32_t cellY = spatialCell(hash, y);
+
+        // Distinct cells can share a bucket; scan each bucket only once so no pair is reported twice
+        int visitedCount = 0;
+        for (std::int32_t dy = -1; dy <= 1; ++dy) {
+            for (std::int32_t dx = -1; dx <= 1; ++dx) {
+                std::uint32_t bucket = spatialBucket(hash, cellX + dx, cellY + dy);
+                bool seen = false;
+                for (int v = 0; v < visitedCount; ++v)
+                    seen = seen || visited[v] == bucket;
+                if (seen)
+                    continue;
+                visited[visitedCount++] = bucket;
+
+                for (std::uint32_t other = hash.bucketStart[bucket]; other < hash.bucketStart[bucket + 1]; ++other) {
+                    if (hash.entries[other] <= vehicle)
+                        continue;
+                    float offsetX = hash.entryX[other] - x;
+                    float offsetY = hash.entryY[other] - y;
+                    if (offsetX * offsetX + offsetY * offsetY < radiusSquared)
+                        pairVisitor(vehicle, hash.entries[other]);
+                }
+            }
+        }
+    }
+}
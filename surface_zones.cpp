@@ -0,0 +1,123 @@
+#include "surface_zones.h"
+#include <cmath>
+
+namespace {
+
+const int NEIGHBOUR_X[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+const int NEIGHBOUR_Y[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+// Flood one zone from its first cell, labelling every cell of the same type it reaches
+void labelZone(SurfaceZones& zones, const std::vector<std::uint8_t>& types, size_t first, std::vector<size_t>& stack) {
+    std::uint32_t id = static_cast<std::uint32_t>(zones.zones.size());
+    zones.zones.emplace_back();
+    SurfaceZone& zone = zones.zones.back();
+    zone.type = static_cast<SurfaceType>(types[first]);
+
+    int minX = zones.width, minY = zones.height, maxX = 0, maxY = 0;
+    double sumX = 0.0, sumY = 0.0;
+    stack.assign(1, first);
+    zones.labels[first] = id;
+    while (!stack.empty()) {
+        size_t cell = stack.back();
+        stack.pop_back();
+        int x = static_cast<int>(cell % zones.width), y = static_cast<int>(cell / zones.width);
+        ++zone.cellCount;
+        sumX += x;
+        sumY += y;
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+
+        for (int k = 0; k < 8; ++k) {
+            int nx = x + NEIGHBOUR_X[k], ny = y + NEIGHBOUR_Y[k];
+            if (nx < 0 || ny < 0 || nx >= zones.width || ny >= zones.height)
+                continue;
+            size_t next = surfaceZoneCell(zones, nx, ny);
+            if (zones.labels[next] == NO_SURFACE_ZONE && types[next] == types[first]) {
+                zones.labels[next] = id;
+                stack.push_back(next);
+            }
+        }
+    }
+
+    zone.bounds = sf::FloatRect(minX * SURFACE_ZONE_CELL, minY * SURFACE_ZONE_CELL,
+        (maxX - minX + 1) * SURFACE_ZONE_CELL, (maxY - minY + 1) * SURFACE_ZONE_CELL);
+    zone.centroidX = static_cast<float>((sumX / zone.cellCount + 0.5) * SURFACE_ZONE_CELL);
+    zone.centroidY = static_cast<float>((sumY / zone.cellCount + 0.5) * SURFACE_ZONE_CELL);
+}
+
+// Spread the fuel zones outwards, each cell taking the zone of the closest fuel cell seen by a
+// neighbour. A cell is queued again whenever a closer fuel cell reaches it, so the result is the
+// straight-line nearest rather than the nearest in steps.
+void spreadNearestFuel(SurfaceZones& zones) {
+    zones.nearestFuel.assign(zones.labels.size(), NO_SURFACE_ZONE);
+    if (zones.fuelZones.empty())
+        return;
+
+    // The fuel cell each cell is nearest to so far, and a FIFO of cells whose neighbours may now be nearer one
+    std::vector<int> sourceX(zones.labels.size()), sourceY(zones.labels.size());
+    std::vector<std::uint32_t> queue;
+    for (int y = 0; y < zones.height; ++y) {
+        for (int x = 0; x < zones.width; ++x) {
+            size_t cell = surfaceZoneCell(zones, x, y);
+            if (zones.zones[zones.labels[cell]].type != SURFACE_FUEL)
+                continue;
+            zones.nearestFuel[cell] = zones.labels[cell];
+            sourceX[cell] = x;
+            sourceY[cell] = y;
+            queue.push_back(static_cast<std::uint32_t>(cell));
+        }
+    }
+
+    for (size_t head = 0; head < queue.size(); ++head) {
+        size_t cell = queue[head];
+        int x = static_cast<int>(cell % zones.width), y = static_cast<int>(cell / zones.width);
+        for (int k = 0; k < 8; ++k) {
+            int nx = x + NEIGHBOUR_X[k], ny = y + NEIGHBOUR_Y[k];
+            if (nx < 0 || ny < 0 || nx >= zones.width || ny >= zones.height)
+                continue;
+            size_t next = surfaceZoneCell(zones, nx, ny);
+            long long dx = nx - sourceX[cell], dy = ny - sourceY[cell];
+            long long currentX = nx - sourceX[next], currentY = ny - sourceY[next];
+            if (zones.nearestFuel[next] == NO_SURFACE_ZONE || dx * dx + dy * dy < currentX * currentX + currentY * currentY) {
+                zones.nearestFuel[next] = zones.nearestFuel[cell];
+                sourceX[next] = sourceX[cell];
+                sourceY[next] = sourceY[cell];
+                queue.push_back(static_cast<std::uint32_t>(next));
+            }
+        }
+    }
+}
+
+}
+
+void buildSurfaceZones(SurfaceZones& zones, const SurfaceGrid& grid) {
+    zones = SurfaceZones();
+    // Rounded up, so a map whose size isn't a whole number of cells keeps its last pixels
+    zones.width = static_cast<int>(std::ceil(grid.width / SURFACE_ZONE_CELL));
+    zones.height = static_cast<int>(std::ceil(grid.height / SURFACE_ZONE_CELL));
+
+    // Each cell is whatever its centre pixel is, or its last pixel when a partial cell's centre is off the map
+    float lastX = grid.width - 0.5f, lastY = grid.height - 0.5f;
+    std::vector<std::uint8_t> types(static_cast<size_t>(zones.width) * zones.height);
+    for (int y = 0; y < zones.height; ++y) {
+        for (int x = 0; x < zones.width; ++x) {
+            float centerX = std::min((x + 0.5f) * SURFACE_ZONE_CELL, lastX);
+            float centerY = std::min((y + 0.5f) * SURFACE_ZONE_CELL, lastY);
+            types[surfaceZoneCell(zones, x, y)] = surfaceAt(grid, centerX, centerY);
+        }
+    }
+
+    zones.labels.assign(types.size(), NO_SURFACE_ZONE);
+    std::vector<size_t> stack;
+    for (size_t cell = 0; cell < types.size(); ++cell) {
+        if (zones.labels[cell] != NO_SURFACE_ZONE)
+            continue;
+        labelZone(zones, types, cell, stack);
+        if (zones.zones.back().type == SURFACE_FUEL)
+            zones.fuelZones.push_back(zones.labels[cell]);
+    }
+
+    spreadNearestFuel(zones);
+}
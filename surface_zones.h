@@ -0,0 +1,57 @@
+#pragma once
+#include "road_surface.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+const float SURFACE_ZONE_CELL = 4.f;                 // World pixels per labelled cell, as for the road graph
+const std::uint32_t NO_SURFACE_ZONE = 0xFFFFFFFFu;
+
+// One connected patch of a single surface type: a fuel station, a stretch of road network
+// or a piece of off-road
+struct SurfaceZone {
+    SurfaceType type = SURFACE_ROAD;
+    std::uint32_t cellCount = 0;
+    sf::FloatRect bounds;        // World pixels
+    float centroidX = 0.f;
+    float centroidY = 0.f;
+};
+
+// The road mask split into connected zones once at load time. Each cell is labelled with the
+// zone its centre pixel belongs to (8-connected, like the road graph's fuel search), so "which
+// zone is this" is a single lookup. Every cell also keeps the fuel zone nearest to it, spread
+// out from all fuel cells at once, so "where is the nearest fuel station" is one lookup too.
+struct SurfaceZones {
+    int width = 0;                            // In cells
+    int height = 0;
+    std::vector<std::uint32_t> labels;        // Zone of each cell, row-major
+    std::vector<std::uint32_t> nearestFuel;   // Nearest fuel zone to each cell; NO_SURFACE_ZONE without any
+    std::vector<SurfaceZone> zones;           // By zone id, in scan order of their first cell
+    std::vector<std::uint32_t> fuelZones;     // Ids of the fuel zones
+};
+
+void buildSurfaceZones(SurfaceZones& zones, const SurfaceGrid& grid);
+
+inline size_t surfaceZoneCell(const SurfaceZones& zones, int x, int y) {
+    return static_cast<size_t>(y) * zones.width + x;
+}
+
+// Zone under a world position, or NO_SURFACE_ZONE outside the map
+inline std::uint32_t zoneAt(const SurfaceZones& zones, float x, float y) {
+    if (x < 0 || y < 0)
+        return NO_SURFACE_ZONE;
+    int cellX = static_cast<int>(x / SURFACE_ZONE_CELL), cellY = static_cast<int>(y / SURFACE_ZONE_CELL);
+    if (cellX >= zones.width || cellY >= zones.height)
+        return NO_SURFACE_ZONE;
+    return zones.labels[surfaceZoneCell(zones, cellX, cellY)];
+}
+
+// Fuel zone with a cell nearest to a world position (positions off the map count from its edge),
+// or NO_SURFACE_ZONE if the map has none
+inline std::uint32_t nearestFuelZone(const SurfaceZones& zones, float x, float y) {
+    if (zones.nearestFuel.empty())
+        return NO_SURFACE_ZONE;
+    int cellX = std::min(std::max(static_cast<int>(x / SURFACE_ZONE_CELL), 0), zones.width - 1);
+    int cellY = std::min(std::max(static_cast<int>(y / SURFACE_ZONE_CELL), 0), zones.height - 1);
+    return zones.nearestFuel[surfaceZoneCell(zones, cellX, cellY)];
+}
@@ -0,0 +1,196 @@
+#include "telemetry.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+static const char TELEMETRY_MAGIC[4] = { 'R', 'T', 'L', 'M' };
+static const std::uint32_t TELEMETRY_VERSION = 1;
+
+// Bytes one sample takes in a chunk, summed over the columns
+static const size_t TELEMETRY_SAMPLE_BYTES = sizeof(std::uint64_t) + sizeof(std::uint32_t) + 5 * sizeof(float)
+    + sizeof(double) + sizeof(std::uint8_t);
+static const std::uint64_t TELEMETRY_RING_MASK = TELEMETRY_RING_CAPACITY - 1;
+
+template <typename T>
+static void writeColumn(std::ofstream& file, const std::vector<TelemetrySample>& chunk, T TelemetrySample::* field,
+    std::vector<char>& scratch) {
+    scratch.resize(chunk.size() * sizeof(T));
+    for (size_t i = 0; i < chunk.size(); ++i)
+        std::memcpy(&scratch[i * sizeof(T)], &(chunk[i].*field), sizeof(T));
+    file.write(scratch.data(), scratch.size());
+}
+
+template <typename T>
+static bool readColumn(std::ifstream& file, std::vector<TelemetrySample>& samples, size_t first, T TelemetrySample::* field,
+    std::vector<char>& scratch) {
+    size_t count = samples.size() - first;
+    scratch.resize(count * sizeof(T));
+    if (!file.read(scratch.data(), scratch.size()))
+        return false;
+    for (size_t i = 0; i < count; ++i)
+        std::memcpy(&(samples[first + i].*field), &scratch[i * sizeof(T)], sizeof(T));
+    return true;
+}
+
+// Each field is stored as its own column so a chunk compresses well and a tool can read one field alone
+static void writeChunk(std::ofstream& file, const std::vector<TelemetrySample>& chunk, std::vector<char>& scratch) {
+    std::uint32_t count = static_cast<std::uint32_t>(chunk.size());
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    writeColumn(file, chunk, &TelemetrySample::tick, scratch);
+    writeColumn(file, chunk, &TelemetrySample::vehicle, scratch);
+    writeColumn(file, chunk, &TelemetrySample::positionX, scratch);
+    writeColumn(file, chunk, &TelemetrySample::positionY, scratch);
+    writeColumn(file, chunk, &TelemetrySample::speed, scratch);
+    writeColumn(file, chunk, &TelemetrySample::angle, scratch);
+    writeColumn(file, chunk, &TelemetrySample::fuel, scratch);
+    writeColumn(file, chunk, &TelemetrySample::mileage, scratch);
+    writeColumn(file, chunk, &TelemetrySample::surface, scratch);
+}
+
+static void runTelemetryWriter(TelemetryRecorder* recorder) {
+    TelemetryRing& ring = recorder->ring;
+    std::vector<TelemetrySample> chunk;
+    chunk.reserve(TELEMETRY_CHUNK_SAMPLES);
+    std::vector<char> scratch;
+
+    for (;;) {
+        // Read the flag before the head, so once it is set every recorded sample is visible
+        bool stopping = recorder->stopping.load(std::memory_order_acquire);
+        std::uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        std::uint64_t head = ring.head.load(std::memory_order_acquire);
+
+        while (tail != head && chunk.size() < TELEMETRY_CHUNK_SAMPLES)
+            chunk.push_back(ring.samples[tail++ & TELEMETRY_RING_MASK]);
+        ring.tail.store(tail, std::memory_order_release);
+
+        bool drained = tail == head;
+        if (chunk.size() == TELEMETRY_CHUNK_SAMPLES || (drained && stopping && !chunk.empty())) {
+            writeChunk(recorder->file, chunk, scratch);
+            recorder->written += chunk.size();
+            chunk.clear();
+        }
+
+        if (drained) {
+            if (stopping)
+                break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+    recorder->file.flush();
+}
+
+TelemetryRecorder::~TelemetryRecorder() {
+    stopTelemetry(*this);
+}
+
+bool startTelemetry(TelemetryRecorder& recorder, const std::string& path) {
+    recorder.file.open(path, std::ios::binary | std::ios::trunc);
+    if (!recorder.file) {
+        std::cerr << "Error opening telemetry file: " << path << std::endl;
+        return false;
+    }
+    recorder.file.write(TELEMETRY_MAGIC, sizeof(TELEMETRY_MAGIC));
+    recorder.file.write(reinterpret_cast<const char*>(&TELEMETRY_VERSION), sizeof(TELEMETRY_VERSION));
+
+    recorder.ring.samples.resize(TELEMETRY_RING_CAPACITY);
+    recorder.writer = std::thread(runTelemetryWriter, &recorder);
+    return true;
+}
+
+void recordTelemetry(TelemetryRecorder& recorder, const Fleet& fleet, std::uint64_t tick) {
+    TelemetryRing& ring = recorder.ring;
+    if (ring.samples.empty())
+        return;
+
+    // Fill every free slot first and publish them all with a single store
+    std::uint64_t head = ring.head.load(std::memory_order_relaxed);
+    std::uint64_t free = TELEMETRY_RING_CAPACITY - (head - ring.tail.load(std::memory_order_acquire));
+    size_t vehicles = fleetSize(fleet);
+    size_t vehicle = 0;
+    for (;;) {
+        size_t count = vehicles - vehicle;
+        if (count > free)
+            count = static_cast<size_t>(free);
+
+        for (size_t i = 0; i < count; ++i, ++vehicle) {
+            TelemetrySample& sample = ring.samples[(head + i) & TELEMETRY_RING_MASK];
+            sample.tick = tick;
+            sample.vehicle = static_cast<std::uint32_t>(vehicle);
+            sample.positionX = fleet.positionX[vehicle];
+            sample.positionY = fleet.positionY[vehicle];
+            sample.speed = fleet.speed[vehicle];
+            sample.angle = fleet.angle[vehicle];
+            sample.fuel = fleet.fuel[vehicle];
+            sample.mileage = fleet.mileage[vehicle];
+            sample.surface = vehicle < fleet.surface.size() ? fleet.surface[vehicle] : 0;
+        }
+        head += count;
+        ring.head.store(head, std::memory_order_release);
+
+        if (vehicle == vehicles)
+            return;
+        if (!recorder.lossless) {
+            recorder.dropped.fetch_add(vehicles - vehicle, std::memory_order_relaxed);
+            return;
+        }
+
+        // Lossless: let the writer catch up, then continue with the rest of the fleet
+        std::this_thread::yield();
+        free = TELEMETRY_RING_CAPACITY - (head - ring.tail.load(std::memory_order_acquire));
+    }
+}
+
+void stopTelemetry(TelemetryRecorder& recorder) {
+    if (!recorder.writer.joinable())
+        return;
+
+    recorder.stopping.store(true, std::memory_order_release);
+    recorder.writer.join();
+    recorder.file.close();
+
+    std::uint64_t dropped = recorder.dropped.load(std::memory_order_relaxed);
+    if (dropped > 0)
+        std::cerr << "Telemetry dropped " << dropped << " of " << recorder.written + dropped << " samples" << std::endl;
+}
+
+bool loadTelemetry(const std::string& path, std::vector<TelemetrySample>& samples) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    std::streamoff fileSize = file ? static_cast<std::streamoff>(file.tellg()) : 0;
+    file.seekg(0);
+    char magic[sizeof(TELEMETRY_MAGIC)];
+    std::uint32_t version = 0;
+    if (!file.read(magic, sizeof(magic)) || !file.read(reinterpret_cast<char*>(&version), sizeof(version))
+        || std::memcmp(magic, TELEMETRY_MAGIC, sizeof(magic)) != 0 || version != TELEMETRY_VERSION) {
+        std::cerr << "Error reading telemetry file: " << path << std::endl;
+        return false;
+    }
+
+    samples.clear();
+    std::vector<char> scratch;
+    std::uint32_t count = 0;
+    while (file.read(reinterpret_cast<char*>(&count), sizeof(count))) {
+        // A count the rest of the file can't hold is corrupt; don't allocate for it
+        std::uint64_t remaining = static_cast<std::uint64_t>(fileSize - static_cast<std::streamoff>(file.tellg()));
+        if (count > remaining / TELEMETRY_SAMPLE_BYTES) {
+            std::cerr << "Telemetry file is truncated: " << path << std::endl;
+            return false;
+        }
+        size_t first = samples.size();
+        samples.resize(first + count);
+        bool ok = readColumn(file, samples, first, &TelemetrySample::tick, scratch)
+            && readColumn(file, samples, first, &TelemetrySample::vehicle, scratch)
+            && readColumn(file, samples, first, &TelemetrySample::positionX, scratch)
+            && readColumn(file, samples, first, &TelemetrySample::positionY, scratch)
+            && readColumn(file, samples, first, &TelemetrySample::speed, scratch)
+            && readColumn(file, samples, first, &TelemetrySample::angle, scratch)
+            && readColumn(file, samples, first, &TelemetrySample::fuel, scratch)
+            && readColumn(file, samples, first, &TelemetrySample::mileage, scratch)
+            && readColumn(file, samples, first, &TelemetrySample::surface, scratch);
+        if (!ok) {
+            std::cerr << "Telemetry file is truncated: " << path << std::endl;
+            samples.resize(first);
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "fleet.h"
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+const size_t TELEMETRY_RING_CAPACITY = 1 << 16;  // Samples; a power of two
+const size_t TELEMETRY_CHUNK_SAMPLES = 4096;     // Samples per columnar chunk in the file
+
+// The state of one vehicle at the end of one tick
+struct TelemetrySample {
+    std::uint64_t tick;
+    std::uint32_t vehicle;
+    float positionX;
+    float positionY;
+    float speed;
+    float angle;
+    float fuel;
+    double mileage;
+    std::uint8_t surface;  // SurfaceType of the tick's move
+};
+
+// Single-producer single-consumer ring. The simulation thread only writes `head` and the
+// writer thread only writes `tail`, so neither side ever takes a lock or waits on the other.
+// Both indices count up forever and are masked into the buffer.
+struct TelemetryRing {
+    std::vector<TelemetrySample> samples;
+    alignas(64) std::atomic<std::uint64_t> head{ 0 };
+    alignas(64) std::atomic<std::uint64_t> tail{ 0 };
+};
+
+// Records every vehicle every tick. The simulation copies the fleet columns into the ring;
+// a background thread drains it into binary chunks. When the writer falls behind, samples
+// that don't fit are counted in `dropped` rather than stalling the tick, unless `lossless`
+// is set (headless runs have no frame to protect and want every sample).
+//
+// File layout (little endian): "RTLM", uint32 version, then chunks of
+//   uint32 count, uint64 tick[count], uint32 vehicle[count], float positionX[count],
+//   float positionY[count], float speed[count], float angle[count], float fuel[count],
+//   double mileage[count], uint8 surface[count]
+struct TelemetryRecorder {
+    TelemetryRing ring;
+    std::ofstream file;
+    bool lossless = false;
+    std::atomic<bool> stopping{ false };
+    std::atomic<std::uint64_t> dropped{ 0 };
+    std::uint64_t written = 0;  // Owned by the writer thread until it is joined
+    std::thread writer;
+
+    ~TelemetryRecorder();
+};
+
+bool startTelemetry(TelemetryRecorder& recorder, const std::string& path);
+
+// Queue one sample per vehicle for the tick that was just simulated
+void recordTelemetry(TelemetryRecorder& recorder, const Fleet& fleet, std::uint64_t tick);
+
+// Write out everything still queued and close the file
+void stopTelemetry(TelemetryRecorder& recorder);
+
+// Read a whole recording back, e.g. for analysis tools. Fails on a chunk longer than the rest
+// of the file, keeping the samples of the chunks before it.
+bool loadTelemetry(const std::string& path, std::vector<TelemetrySample>& samples);
@@ -0,0 +1,8 @@
+#include <iostream>
+#include "batch_physics.h"
+
+// The vectorized fleet physics must match the scalar reference formulas
+int main()
+{
+    return verifyBatchPhysics(std::cout) ? 0 : 1;
+}
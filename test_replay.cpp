@@ -0,0 +1,124 @@
+#include <cstdio>
+#include <iostream>
+#include "ai_driver.h"
+#include "headless.h"
+#include "road_graph.h"
+#include "snapshot.h"
+
+// Scripted keys for a tick: drive off, turn, coast, brake and turn back
+static std::uint8_t scriptedControls(std::uint64_t tick) {
+    if (tick <= 120) return CONTROL_ACCELERATE;
+    if (tick <= 240) return CONTROL_ACCELERATE | CONTROL_TURN_LEFT;
+    if (tick <= 300) return 0;
+    if (tick <= 360) return CONTROL_BRAKE;
+    return CONTROL_ACCELERATE | CONTROL_TURN_RIGHT;
+}
+
+static bool sameReplay(const Replay& a, const Replay& b) {
+    if (a.events.size() != b.events.size())
+        return false;
+    for (size_t i = 0; i < a.events.size(); ++i) {
+        if (a.events[i].tick != b.events[i].tick || a.events[i].controls != b.events[i].controls
+            || a.events[i].flags != b.events[i].flags)
+            return false;
+    }
+    return a.startPosition == b.startPosition && a.startAngle == b.startAngle && a.startFuel == b.startFuel
+        && a.tickRate == b.tickRate && a.roadMaskFile == b.roadMaskFile && a.roadGridHash == b.roadGridHash
+        && a.startTick == b.startTick && a.startSnapshot == b.startSnapshot && a.aiDrivers == b.aiDrivers
+        && a.aiSeed == b.aiSeed && vehicleProfilesHash(a.profiles) == vehicleProfilesHash(b.profiles)
+        && a.ticks == b.ticks && a.finalChecksum == b.finalChecksum;
+}
+
+// Save, load and re-simulate a recording; it must read back field for field and end bit for bit
+// where the recorded session did
+static bool checkRoundTrip(const Replay& replay, const RoadMap& roads, const RoadGraph& graph, const char* name) {
+    const char* path = "test_replay.replay";
+    Replay loaded;
+    bool ok = saveReplay(replay, path) && loadReplay(path, loaded) && sameReplay(replay, loaded);
+    std::remove(path);
+
+    Fleet fleet;
+    ok = ok && simulateReplay(loaded, roads, graph, fleet) && vehicleChecksum(fleet, 0) == replay.finalChecksum;
+    std::cout << (ok ? "PASS" : "FAIL") << ": " << name << ", " << replay.events.size() << " input changes" << std::endl;
+    return ok;
+}
+
+// Drive a session with AI traffic on a small map the way the simulation thread records one,
+// including a reset, and check the replay from the start and the one continued from a
+// mid-session snapshot
+int main()
+{
+    // A three by three grid of roads, wide enough for the AI, with a fuel zone on the bottom one
+    sf::Image mask;
+    mask.create(1024, 1024, sf::Color::Black);
+    for (unsigned int y = 152; y < 872; ++y) {
+        for (unsigned int x = 152; x < 872; ++x) {
+            bool road = false;
+            for (unsigned int center : { 192u, 512u, 832u })
+                road = road || (x + 40 >= center && x < center + 40) || (y + 40 >= center && y < center + 40);
+            if (road)
+                mask.setPixel(x, y, y > 792 && x > 600 && x < 680 ? sf::Color(0, 200, 0) : sf::Color::White);
+        }
+    }
+    RoadMap roads;
+    buildRoadMap(roads, mask);
+    RoadGraph graph;
+    buildRoadGraph(graph, roads);
+
+    const sf::Vector2f start(350.f, 512.f);
+    const std::uint64_t ticks = 600;
+    const std::uint64_t resetTick = 420;
+    const std::uint64_t snapshotTick = 300;
+    const std::uint32_t aiDrivers = 12;
+    const std::uint32_t aiSeed = 7;
+
+    Fleet fleet;
+    fleet.collisions = true;
+    VehicleProfile heavy;
+    heavy.name = "truck";
+    heavy.model = VEHICLE_MODEL_HEAVY;
+    fleet.profiles.push_back(heavy);
+    addVehicle(fleet, start, 0.f, MAX_FUEL);
+    AiTraffic traffic;
+    spawnAiTraffic(traffic, fleet, graph, roads, aiDrivers, aiSeed);
+
+    FixedTimestep timestep;
+    Replay fromStart;
+    beginReplay(fromStart, fleet, 0, timestep.tickRate, roads);
+    fromStart.aiDrivers = aiDrivers;
+    fromStart.aiSeed = aiSeed;
+    Replay fromSnapshot;
+    float deltaTime = tickDuration(timestep);
+    for (std::uint64_t tick = 1; tick <= ticks; ++tick) {
+        std::uint8_t controls = scriptedControls(tick);
+        if (tick == resetTick) {
+            resetVehicle(fleet, 0, start, 0.f, MAX_FUEL);
+            recordReplayReset(fromStart, tick);
+            recordReplayReset(fromSnapshot, tick);
+            controls = 0;
+        }
+        driveAiTraffic(traffic, fleet, tick);
+        fleet.controls[0] = controls;
+        recordReplayTick(fromStart, tick, controls);
+        if (tick > snapshotTick)
+            recordReplayTick(fromSnapshot, tick, controls);
+        stepFleet(fleet, deltaTime, roads);
+        timestep.tick = tick;
+
+        if (tick == snapshotTick) {
+            // As a quick save and load in the window: the AI plans start over from the restored fleet
+            std::vector<char> snapshot;
+            takeSnapshot(snapshot, fleet, timestep);
+            restoreSnapshot(snapshot, fleet, timestep);
+            resetAiTraffic(traffic);
+            fromSnapshot = fromStart;
+            continueReplayFrom(fromSnapshot, snapshot, tick);
+        }
+    }
+    endReplay(fromStart, fleet, 0, ticks);
+    endReplay(fromSnapshot, fleet, 0, ticks);
+
+    bool ok = checkRoundTrip(fromStart, roads, graph, "replay from the start");
+    ok = checkRoundTrip(fromSnapshot, roads, graph, "replay from a snapshot") && ok;
+    return ok ? 0 : 1;
+}
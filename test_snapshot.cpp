@@ -0,0 +1,78 @@
+#include <cstring>
+#include <iostream>
+#include "snapshot.h"
+
+// Offsets of the counts in the snapshot header: after the magic and version, and after the
+// vehicle count, tick, tick rate and accumulator
+static const size_t VEHICLE_COUNT_OFFSET = 8;
+static const size_t KEY_COUNT_OFFSET = 32;
+
+static bool check(bool ok, const char* name) {
+    std::cout << (ok ? "PASS" : "FAIL") << ": " << name << std::endl;
+    return ok;
+}
+
+// Take a snapshot of a small fleet and session, restore it, and check that bad blobs are refused
+int main()
+{
+    Fleet fleet;
+    VehicleProfile heavy;
+    heavy.name = "truck";
+    heavy.model = VEHICLE_MODEL_HEAVY;
+    fleet.profiles.push_back(heavy);
+    for (size_t i = 0; i < 6; ++i) {
+        size_t vehicle = addVehicle(fleet, sf::Vector2f(30.f * i, 40.f), 15.f * i, 50.f + i, i % 2);
+        fleet.speed[vehicle] = 2.5f * i;
+        fleet.mileage[vehicle] = 1000.0 * i + 0.25;
+        fleet.controls[vehicle] = static_cast<std::uint8_t>(i);
+    }
+    FixedTimestep timestep;
+    timestep.tick = 12345;
+    timestep.accumulator = 0.004f;
+    SessionState session;
+    session.keyCooldowns = { { 3, 7u }, { 5, 120u } };
+    session.song = 2;
+    session.songOffset = 31.5f;
+
+    std::vector<char> blob;
+    takeSnapshot(blob, fleet, timestep, &session);
+    buildSpatialHash(fleet.neighbours, fleet.positionX.data(), fleet.positionY.data(), fleetSize(fleet));
+
+    // A restored fleet snapshots to the same bytes, and finds the same neighbours as after a tick
+    Fleet restored;
+    restored.profiles = fleet.profiles;
+    FixedTimestep restoredTimestep;
+    SessionState restoredSession;
+    std::vector<char> again;
+    bool ok = restoreSnapshot(blob, restored, restoredTimestep, &restoredSession);
+    if (ok)
+        takeSnapshot(again, restored, restoredTimestep, &restoredSession);
+    bool passed = check(ok && again == blob && restoredTimestep.tick == timestep.tick
+        && restoredSession.keyCooldowns == session.keyCooldowns && restoredSession.song == session.song
+        && restoredSession.songOffset == session.songOffset && restored.neighbours.entries == fleet.neighbours.entries
+        && restored.neighbours.bucketStart == fleet.neighbours.bucketStart, "snapshot round trip");
+
+    // Profile indices mean nothing with a different table
+    Fleet otherTable;
+    passed = check(!restoreSnapshot(blob, otherTable, restoredTimestep) && fleetSize(otherTable) == 0,
+        "different profile table refused") && passed;
+
+    // Counts that only match the blob size once the size arithmetic wraps around
+    std::vector<char> corrupt = blob;
+    std::uint64_t vehicles = 0;
+    std::memcpy(&vehicles, corrupt.data() + VEHICLE_COUNT_OFFSET, sizeof(vehicles));
+    vehicles += 1ull << 63;
+    std::memcpy(corrupt.data() + VEHICLE_COUNT_OFFSET, &vehicles, sizeof(vehicles));
+    passed = check(!restoreSnapshot(corrupt, restored, restoredTimestep), "wrapped vehicle count refused") && passed;
+
+    corrupt = blob;
+    std::uint32_t keys = 0;
+    std::memcpy(&keys, corrupt.data() + KEY_COUNT_OFFSET, sizeof(keys));
+    keys += 1u << 29;
+    std::memcpy(corrupt.data() + KEY_COUNT_OFFSET, &keys, sizeof(keys));
+    passed = check(!restoreSnapshot(corrupt, restored, restoredTimestep), "oversized key count refused") && passed;
+
+    corrupt.assign(blob.begin(), blob.end() - 1);
+    passed = check(!restoreSnapshot(corrupt, restored, restoredTimestep), "truncated snapshot refused") && passed;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+#include <cstdio>
+#include <iostream>
+#include "telemetry.h"
+
+// Record a small fleet for a few ticks through the ring and writer thread, and read it back
+int main()
+{
+    const char* path = "test_telemetry.bin";
+    const size_t vehicles = 5;
+    const std::uint64_t ticks = 1000;  // More samples than one chunk
+
+    Fleet fleet;
+    for (size_t i = 0; i < vehicles; ++i)
+        addVehicle(fleet, sf::Vector2f(10.f * i, 20.f), 0.f, 100.f + i);
+
+    TelemetryRecorder recorder;
+    recorder.lossless = true;
+    if (!startTelemetry(recorder, path))
+        return 1;
+    for (std::uint64_t tick = 1; tick <= ticks; ++tick) {
+        for (size_t i = 0; i < vehicles; ++i)
+            fleet.mileage[i] = static_cast<double>(tick * vehicles + i);
+        recordTelemetry(recorder, fleet, tick);
+    }
+    stopTelemetry(recorder);
+
+    std::vector<TelemetrySample> samples;
+    bool ok = loadTelemetry(path, samples) && samples.size() == ticks * vehicles;
+    for (size_t i = 0; ok && i < samples.size(); ++i) {
+        const TelemetrySample& sample = samples[i];
+        ok = sample.tick == i / vehicles + 1 && sample.vehicle == i % vehicles
+            && sample.mileage == static_cast<double>(sample.tick * vehicles + sample.vehicle)
+            && sample.fuel == 100.f + sample.vehicle && sample.positionX == 10.f * sample.vehicle;
+    }
+    std::remove(path);
+
+    std::cout << (ok ? "PASS" : "FAIL") << ": " << samples.size() << " telemetry samples read back" << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+// Own deque first (newest task, still warm in cache), then the oldest task of the others
+static bool takeTask(ThreadPool& pool, size_t self, std::function<void()>& task) {
+    size_t count = pool.workers.size();
+    for (size_t offset = 0; offset < count; ++offset) {
+        ThreadPool::Worker& worker = *pool.workers[(self + offset) % count];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.tasks.empty())
+            continue;
+
+        if (offset == 0) {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        }
+        else {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+        }
+        --pool.queued;
+        return true;
+    }
+    return false;
+}
+
+static void finishTask(ThreadPool& pool) {
+    if (--pool.unfinished == 0) {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.idle.notify_all();
+    }
+}
+
+static void runWorker(ThreadPool* pool, size_t self) {
+    std::function<void()> task;
+    for (;;) {
+        if (takeTask(*pool, self, task)) {
+            task();
+            task = nullptr;
+            finishTask(*pool);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(pool->mutex);
+        pool->wake.wait(lock, [pool]() { return pool->stopping || pool->queued > 0; });
+        if (pool->stopping && pool->queued == 0)
+            return;
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    stopThreadPool(*this);
+}
+
+void startThreadPool(ThreadPool& pool, size_t threads) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    pool.stopping = false;
+    for (size_t i = 0; i < threads; ++i)
+        pool.workers.emplace_back(new ThreadPool::Worker());
+    for (size_t i = 0; i < threads; ++i)
+        pool.threads.emplace_back(runWorker, &pool, i);
+}
+
+void submitTask(ThreadPool& pool, std::function<void()> task) {
+    ++pool.unfinished;
+    {
+        // Counted before it is pushed so a worker that takes it early never underflows `queued`
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        ++pool.queued;
+    }
+    ThreadPool::Worker& worker = *pool.workers[pool.nextWorker++ % pool.workers.size()];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+    pool.wake.notify_one();
+}
+
+void waitThreadPool(ThreadPool& pool) {
+    // The waiting thread steals work too instead of sitting idle
+    std::function<void()> task;
+    while (pool.unfinished > 0) {
+        if (takeTask(pool, 0, task)) {
+            task();
+            task = nullptr;
+            finishTask(pool);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(pool.mutex);
+        pool.idle.wait(lock, [&pool]() { return pool.unfinished == 0 || pool.queued > 0; });
+    }
+}
+
+void stopThreadPool(ThreadPool& pool) {
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.stopping = true;
+    }
+    pool.wake.notify_all();
+    for (std::thread& thread : pool.threads)
+        thread.join();
+    pool.threads.clear();
+    pool.workers.clear();
+}
+
+size_t threadPoolSize(const ThreadPool& pool) {
+    return pool.threads.size();
+}
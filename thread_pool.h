@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads that each own a deque of tasks. A worker runs tasks from the back of its own
+// deque and, once that is empty, steals from the front of another worker's. Tasks of very
+// different length therefore balance themselves without every task contending on one queue.
+struct ThreadPool {
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    size_t nextWorker = 0;                 // Round-robin target for submitTask
+
+    std::mutex mutex;
+    std::condition_variable wake;          // Tasks were queued or the pool is stopping
+    std::condition_variable idle;          // The last unfinished task completed
+    std::atomic<size_t> queued{ 0 };       // Tasks waiting in any deque
+    std::atomic<size_t> unfinished{ 0 };   // Tasks queued or running
+    bool stopping = false;
+
+    ~ThreadPool();
+};
+
+// Start `threads` workers, or one per core when 0
+void startThreadPool(ThreadPool& pool, size_t threads = 0);
+
+// Queue a task; only call from the thread that owns the pool
+void submitTask(ThreadPool& pool, std::function<void()> task);
+
+// Help run queued tasks until every submitted task has finished
+void waitThreadPool(ThreadPool& pool);
+
+void stopThreadPool(ThreadPool& pool);
+
+size_t threadPoolSize(const ThreadPool& pool);
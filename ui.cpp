@@ -0,0 +1,113 @@
+#include "ui.h"
+#include <iostream>
+
+bool loadUiFont(sf::Font& font, const std::string& fontFile) {
+    if (!font.loadFromFile(fontFile)) {
+        std::cerr << "Error loading font!" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void initLabel(UiLabel& label, const sf::Font& font, unsigned int characterSize, const std::string& content) {
+    label.text.setFont(font);
+    label.text.setCharacterSize(characterSize);
+    label.text.setFillColor(sf::Color::White);
+    label.content = content;
+    label.text.setString(content);
+}
+
+bool setLabelString(UiLabel& label, const std::string& content) {
+    if (label.content == content)
+        return false;
+
+    label.content = content;
+    label.text.setString(content);
+    return true;
+}
+
+void centerLabel(UiLabel& label, float x, float y) {
+    label.text.setPosition(x - label.text.getLocalBounds().width / 2.f, y);
+}
+
+static void layoutButtonLabel(UiButton& button) {
+    const sf::Vector2f& position = button.box.getPosition();
+    const sf::Vector2f& size = button.box.getSize();
+    sf::FloatRect bounds = button.label.text.getLocalBounds();
+
+    if (button.centered)
+        button.label.text.setPosition(position.x + (size.x - bounds.width) / 2.f,
+            position.y + (size.y - bounds.height) / 2.f + button.labelOffsetY);
+    else
+        button.label.text.setPosition(position.x + 10.f, position.y + 10.f + button.labelOffsetY);
+}
+
+UiButton& addButton(UiMenu& menu, const sf::Font& font, int action, const std::string& content, const sf::FloatRect& rect,
+    unsigned int characterSize, bool darkMode) {
+    menu.buttons.emplace_back();
+    UiButton& button = menu.buttons.back();
+    button.action = action;
+
+    button.box.setSize(sf::Vector2f(rect.width, rect.height));
+    button.box.setPosition(rect.left, rect.top);
+    button.box.setFillColor(UI_BUTTON_COLOR);
+    button.box.setOutlineColor(darkMode ? sf::Color::White : sf::Color::Black);
+    button.box.setOutlineThickness(2.f);
+
+    initLabel(button.label, font, characterSize, content);
+    layoutButtonLabel(button);
+    menu.shapesDirty = true;
+    return button;
+}
+
+void setButtonLabel(UiButton& button, const std::string& content) {
+    if (setLabelString(button.label, content))
+        layoutButtonLabel(button);
+}
+
+void addPanel(UiMenu& menu, const sf::RectangleShape& panel) {
+    menu.panels.push_back(panel);
+    menu.shapesDirty = true;
+}
+
+void setMenuOverlay(UiMenu& menu, const sf::Vector2f& size, bool darkMode) {
+    menu.overlay.setSize(size);
+    menu.overlay.setPosition(-size.x / 2.f, -size.y / 2.f);
+    menu.overlay.setFillColor(darkMode ? UI_DARK_OVERLAY : UI_LIGHT_OVERLAY);
+    menu.shapesDirty = true;
+}
+
+static void rebuildMenuShapes(UiMenu& menu) {
+    clearBatch(menu.shapes);
+    if (menu.overlay.getSize().x > 0.f)
+        addRectangleShape(menu.shapes, menu.overlay);
+    for (const sf::RectangleShape& panel : menu.panels)
+        addRectangleShape(menu.shapes, panel);
+    for (const UiButton& button : menu.buttons)
+        addRectangleShape(menu.shapes, button.box);
+    menu.shapesDirty = false;
+}
+
+void drawMenu(sf::RenderTarget& target, UiMenu& menu, const sf::Vector2f& anchor) {
+    if (menu.shapesDirty)
+        rebuildMenuShapes(menu);
+
+    sf::RenderStates states;
+    states.transform.translate(anchor.x, anchor.y);
+
+    // Boxes never overlap another element's label, so they all go first in one call
+    drawBatch(target, menu.shapes, states);
+    for (const UiLabel& label : menu.labels)
+        target.draw(label.text, states);
+    for (const UiButton& button : menu.buttons)
+        target.draw(button.label.text, states);
+}
+
+const UiButton* menuButtonAt(const UiMenu& menu, const sf::Vector2f& anchor, const sf::Vector2f& point) {
+    sf::Vector2f local = point - anchor;
+    for (const UiButton& button : menu.buttons) {
+        if (button.box.getGlobalBounds().contains(local))
+            return &button;
+    }
+    return nullptr;
+}
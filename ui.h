@@ -0,0 +1,69 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include "render_batch.h"
+#include <string>
+#include <vector>
+
+// Menu colors shared by every panel
+const sf::Color UI_BUTTON_COLOR(100, 100, 200);
+const sf::Color UI_DARK_OVERLAY(0, 0, 0, 150);
+const sf::Color UI_LIGHT_OVERLAY(175, 175, 175, 150);
+
+// Text whose layout is only rebuilt when its string actually changes
+struct UiLabel {
+    sf::Text text;
+    std::string content;
+};
+
+// Action of a button that does nothing when clicked
+const int UI_NO_ACTION = -1;
+
+// A clickable box with a label; `action` identifies the button when it is clicked, so a click
+// is dispatched with a switch rather than by comparing label strings
+struct UiButton {
+    sf::RectangleShape box;
+    UiLabel label;
+    int action = UI_NO_ACTION;
+    bool centered = true;   // Keep the label centered on the box when its string changes
+    float labelOffsetY = 0.f;
+};
+
+// Retained-mode menu. Everything is laid out once in menu-local coordinates and drawn
+// with a translation to wherever the menu is anchored this frame, so following the
+// camera costs nothing and only labels whose string changed are laid out again.
+// All boxes are baked into one untextured batch, so the shapes of a menu are one draw call.
+struct UiMenu {
+    sf::RectangleShape overlay;
+    std::vector<sf::RectangleShape> panels;
+    std::vector<UiLabel> labels;
+    std::vector<UiButton> buttons;
+    QuadBatch shapes;
+    bool shapesDirty = true;  // Set when a box is added; the batch is rebuilt on the next draw
+};
+
+// The UI font is parsed once at startup; its glyph pages are shared by every label
+bool loadUiFont(sf::Font& font, const std::string& fontFile);
+
+void initLabel(UiLabel& label, const sf::Font& font, unsigned int characterSize, const std::string& content);
+
+// Returns true if the string changed and the label was laid out again
+bool setLabelString(UiLabel& label, const std::string& content);
+
+// Place the label so it is horizontally centered on x
+void centerLabel(UiLabel& label, float x, float y);
+
+UiButton& addButton(UiMenu& menu, const sf::Font& font, int action, const std::string& content, const sf::FloatRect& rect,
+    unsigned int characterSize, bool darkMode);
+
+// Change the text shown on a button without changing its action
+void setButtonLabel(UiButton& button, const std::string& content);
+
+void addPanel(UiMenu& menu, const sf::RectangleShape& panel);
+
+// Semi-transparent backdrop covering a view-sized area centered on the menu anchor
+void setMenuOverlay(UiMenu& menu, const sf::Vector2f& size, bool darkMode);
+
+void drawMenu(sf::RenderTarget& target, UiMenu& menu, const sf::Vector2f& anchor);
+
+// Button under a world-space point for a menu drawn at `anchor`, or nullptr
+const UiButton* menuButtonAt(const UiMenu& menu, const sf::Vector2f& anchor, const sf::Vector2f& point);
@@ -0,0 +1,116 @@
+#include "vehicle_profiles.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static const char* const MODEL_NAMES[VEHICLE_MODEL_COUNT] = { "car", "heavy" };
+
+bool parseVehicleModel(const std::string& name, VehicleModel& model) {
+    for (int i = 0; i < VEHICLE_MODEL_COUNT; ++i) {
+        if (name == MODEL_NAMES[i]) {
+            model = static_cast<VehicleModel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* vehicleModelName(VehicleModel model) {
+    return model < VEHICLE_MODEL_COUNT ? MODEL_NAMES[model] : "unknown";
+}
+
+std::uint64_t vehicleProfilesHash(const std::vector<VehicleProfile>& profiles) {
+    // 64-bit FNV-1a, as for the road grid
+    std::uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    for (const VehicleProfile& profile : profiles) {
+        // The name with its terminator, so "ab" + "c" differs from "a" + "bc"
+        mix(profile.name.c_str(), profile.name.size() + 1);
+        mix(&profile.model, sizeof(profile.model));
+        const float values[] = { profile.tuning.maxSpeed, profile.tuning.acceleration, profile.tuning.friction,
+            profile.tuning.drag, profile.tuning.turnRate, profile.tuning.minTurnSpeed, profile.tuning.understeer };
+        mix(values, sizeof(values));
+    }
+    return hash;
+}
+
+int findVehicleProfile(const std::vector<VehicleProfile>& profiles, const std::string& name) {
+    for (size_t i = 0; i < profiles.size(); ++i) {
+        if (profiles[i].name == name)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+bool loadVehicleProfiles(const std::string& path, std::vector<VehicleProfile>& profiles) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Error opening vehicle profiles: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<VehicleProfile> loaded;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        std::string::size_type comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        std::istringstream in(line);
+        std::string directive;
+        if (!(in >> directive))
+            continue;
+
+        bool ok = true;
+        if (directive == "profile") {
+            VehicleProfile profile;
+            std::string model;
+            ok = (in >> profile.name >> model) && parseVehicleModel(model, profile.model)
+                && findVehicleProfile(loaded, profile.name) < 0 && loaded.size() < MAX_VEHICLE_PROFILES;
+            if (ok)
+                loaded.push_back(profile);
+        }
+        else if (loaded.empty()) {
+            ok = false;  // Handling before the first profile line
+        }
+        else {
+            CarTuning& tuning = loaded.back().tuning;
+            if (directive == "maxspeed")
+                ok = static_cast<bool>(in >> tuning.maxSpeed) && tuning.maxSpeed > 0;
+            else if (directive == "acceleration")
+                ok = static_cast<bool>(in >> tuning.acceleration);
+            else if (directive == "friction")
+                ok = static_cast<bool>(in >> tuning.friction);
+            else if (directive == "drag")
+                ok = static_cast<bool>(in >> tuning.drag) && tuning.drag >= 0;
+            else if (directive == "turnrate")
+                ok = static_cast<bool>(in >> tuning.turnRate);
+            else if (directive == "minturnspeed")
+                ok = static_cast<bool>(in >> tuning.minTurnSpeed);
+            else if (directive == "understeer")
+                ok = static_cast<bool>(in >> tuning.understeer) && tuning.understeer >= 0 && tuning.understeer <= 1;
+            else
+                ok = false;
+        }
+
+        if (!ok) {
+            std::cerr << path << ":" << lineNumber << ": invalid vehicle profile line" << std::endl;
+            return false;
+        }
+    }
+
+    if (loaded.empty()) {
+        std::cerr << path << ": no vehicle profiles" << std::endl;
+        return false;
+    }
+    profiles = loaded;
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "car.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+const size_t MAX_VEHICLE_PROFILES = 256;  // Fleet::profile holds one byte per vehicle
+
+// The shape of a profile's physics. The batch kernels are instantiated once per model, so the
+// model is chosen per run of vehicles rather than per vehicle (see Fleet::profileRuns).
+enum VehicleModel : std::uint8_t {
+    VEHICLE_MODEL_CAR,    // Drag proportional to speed, turning proportional to speed
+    VEHICLE_MODEL_HEAVY,  // Drag grows with the square of speed, and turning falls off at speed (understeer)
+    VEHICLE_MODEL_COUNT
+};
+
+// A kind of vehicle: a physics model plus the coefficients it drives with
+struct VehicleProfile {
+    std::string name = "car";
+    VehicleModel model = VEHICLE_MODEL_CAR;
+    CarTuning tuning;
+};
+
+// Parse a profile file. Each line is one directive, '#' starts a comment:
+//   profile <name> <car|heavy>   starts a profile; the lines below set its handling
+//   maxspeed <value>             acceleration <value>       friction <value>
+//   drag <value>                 turnrate <degrees per second>
+//   minturnspeed <value>         understeer <0..1>
+// Unset values keep the built-in car's. On success `profiles` is replaced by the file's
+// profiles in order; on failure it is left untouched.
+bool loadVehicleProfiles(const std::string& path, std::vector<VehicleProfile>& profiles);
+
+// Hash of every profile's name, model and tuning, in order. Equal hashes mean the tables give the
+// same vehicles for the same profile indices.
+std::uint64_t vehicleProfilesHash(const std::vector<VehicleProfile>& profiles);
+
+// Index of the profile called `name`, or -1
+int findVehicleProfile(const std::vector<VehicleProfile>& profiles, const std::string& name);
+
+// "car" or "heavy"
+const char* vehicleModelName(VehicleModel model);
+bool parseVehicleModel(const std::string& name, VehicleModel& model);
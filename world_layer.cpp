@@ -0,0 +1,38 @@
+#include "world_layer.h"
+#include <iostream>
+
+bool sameWorldLayer(const WorldLayerKey& a, const WorldLayerKey& b) {
+    return a.frame == b.frame && a.alpha == b.alpha && a.viewCenter == b.viewCenter
+        && a.viewSize == b.viewSize && a.layers == b.layers;
+}
+
+sf::RenderTarget* beginWorldLayer(WorldLayerCache& cache, const sf::Vector2u& size, const sf::View& view, const WorldLayerKey& key) {
+    cache.valid = false;
+    if (cache.unsupported)
+        return nullptr;
+
+    if (cache.texture.getSize() != size) {
+        if (!cache.texture.create(size.x, size.y)) {
+            std::cerr << "Can't cache the world layer; paused frames will draw it every time" << std::endl;
+            cache.unsupported = true;
+            return nullptr;
+        }
+        // The sprite keeps the texture's old size until it is told again
+        cache.sprite.setTexture(cache.texture.getTexture(), true);
+    }
+    cache.texture.setView(view);
+    cache.key = key;
+    return &cache.texture;
+}
+
+void endWorldLayer(WorldLayerCache& cache) {
+    cache.texture.display();
+    cache.valid = true;
+}
+
+void drawWorldLayer(sf::RenderTarget& target, const WorldLayerCache& cache) {
+    sf::View view = target.getView();
+    target.setView(target.getDefaultView());
+    target.draw(cache.sprite);
+    target.setView(view);
+}
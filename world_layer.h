@@ -0,0 +1,43 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+
+// Everything the world layer (map tiles, vehicles, stats panel and minimap) is drawn from,
+// apart from tile uploads, which the caller reports by invalidating the cache
+struct WorldLayerKey {
+    std::uint64_t frame = 0;    // RenderFrame::sequence of the vehicle state drawn
+    float alpha = 0.f;          // Interpolation past that frame's last tick
+    sf::Vector2f viewCenter;
+    sf::Vector2f viewSize;
+    std::uint32_t layers = 0;   // Which optional layers are shown, as bits chosen by the caller
+};
+
+// The world layer of a paused game in a window-sized render texture. While its key stays the
+// same, a frame only draws this one quad and the UI on top instead of the whole world.
+struct WorldLayerCache {
+    sf::RenderTexture texture;
+    sf::Sprite sprite;
+    WorldLayerKey key;
+    bool valid = false;
+    bool unsupported = false;   // The render texture could not be created; always draw directly
+};
+
+bool sameWorldLayer(const WorldLayerKey& a, const WorldLayerKey& b);
+
+inline bool worldLayerCurrent(const WorldLayerCache& cache, const WorldLayerKey& key) {
+    return cache.valid && sameWorldLayer(cache.key, key);
+}
+
+inline void invalidateWorldLayer(WorldLayerCache& cache) {
+    cache.valid = false;
+}
+
+// Start drawing the layer for `key`: returns the render texture, set to `view`, or nullptr if
+// there is none and the world has to be drawn to the window as usual
+sf::RenderTarget* beginWorldLayer(WorldLayerCache& cache, const sf::Vector2u& size, const sf::View& view, const WorldLayerKey& key);
+
+// Finish the layer started by beginWorldLayer; it is current from now on
+void endWorldLayer(WorldLayerCache& cache);
+
+// Draw the cached layer over the whole target, whatever view the target has
+void drawWorldLayer(sf::RenderTarget& target, const WorldLayerCache& cache);
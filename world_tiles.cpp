@@ -0,0 +1,241 @@
+#include "world_tiles.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+
+unsigned int tilesAcross(const WorldTiles& world) {
+    return (world.width + world.tileSize - 1) / world.tileSize;
+}
+
+unsigned int tilesDown(const WorldTiles& world) {
+    return (world.height + world.tileSize - 1) / world.tileSize;
+}
+
+std::string tileFile(const WorldTiles& world, const std::string& layer, unsigned int x, unsigned int y) {
+    return world.prefix + "_" + layer + "_" + std::to_string(x) + "_" + std::to_string(y) + ".png";
+}
+
+sf::IntRect tileRect(const WorldTiles& world, unsigned int x, unsigned int y) {
+    unsigned int left = x * world.tileSize;
+    unsigned int top = y * world.tileSize;
+    return sf::IntRect(left, top, std::min(world.tileSize, world.width - left), std::min(world.tileSize, world.height - top));
+}
+
+sf::IntRect tilesOverlapping(const WorldTiles& world, const sf::FloatRect& area) {
+    auto clampTile = [](float pixel, unsigned int tileSize, unsigned int count) {
+        int tile = static_cast<int>(pixel) / static_cast<int>(tileSize);
+        return std::max(0, std::min(tile, static_cast<int>(count)));
+    };
+
+    int firstX = clampTile(area.left, world.tileSize, tilesAcross(world));
+    int firstY = clampTile(area.top, world.tileSize, tilesDown(world));
+    int lastX = clampTile(area.left + area.width + world.tileSize, world.tileSize, tilesAcross(world));
+    int lastY = clampTile(area.top + area.height + world.tileSize, world.tileSize, tilesDown(world));
+    return sf::IntRect(firstX, firstY, lastX - firstX, lastY - firstY);
+}
+
+bool loadWorldTiles(WorldTiles& world, const std::string& prefix) {
+    std::ifstream file(prefix + ".tiles");
+    if (!file)
+        return false;
+
+    world.prefix = prefix;
+    file >> world.width >> world.height >> world.tileSize;
+    return file && world.width > 0 && world.height > 0 && world.tileSize > 0;
+}
+
+bool saveWorldTiles(const WorldTiles& world) {
+    std::ofstream manifest(world.prefix + ".tiles");
+    manifest << world.width << " " << world.height << " " << world.tileSize << "\n";
+    return static_cast<bool>(manifest);
+}
+
+bool splitWorldImage(WorldTiles& world, const std::string& imageFile, const std::string& layer) {
+    sf::Image image;
+    if (!image.loadFromFile(imageFile)) {
+        std::cerr << "Error loading " << imageFile << std::endl;
+        return false;
+    }
+
+    if (world.width == 0 || world.height == 0) {
+        world.width = image.getSize().x;
+        world.height = image.getSize().y;
+    }
+
+    for (unsigned int y = 0; y < tilesDown(world); ++y) {
+        for (unsigned int x = 0; x < tilesAcross(world); ++x) {
+            sf::IntRect rect = tileRect(world, x, y);
+            sf::Image tile;
+            tile.create(rect.width, rect.height);
+            tile.copy(image, 0, 0, rect);
+            if (!tile.saveToFile(tileFile(world, layer, x, y)))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool buildWorldTiles(WorldTiles& world, const std::string& prefix, const std::string& mapFile, const std::string& maskFile) {
+    world = WorldTiles();
+    world.prefix = prefix;
+
+    // The cached minimap overview was drawn from the old tiles and only its size is checked
+    // when loading, so it has to go before any tile changes
+    std::remove((prefix + "_overview.png").c_str());
+    return splitWorldImage(world, mapFile, "map") && splitWorldImage(world, maskFile, "mask") && saveWorldTiles(world);
+}
+
+static void loaderThread(TileStreamer* streamer) {
+    unsigned int tilesX = tilesAcross(streamer->world);
+    for (;;) {
+        unsigned int index;
+        {
+            std::unique_lock<std::mutex> lock(streamer->mutex);
+            streamer->wake.wait(lock, [streamer] { return streamer->stopping || !streamer->requests.empty(); });
+            if (streamer->stopping)
+                return;
+            index = streamer->requests.front();
+            streamer->requests.pop_front();
+            streamer->loading.push_back(index);
+        }
+
+        // Decoding is the slow part and needs no GL context, so it stays off the render thread
+        sf::Image image;
+        if (!image.loadFromFile(tileFile(streamer->world, streamer->layer, index % tilesX, index / tilesX)))
+            std::cerr << "Error loading map tile " << index % tilesX << ", " << index / tilesX << std::endl;
+
+        std::lock_guard<std::mutex> lock(streamer->mutex);
+        streamer->loading.erase(std::find(streamer->loading.begin(), streamer->loading.end(), index));
+        streamer->finished.emplace_back(index, std::move(image));
+    }
+}
+
+TileStreamer::~TileStreamer() {
+    stopTileStreamer(*this);
+}
+
+void startTileStreamer(TileStreamer& streamer, const WorldTiles& world, const std::string& layer) {
+    stopTileStreamer(streamer);
+    streamer.world = world;
+    streamer.layer = layer;
+    streamer.stopping = false;
+    streamer.loader = std::thread(loaderThread, &streamer);
+}
+
+void stopTileStreamer(TileStreamer& streamer) {
+    if (!streamer.loader.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(streamer.mutex);
+        streamer.stopping = true;
+        streamer.requests.clear();
+    }
+    streamer.wake.notify_all();
+    streamer.loader.join();
+}
+
+static sf::FloatRect viewArea(const sf::View& view) {
+    return sf::FloatRect(view.getCenter().x - view.getSize().x / 2, view.getCenter().y - view.getSize().y / 2,
+        view.getSize().x, view.getSize().y);
+}
+
+bool updateTileStreamer(TileStreamer& streamer, const sf::View& view) {
+    const WorldTiles& world = streamer.world;
+    unsigned int tilesX = tilesAcross(world);
+
+    // Prefetch one tile beyond the view in every direction
+    sf::FloatRect area = viewArea(view);
+    sf::FloatRect prefetch(area.left - world.tileSize, area.top - world.tileSize,
+        area.width + 2.f * world.tileSize, area.height + 2.f * world.tileSize);
+    sf::IntRect range = tilesOverlapping(world, prefetch);
+
+    std::vector<std::pair<float, unsigned int>> missing;
+    for (int y = range.top; y < range.top + range.height; ++y) {
+        for (int x = range.left; x < range.left + range.width; ++x) {
+            unsigned int index = y * tilesX + x;
+            auto tile = streamer.resident.find(index);
+            if (tile != streamer.resident.end()) {
+                streamer.lru.splice(streamer.lru.begin(), streamer.lru, tile->second.lruPosition);
+                continue;
+            }
+
+            float dx = (x + 0.5f) * world.tileSize - view.getCenter().x;
+            float dy = (y + 0.5f) * world.tileSize - view.getCenter().y;
+            missing.emplace_back(dx * dx + dy * dy, index);
+        }
+    }
+    std::sort(missing.begin(), missing.end());
+
+    std::vector<std::pair<unsigned int, sf::Image>> finished;
+    {
+        // Replace the queue rather than appending, so tiles the view has already left are never loaded
+        std::lock_guard<std::mutex> lock(streamer.mutex);
+        streamer.requests.clear();
+        for (const auto& tile : missing) {
+            unsigned int index = tile.second;
+            bool inFlight = std::find(streamer.loading.begin(), streamer.loading.end(), index) != streamer.loading.end();
+            bool decoded = std::any_of(streamer.finished.begin(), streamer.finished.end(),
+                [index](const std::pair<unsigned int, sf::Image>& image) { return image.first == index; });
+            if (!inFlight && !decoded)
+                streamer.requests.push_back(index);
+        }
+
+        size_t uploads = std::min(streamer.finished.size(), static_cast<size_t>(WORLD_TILE_UPLOADS_PER_FRAME));
+        std::move(streamer.finished.begin(), streamer.finished.begin() + uploads, std::back_inserter(finished));
+        streamer.finished.erase(streamer.finished.begin(), streamer.finished.begin() + uploads);
+    }
+    streamer.wake.notify_one();
+
+    bool uploaded = false;
+    for (auto& image : finished) {
+        if (streamer.resident.count(image.first))
+            continue;
+
+        TileStreamer::Tile& tile = streamer.resident[image.first];
+        tile.texture.loadFromImage(image.second);
+        streamer.lru.push_front(image.first);
+        tile.lruPosition = streamer.lru.begin();
+        uploaded = true;
+    }
+
+    // Tiles around the view were just moved to the front, so eviction only drops ones out of sight
+    size_t keep = std::max(streamer.budget, static_cast<size_t>(range.width) * range.height);
+    while (streamer.resident.size() > keep) {
+        streamer.resident.erase(streamer.lru.back());
+        streamer.lru.pop_back();
+    }
+    return uploaded;
+}
+
+void drawWorldTiles(sf::RenderTarget& target, const TileStreamer& streamer, const sf::View& view,
+    const sf::Texture* placeholder, float placeholderScale) {
+    const WorldTiles& world = streamer.world;
+    unsigned int tilesX = tilesAcross(world);
+    sf::IntRect range = tilesOverlapping(world, viewArea(view));
+
+    sf::Sprite sprite;
+    for (int y = range.top; y < range.top + range.height; ++y) {
+        for (int x = range.left; x < range.left + range.width; ++x) {
+            sf::IntRect rect = tileRect(world, x, y);
+            auto tile = streamer.resident.find(y * tilesX + x);
+            if (tile != streamer.resident.end()) {
+                sprite.setTexture(tile->second.texture, true);
+                sprite.setScale(1.f, 1.f);
+            }
+            else if (placeholder) {
+                sprite.setTexture(*placeholder);
+                sprite.setTextureRect(sf::IntRect(static_cast<int>(rect.left * placeholderScale), static_cast<int>(rect.top * placeholderScale),
+                    static_cast<int>(rect.width * placeholderScale), static_cast<int>(rect.height * placeholderScale)));
+                sprite.setScale(1.f / placeholderScale, 1.f / placeholderScale);
+            }
+            else {
+                continue;
+            }
+            sprite.setPosition(static_cast<float>(rect.left), static_cast<float>(rect.top));
+            target.draw(sprite);
+        }
+    }
+}
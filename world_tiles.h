@@ -0,0 +1,87 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+const unsigned int WORLD_TILE_SIZE = 512;   // Pixels per tile side
+const size_t WORLD_TILE_BUDGET = 48;        // Map tiles kept on the GPU (~48 MB at 512x512 RGBA)
+const int WORLD_TILE_UPLOADS_PER_FRAME = 4; // Decoded tiles turned into textures per frame
+
+// The world map and road mask cut into fixed-size tiles. `<prefix>.tiles` holds the size of
+// the world; tile (x, y) of each layer is stored in `<prefix>_<layer>_<x>_<y>.png`.
+struct WorldTiles {
+    std::string prefix;
+    unsigned int width = 0;       // World size in pixels
+    unsigned int height = 0;
+    unsigned int tileSize = WORLD_TILE_SIZE;
+};
+
+unsigned int tilesAcross(const WorldTiles& world);
+unsigned int tilesDown(const WorldTiles& world);
+std::string tileFile(const WorldTiles& world, const std::string& layer, unsigned int x, unsigned int y);
+
+// Pixel rectangle of tile (x, y); tiles on the right and bottom edge may be smaller
+sf::IntRect tileRect(const WorldTiles& world, unsigned int x, unsigned int y);
+
+// Range of tiles overlapping a world-space rectangle, as [first, last) in each axis
+sf::IntRect tilesOverlapping(const WorldTiles& world, const sf::FloatRect& area);
+
+bool loadWorldTiles(WorldTiles& world, const std::string& prefix);
+
+bool saveWorldTiles(const WorldTiles& world);
+
+// One-time conversion of an image into `<prefix>_<layer>_*.png` tiles. The first image split
+// sets the world size. The image is only held in memory during the split.
+bool splitWorldImage(WorldTiles& world, const std::string& imageFile, const std::string& layer);
+
+// Split the map ("map" layer) and road mask ("mask" layer) and write the manifest last, so a
+// partial conversion is never mistaken for a complete one. Deletes the `<prefix>_overview.png`
+// minimap cache, which would otherwise still show the old map.
+bool buildWorldTiles(WorldTiles& world, const std::string& prefix, const std::string& mapFile, const std::string& maskFile);
+
+// Streams map tiles around the view. A background thread decodes tile images from disk;
+// the render thread only uploads finished images (a few per frame) and evicts the least
+// recently used tiles beyond the budget, so neither startup nor scrolling stalls.
+struct TileStreamer {
+    WorldTiles world;
+    std::string layer = "map";
+    size_t budget = WORLD_TILE_BUDGET;
+
+    // Render-thread state: resident textures with their position in the LRU list (front = newest)
+    struct Tile {
+        sf::Texture texture;
+        std::list<unsigned int>::iterator lruPosition;
+    };
+    std::map<unsigned int, Tile> resident;
+    std::list<unsigned int> lru;
+
+    // Shared with the loader thread
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<unsigned int> requests;                          // Nearest to the view first
+    std::vector<unsigned int> loading;                          // Taken by the loader, not finished
+    std::vector<std::pair<unsigned int, sf::Image>> finished;   // Decoded, waiting for upload
+    bool stopping = false;
+    std::thread loader;
+
+    ~TileStreamer();
+};
+
+void startTileStreamer(TileStreamer& streamer, const WorldTiles& world, const std::string& layer);
+void stopTileStreamer(TileStreamer& streamer);
+
+// Queue the tiles around the view, upload finished ones and evict beyond the budget.
+// Returns true if a tile was uploaded, i.e. the drawn map may look different.
+bool updateTileStreamer(TileStreamer& streamer, const sf::View& view);
+
+// Draw resident tiles inside the view. Missing tiles are filled from `placeholder`, a copy
+// of the whole map at `placeholderScale` (the enlarged minimap), until they arrive.
+void drawWorldTiles(sf::RenderTarget& target, const TileStreamer& streamer, const sf::View& view,
+    const sf::Texture* placeholder, float placeholderScale);